@@ -1,14 +1,99 @@
+#include <nrf.h>
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "battery.h"
 
 #include "saadc.h"
 
+#define BATTERY_AVERAGE_COUNT   (4U)                    ///< Number of oversampled conversions averaged, power of 2
+#define BATTERY_MAX_VALUE       (4095 * 3000 / 3600)    ///< 12bit value of a full battery (3V), with a 3.6V full scale
+
+typedef struct {
+    volatile int16_t    sample;                         ///< Written by EasyDMA
+    bool                pending;                        ///< A conversion is running
+    bool                initialized;                    ///< At least one conversion was collected
+    uint16_t            values[BATTERY_AVERAGE_COUNT];  ///< Latest conversions
+    uint32_t            sum;                            ///< Sum of the latest conversions
+    uint8_t             index;                          ///< Index of the oldest conversion
+    uint8_t             level;                          ///< Cached battery level in %
+} battery_vars_t;
+
+static battery_vars_t _battery_vars = { 0 };
+
+static void _start_conversion(void) {
+    // The SAADC is shared with swarmit_saadc_read, configure it for each conversion
+    NRF_SAADC_S->RESOLUTION     = SAADC_RESOLUTION_VAL_12bit << SAADC_RESOLUTION_VAL_Pos;
+    NRF_SAADC_S->OVERSAMPLE     = SAADC_OVERSAMPLE_OVERSAMPLE_Over16x << SAADC_OVERSAMPLE_OVERSAMPLE_Pos;
+    NRF_SAADC_S->CH[0].PSELP    = ROBOT_BATTERY_LEVEL_PIN << SAADC_CH_PSELP_PSELP_Pos;
+    NRF_SAADC_S->CH[0].PSELN    = SAADC_CH_PSELN_PSELN_NC << SAADC_CH_PSELN_PSELN_Pos;
+    // Burst mode averages the 16 samples in hardware on a single sample task
+    NRF_SAADC_S->CH[0].CONFIG   = (SAADC_CH_CONFIG_GAIN_Gain1_6 << SAADC_CH_CONFIG_GAIN_Pos) |
+                                  (SAADC_CH_CONFIG_REFSEL_Internal << SAADC_CH_CONFIG_REFSEL_Pos) |
+                                  (SAADC_CH_CONFIG_TACQ_10us << SAADC_CH_CONFIG_TACQ_Pos) |
+                                  (SAADC_CH_CONFIG_BURST_Enabled << SAADC_CH_CONFIG_BURST_Pos);
+    NRF_SAADC_S->RESULT.PTR     = (uint32_t)&_battery_vars.sample;
+    NRF_SAADC_S->RESULT.MAXCNT  = 1;
+    NRF_SAADC_S->ENABLE         = SAADC_ENABLE_ENABLE_Enabled << SAADC_ENABLE_ENABLE_Pos;
+
+    NRF_SAADC_S->EVENTS_STARTED = 0;
+    NRF_SAADC_S->EVENTS_END     = 0;
+    NRF_SAADC_S->TASKS_START    = 1;
+    while (!NRF_SAADC_S->EVENTS_STARTED) {}
+    NRF_SAADC_S->TASKS_SAMPLE   = 1;
+    _battery_vars.pending = true;
+}
+
+static void _collect_conversion(void) {
+    _battery_vars.pending = false;
+    NRF_SAADC_S->EVENTS_STOPPED = 0;
+    NRF_SAADC_S->TASKS_STOP     = 1;
+    while (!NRF_SAADC_S->EVENTS_STOPPED) {}
+    // Other users of the SAADC don't expect the oversampling
+    NRF_SAADC_S->OVERSAMPLE     = SAADC_OVERSAMPLE_OVERSAMPLE_Bypass << SAADC_OVERSAMPLE_OVERSAMPLE_Pos;
+
+    // Sliding average of the latest conversions, the input is single ended so negative values are noise
+    uint16_t value = (_battery_vars.sample < 0) ? 0 : (uint16_t)_battery_vars.sample;
+    if (!_battery_vars.initialized) {
+        // Fill the average with the first conversion so the level is valid right away
+        _battery_vars.initialized = true;
+        for (uint8_t index = 0; index < BATTERY_AVERAGE_COUNT; index++) {
+            _battery_vars.values[index] = value;
+        }
+        _battery_vars.sum = value * BATTERY_AVERAGE_COUNT;
+    }
+    _battery_vars.sum += value - _battery_vars.values[_battery_vars.index];
+    _battery_vars.values[_battery_vars.index] = value;
+    _battery_vars.index = (_battery_vars.index + 1) % BATTERY_AVERAGE_COUNT;
+    _battery_vars.level = (uint8_t)((_battery_vars.sum / BATTERY_AVERAGE_COUNT) * 100 / BATTERY_MAX_VALUE);
+}
+
 void battery_level_init(void) {
-    db_saadc_init(DB_SAADC_RESOLUTION_12BIT);
+    _start_conversion();
+    battery_level_flush();
+}
+
+bool battery_level_update(void) {
+    bool collected = false;
+    if (_battery_vars.pending) {
+        if (!NRF_SAADC_S->EVENTS_END) {
+            return false;
+        }
+        _collect_conversion();
+        collected = true;
+    }
+    _start_conversion();
+    return collected;
+}
+
+void battery_level_flush(void) {
+    if (!_battery_vars.pending) {
+        return;
+    }
+    while (!NRF_SAADC_S->EVENTS_END) {}
+    _collect_conversion();
 }
 
 uint8_t battery_level_read(void) {
-    uint16_t value_12b = 0;
-    db_saadc_read(ROBOT_BATTERY_LEVEL_PIN, &value_12b);
-    uint32_t max_val = 4095 * 3000 / 3600;
-    return (uint8_t)((float)value_12b / max_val * 100);
+    return _battery_vars.level;
 }
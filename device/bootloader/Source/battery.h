@@ -13,6 +13,8 @@
  * @}
  */
 
+#include <stdbool.h>
+#include <stdint.h>
 #include "saadc.h"
 
 // For reading the battery level
@@ -22,8 +24,28 @@
 #define ROBOT_BATTERY_LEVEL_PIN     (DB_SAADC_INPUT_VDD)
 #endif
 
+/**
+ * @brief Measure the battery level a first time, optional since the SAADC is configured for each conversion
+ */
 void battery_level_init(void);
 
+/**
+ * @brief Collect the latest conversion if it is complete and start the next one, doesn't wait for the SAADC
+ *
+ * @return true if a conversion was collected and the level updated
+ */
+bool battery_level_update(void);
+
+/**
+ * @brief Wait for the running conversion, if any, so the SAADC can be used for something else
+ */
+void battery_level_flush(void);
+
+/**
+ * @brief Return the battery level averaged over the latest conversions
+ *
+ * @return battery level in %
+ */
 uint8_t battery_level_read(void);
 
 #endif // __BATTERY_H
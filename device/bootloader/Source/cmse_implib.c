@@ -1,95 +1,357 @@
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <arm_cmse.h>
 #include <nrf.h>
 
 #include "battery.h"
 #include "cmse_implib.h"
 #include "board_config.h"
 #include "device.h"
+#include "gpio_capture.h"
 #include "ipc.h"
 #include "mari.h"
+#include "profile.h"
+#include "recorder.h"
 #include "rng.h"
 #include "lh2.h"
 #include "saadc.h"
+#include "timebase.h"
 
-static __attribute__((aligned(8))) uint8_t _tx_data_buffer[UINT8_MAX];
+#define KEEP_ALIVE_BATTERY_PERIOD_US    (1000000U)  ///< Min delay between the battery conversions started by the keep alives
+
+static swarmit_tx_stats_t _tx_stats = { 0 };
+static uint32_t _battery_updated_at = 0;
+static bool _saadc_initialized = false;
+static bool _localization_initialized = false;
 
 extern volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_keep_alive(void) {
+    uint32_t start = profile_start();
     NRF_WDT0_S->RR[0] = WDT_RR_RR_Reload << WDT_RR_RR_Pos;
-    ipc_shared_data.battery_level = battery_level_read();
+    // Only collects the conversion started by the previous update, the SAADC is never waited for.
+    // Updates are rate limited, the battery level changes slowly.
+    uint32_t now = timebase_now();
+    if (now - _battery_updated_at >= KEEP_ALIVE_BATTERY_PERIOD_US) {
+        _battery_updated_at = now;
+        if (battery_level_update()) {
+            ipc_shared_data.battery_level = battery_level_read();
+        }
+    }
+    profile_stop(PROFILE_NSC_KEEP_ALIVE, start);
+}
+
+static bool _ns_readable(const void *data, size_t length) {
+    return length == 0 || cmse_check_address_range((void *)data, length, CMSE_NONSECURE | CMSE_MPU_READ) != NULL;
+}
+
+static mari_tx_status_t _send_data_iov(const swarmit_iovec_t *iov, uint8_t count, bool blocking) {
+    // The fragments are assembled in place in the shared TX slot, in one pass
+    uint8_t *buffer;
+    mari_tx_status_t status = mari_node_tx_reserve(&buffer, blocking);
+    if (status != MARI_TX_QUEUED) {
+        return status;
+    }
+    size_t pos = 2;
+    for (uint8_t i = 0; i < count; i++) {
+        // Read once, the non secure side can change the fragment while it's copied
+        const swarmit_iovec_t fragment = iov[i];
+        if (pos + fragment.length > UINT8_MAX) {
+            // Ensure packet fits in a radio PDU with its header, the reserved slot is not queued
+            return MARI_TX_FULL;
+        }
+        if (!_ns_readable(fragment.data, fragment.length)) {
+            // Ensure fragment is not in secure space
+            return MARI_TX_FULL;
+        }
+        memcpy(buffer + pos, fragment.data, fragment.length);
+        pos += fragment.length;
+    }
+    buffer[0] = PACKET_DATA;
+    buffer[1] = (uint8_t)(pos - 2);
+    mari_node_tx_commit((uint8_t)pos);
+    return MARI_TX_QUEUED;
+}
+
+static void _update_tx_stats(mari_tx_status_t status) {
+    switch (status) {
+        case MARI_TX_QUEUED:
+            _tx_stats.queued++;
+            break;
+        case MARI_TX_FULL:
+            _tx_stats.full++;
+            break;
+        case MARI_TX_DISCONNECTED:
+            _tx_stats.disconnected++;
+            break;
+    }
 }
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_send_data_packet(const uint8_t *packet, uint8_t length) {
-    size_t pos = 0;
-    _tx_data_buffer[pos++] = PACKET_DATA;
-    _tx_data_buffer[pos++] = length;
-    memcpy(_tx_data_buffer + pos, &packet, length);
-    pos += length;
-    mari_node_tx(_tx_data_buffer, pos);
+    uint32_t start = profile_start();
+    const swarmit_iovec_t iov = { .data = packet, .length = length };
+    _send_data_iov(&iov, 1, true);
+    profile_stop(PROFILE_NSC_SEND_DATA_PACKET, start);
 }
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_send_raw_data(const uint8_t *packet, uint8_t length) {
+    uint32_t start = profile_start();
     mari_node_tx(packet, length);
+    profile_stop(PROFILE_NSC_SEND_RAW_DATA, start);
+}
+
+__attribute__((cmse_nonsecure_entry)) mari_tx_status_t swarmit_send_data_packet_nonblocking(const uint8_t *packet, uint8_t length) {
+    uint32_t start = profile_start();
+    const swarmit_iovec_t iov = { .data = packet, .length = length };
+    mari_tx_status_t status = _send_data_iov(&iov, 1, false);
+    _update_tx_stats(status);
+    profile_stop(PROFILE_NSC_SEND_DATA_PACKET_NONBLOCKING, start);
+    return status;
+}
+
+__attribute__((cmse_nonsecure_entry)) mari_tx_status_t swarmit_send_data_iov(const swarmit_iovec_t *iov, uint8_t count, bool blocking) {
+    uint32_t start = profile_start();
+    mari_tx_status_t status = MARI_TX_FULL;
+    // Ensure fragments array is not in secure space
+    if (_ns_readable(iov, count * sizeof(swarmit_iovec_t))) {
+        status = _send_data_iov(iov, count, blocking);
+    }
+    if (!blocking) {
+        _update_tx_stats(status);
+    }
+    profile_stop(PROFILE_NSC_SEND_DATA_IOV, start);
+    return status;
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_tx_stats(swarmit_tx_stats_t *stats) {
+    uint32_t start = profile_start();
+    // Ensure stats address is writable by the non secure side
+    if (cmse_check_address_range(stats, sizeof(swarmit_tx_stats_t), CMSE_NONSECURE | CMSE_MPU_READWRITE) != NULL) {
+        _tx_stats.sent = ipc_shared_data.tx_sent;
+        memcpy(stats, &_tx_stats, sizeof(swarmit_tx_stats_t));
+    }
+    profile_stop(PROFILE_NSC_TX_STATS, start);
+}
+
+static bool _rx_pdu_process(ipc_isr_cb_t cb) {
+    if (ipc_shared_data.rx_ring.tail == ipc_shared_data.rx_ring.head) {
+        return false;
+    }
+
+    volatile ipc_radio_pdu_t *pdu = &ipc_shared_data.rx_ring.pdus[ipc_shared_data.rx_ring.tail % IPC_RADIO_PDU_SLOTS];
+    cb((const uint8_t *)pdu->buffer, pdu->length);
+
+    // Release the slot once the callback returned
+    __DMB();
+    ipc_shared_data.rx_ring.tail++;
+    return true;
+}
+
+static void _ipc_req_ack_clear(void) {
+    // The interrupt targets the user image once it runs, request acks only wake up the core waiting
+    // in ipc_network_call and their event would keep the interrupt pending
+    NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_REQ_ACK] = 0;
 }
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_ipc_isr(ipc_isr_cb_t cb) {
-    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RADIO_RX]) {
-        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RADIO_RX] = 0;
-        cb((const uint8_t *)ipc_shared_data.rx_pdu.buffer, ipc_shared_data.rx_pdu.length);
+    // Includes the time spent in the non secure callback
+    uint32_t start = profile_start();
+    _ipc_req_ack_clear();
+    // The event is cleared first so packets queued meanwhile trigger the interrupt again
+    NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RADIO_RX] = 0;
+    _rx_pdu_process(cb);
+    // Keep the interrupt pending until all queued packets are processed, the event is already cleared
+    // when it's entered again so the ring state is checked instead
+    if (ipc_shared_data.rx_ring.tail != ipc_shared_data.rx_ring.head) {
+        NVIC_SetPendingIRQ(IPC_IRQn);
     }
+    profile_stop(PROFILE_NSC_IPC_ISR, start);
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_ipc_isr_drain(ipc_isr_cb_t cb) {
+    uint32_t start = profile_start();
+    _ipc_req_ack_clear();
+    // The event is cleared first so packets queued meanwhile trigger the interrupt again
+    NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RADIO_RX] = 0;
+    while (_rx_pdu_process(cb)) {}
+    profile_stop(PROFILE_NSC_IPC_ISR_DRAIN, start);
 }
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_init_rng(void) {
+    uint32_t start = profile_start();
     rng_init();
+    profile_stop(PROFILE_NSC_INIT_RNG, start);
 }
 
 __attribute__((cmse_nonsecure_entry)) void swarmit_read_rng(uint8_t *value) {
+    uint32_t start = profile_start();
     rng_read(value);
+    profile_stop(PROFILE_NSC_READ_RNG, start);
 }
 
 __attribute__((cmse_nonsecure_entry)) uint64_t swarmit_read_device_id(void) {
-    return db_device_id();
+    uint32_t start = profile_start();
+    uint64_t device_id = db_device_id();
+    profile_stop(PROFILE_NSC_READ_DEVICE_ID, start);
+    return device_id;
 }
 
-__attribute__((cmse_nonsecure_entry)) void swarmit_log_data(uint8_t *data, size_t length) {
+__attribute__((cmse_nonsecure_entry)) uint64_t swarmit_get_time(void) {
+    uint32_t start = profile_start();
+    uint64_t time = ipc_network_time(timebase_now());
+    profile_stop(PROFILE_NSC_GET_TIME, start);
+    return time;
+}
+
+__attribute__((cmse_nonsecure_entry)) bool swarmit_gpio_capture(uint8_t port, uint8_t pin) {
+    uint32_t start = profile_start();
+    bool enabled = gpio_capture_enable(port, pin);
+    profile_stop(PROFILE_NSC_GPIO_CAPTURE, start);
+    return enabled;
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_gpio_capture_flush(void) {
+    uint32_t start = profile_start();
+    gpio_capture_flush();
+    profile_stop(PROFILE_NSC_GPIO_CAPTURE_FLUSH, start);
+}
+
+static void _log_entry_push(uint8_t flags, const uint8_t *header, size_t header_length, const uint8_t *data, size_t length) {
+    // Drop the entry if the network core doesn't send them fast enough
+    uint8_t head = ipc_shared_data.log_ring.head;
+    if ((uint8_t)(head - ipc_shared_data.log_ring.tail) >= IPC_LOG_SLOTS) {
+        return;
+    }
+
+    volatile ipc_log_data_t *entry = &ipc_shared_data.log_ring.entries[head % IPC_LOG_SLOTS];
+    entry->length = (header_length + length) | flags;
+    if (header_length) {
+        memcpy((void *)entry->data, header, header_length);
+    }
+    memcpy((void *)(entry->data + header_length), data, length);
+
+    // Publish the entry once its content is complete
+    __DMB();
+    ipc_shared_data.log_ring.head = head + 1;
+    NRF_IPC_S->TASKS_SEND[IPC_CHAN_LOG_EVENT] = 1;
+}
+
+static bool _address_is_secure(const void *data) {
+    const uint8_t *ptr = data;
+    return (ptr > (uint8_t *)0x20000000 && ptr < (uint8_t *)0x20008000) || (ptr > (uint8_t *)0x00000000 && ptr < (uint8_t *)0x0000ff00);
+}
+
+static void _log_data(uint8_t *data, size_t length) {
     if (length > INT8_MAX) {
         // Ensure length fits in the log data buffer in shared RAM
         return;
     }
 
-    if ((data > (uint8_t *)0x20000000 && data < (uint8_t *)0x20008000) || (data > (uint8_t *)0x00000000 && data < (uint8_t *)0x0000ff00)) {
+    if (_address_is_secure(data)) {
         // Ensure data address is not in secure space
         return;
     }
 
-    ipc_shared_data.log.length = length;
-    memcpy((void *)ipc_shared_data.log.data, data, length);
-    NRF_IPC_S->TASKS_SEND[IPC_CHAN_LOG_EVENT] = 1;
+    _log_entry_push(0, NULL, 0, data, length);
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_log_data(uint8_t *data, size_t length) {
+    uint32_t start = profile_start();
+    _log_data(data, length);
+    profile_stop(PROFILE_NSC_LOG_DATA, start);
+}
+
+static void _log_format(uint16_t format_id, const uint32_t *args, uint8_t count) {
+    if (count > SWARMIT_LOG_ARGS_MAX) {
+        // Ensure format ID and arguments fit in the log data buffer in shared RAM
+        return;
+    }
+
+    if (count && _address_is_secure(args)) {
+        // Ensure arguments address is not in secure space
+        return;
+    }
+
+    _log_entry_push(SWRMT_LOG_FORMAT_FLAG, (const uint8_t *)&format_id, sizeof(uint16_t), (const uint8_t *)args, count * sizeof(uint32_t));
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_log_format(uint16_t format_id, const uint32_t *args, uint8_t count) {
+    uint32_t start = profile_start();
+    _log_format(format_id, args, count);
+    profile_stop(PROFILE_NSC_LOG_FORMAT, start);
+}
+
+static bool _record_append(const uint8_t *data, uint8_t length) {
+    if (length && _address_is_secure(data)) {
+        // Ensure data address is not in secure space
+        return false;
+    }
+
+    return recorder_append(data, length);
+}
+
+__attribute__((cmse_nonsecure_entry)) bool swarmit_record_append(const uint8_t *data, uint8_t length) {
+    uint32_t start = profile_start();
+    bool appended = _record_append(data, length);
+    profile_stop(PROFILE_NSC_RECORD_APPEND, start);
+    return appended;
+}
+
+__attribute__((cmse_nonsecure_entry)) void swarmit_record_flush(void) {
+    uint32_t start = profile_start();
+    recorder_flush();
+    profile_stop(PROFILE_NSC_RECORD_FLUSH, start);
+}
+
+static void _localization_init_once(void) {
+    // Not initialized at boot, to start the user image faster
+    if (!_localization_initialized) {
+        _localization_initialized = true;
+        localization_init();
+    }
 }
 
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_localization_process_data(void) {
+    uint32_t start = profile_start();
+    _localization_init_once();
     localization_process_data();
+    profile_stop(PROFILE_NSC_LOCALIZATION_PROCESS_DATA, start);
 }
 
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_localization_get_position(position_2d_t *position) {
+    uint32_t start = profile_start();
+    _localization_init_once();
     localization_get_position(position);
+    profile_stop(PROFILE_NSC_LOCALIZATION_GET_POSITION, start);
 }
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_localization_handle_isr(void) {
+    uint32_t start = profile_start();
     if (NRF_SPIM4_S->EVENTS_END) {
         // Clear the Interrupt flag
         NRF_SPIM4_S->EVENTS_END = 0;
         db_lh2_handle_isr();
     }
+    profile_stop(PROFILE_NSC_LOCALIZATION_HANDLE_ISR, start);
 }
 
-__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_saadc_read(uint8_t channel, uint16_t *value) {
+static void _saadc_read(uint8_t channel, uint16_t *value) {
     if (channel != DB_SAADC_INPUT_VDDH && !(channel <= DB_SAADC_INPUT_VDD) && !(channel >= DB_SAADC_INPUT_AIN0)) {
         return;
     }
+    battery_level_flush();
+    if (!_saadc_initialized) {
+        _saadc_initialized = true;
+        db_saadc_init(DB_SAADC_RESOLUTION_12BIT);
+    }
     return db_saadc_read(channel, value);
 }
+
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_saadc_read(uint8_t channel, uint16_t *value) {
+    uint32_t start = profile_start();
+    _saadc_read(channel, value);
+    profile_stop(PROFILE_NSC_SAADC_READ, start);
+}
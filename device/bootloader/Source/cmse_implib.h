@@ -13,21 +13,109 @@
  * @}
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
 
 #include "localization.h"
+#include "mari.h"
 
 typedef void (*ipc_isr_cb_t)(const uint8_t *, size_t) __attribute__((cmse_nonsecure_call));
 
+#define SWARMIT_LOG_ARGS_MAX    (16U)   ///< Max number of arguments of a formatted log entry
+
+/**
+ * @brief Log a formatted message, only integer arguments are supported
+ *
+ * The format string is not sent: it is stored in the .swarmit_log_fmt section of the user image
+ * and identified by its offset in this section. The host resolves the format ID with the
+ * format strings extracted from the ELF file and renders the message.
+ */
+#define SWARMIT_LOG(fmt, ...)                                                                                           \
+    do {                                                                                                                \
+        static const char _swarmit_log_fmt[] __attribute__((section(".swarmit_log_fmt"), used)) = fmt;                \
+        const uint32_t _swarmit_log_args[] = { 0, ##__VA_ARGS__ };                                                      \
+        swarmit_log_format((uint16_t)(_swarmit_log_fmt - __swarmit_log_fmt_start__), &_swarmit_log_args[1],             \
+                           sizeof(_swarmit_log_args) / sizeof(uint32_t) - 1);                                           \
+    } while (0)
+
+extern const char __swarmit_log_fmt_start__[];  ///< Start of the format strings section, defined by the linker
+
+typedef struct {
+    uint32_t queued;        ///< Number of packets queued by the non-blocking sends
+    uint32_t sent;          ///< Number of queued packets handed to the radio by the network core
+    uint32_t full;          ///< Number of packets dropped because the TX queue was full
+    uint32_t disconnected;  ///< Number of packets dropped because the device was not connected
+} swarmit_tx_stats_t;
+
+/// Fragment of a data packet sent with swarmit_send_data_iov
+typedef struct {
+    const uint8_t *data;    ///< Content of the fragment
+    uint8_t        length;  ///< Length of the fragment in bytes
+} swarmit_iovec_t;
+
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_keep_alive(void);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_send_data_packet(const uint8_t *packet, uint8_t length);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_send_raw_data(const uint8_t *packet, uint8_t length);
+__attribute__((cmse_nonsecure_entry, aligned)) mari_tx_status_t swarmit_send_data_packet_nonblocking(const uint8_t *packet, uint8_t length);
+
+/**
+ * @brief Send a data packet assembled from fragments, copied in place in the TX queue
+ *
+ * @return MARI_TX_QUEUED if the packet was queued, MARI_TX_FULL also if it's too long or if the
+ *         fragments are not readable by the non secure side
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) mari_tx_status_t swarmit_send_data_iov(const swarmit_iovec_t *iov, uint8_t count, bool blocking);
+
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_tx_stats(swarmit_tx_stats_t *stats);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_ipc_isr(ipc_isr_cb_t cb);
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_ipc_isr_drain(ipc_isr_cb_t cb);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_init_rng(void);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_read_rng(uint8_t *value);
 __attribute__((cmse_nonsecure_entry, aligned)) uint64_t swarmit_read_device_id(void);
+
+/**
+ * @brief Return the network time in us, shared by the devices synchronized by the same controller
+ *
+ * The time is synchronized with the time broadcast by the controller, it counts from the start of the
+ * network core until the first synchronization. It's interpolated from the last time anchor published
+ * by the network core, without waiting for it, so it can also be called from interrupt handlers.
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) uint64_t swarmit_get_time(void);
+
+/**
+ * @brief Timestamp both edges of an input pin in hardware and send them as GPIO event notifications
+ *
+ * Up to 3 pins can be captured. The events are sent in batches by swarmit_gpio_capture_flush,
+ * stamped with the network time.
+ *
+ * @return true if the pin is captured, false if all the capture channels are used
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) bool swarmit_gpio_capture(uint8_t port, uint8_t pin);
+
+/**
+ * @brief Send the captured GPIO events once a batch is full or the oldest event waited 50ms
+ *
+ * Call it regularly from the context sending the data packets, not from an interrupt handler.
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_gpio_capture_flush(void);
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_log_data(uint8_t *data, size_t length);
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_log_format(uint16_t format_id, const uint32_t *args, uint8_t count);
+
+/**
+ * @brief Append a record to the flash region read back by the controller once the image is stopped
+ *
+ * Records are buffered by flash page, appending blocks while a full page is written and the next
+ * one erased. The records of a run replace the ones of the previous run.
+ *
+ * @return false if the region is full
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) bool swarmit_record_append(const uint8_t *data, uint8_t length);
+
+/**
+ * @brief Write the buffered records to flash, they are also written back if the image is stopped
+ */
+__attribute__((cmse_nonsecure_entry, aligned)) void swarmit_record_flush(void);
 
 // Lighthouse 2 functions exposed to user image
 __attribute__((cmse_nonsecure_entry, aligned)) void swarmit_localization_process_data(void);
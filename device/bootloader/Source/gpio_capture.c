@@ -0,0 +1,126 @@
+#include <nrf.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpio_capture.h"
+#include "ipc.h"
+#include "mari.h"
+#include "protocol.h"
+#include "timebase.h"
+
+#define GPIO_CAPTURE_DPPI_GPIO  (2U)    ///< First DPPI channel capturing the timebase on GPIO events, after the time anchor one
+
+typedef struct {
+    uint32_t ticks;         ///< Timebase value captured on the edge
+    gpio_data_t data;       ///< Pin and level after the edge
+} gpio_capture_event_t;
+
+typedef struct {
+    gpio_data_t             pins[TIMEBASE_CC_GPIO_COUNT];       ///< Captured pins, indexed by GPIOTE channel
+    uint8_t                 count;                              ///< Number of captured pins
+    gpio_capture_event_t    events[GPIO_CAPTURE_EVENTS_MAX];    ///< Events waiting to be sent
+    volatile uint8_t        head;                               ///< Incremented by the interrupt once an event is captured
+    uint8_t                 tail;                               ///< Incremented once an event is sent
+} gpio_capture_vars_t;
+
+static gpio_capture_vars_t _gpio_capture_vars = { 0 };
+
+static void _capture_init(void) {
+    // The captured timebase values are converted to the network time when they are sent
+    timebase_acquire();
+
+    NVIC_ClearPendingIRQ(GPIOTE0_IRQn);
+    NVIC_EnableIRQ(GPIOTE0_IRQn);
+}
+
+bool gpio_capture_enable(uint8_t port, uint8_t pin) {
+    if (_gpio_capture_vars.count >= TIMEBASE_CC_GPIO_COUNT || port > 1 || pin > 31) {
+        return false;
+    }
+    if (_gpio_capture_vars.count == 0) {
+        _capture_init();
+    }
+
+    uint8_t channel                         = _gpio_capture_vars.count;
+    uint8_t dppi                            = GPIO_CAPTURE_DPPI_GPIO + channel;
+    _gpio_capture_vars.pins[channel].port   = port;
+    _gpio_capture_vars.pins[channel].pin    = pin;
+
+    NRF_GPIOTE0_S->CONFIG[channel]          = (GPIOTE_CONFIG_MODE_Event << GPIOTE_CONFIG_MODE_Pos) |
+                                              (pin << GPIOTE_CONFIG_PSEL_Pos) |
+                                              (port << GPIOTE_CONFIG_PORT_Pos) |
+                                              (GPIOTE_CONFIG_POLARITY_Toggle << GPIOTE_CONFIG_POLARITY_Pos);
+    NRF_GPIOTE0_S->PUBLISH_IN[channel]      = (dppi << GPIOTE_PUBLISH_IN_CHIDX_Pos) |
+                                              (GPIOTE_PUBLISH_IN_EN_Enabled << GPIOTE_PUBLISH_IN_EN_Pos);
+    TIMEBASE_TIMER->SUBSCRIBE_CAPTURE[TIMEBASE_CC_GPIO + channel] = (dppi << TIMER_SUBSCRIBE_CAPTURE_CHIDX_Pos) |
+                                                                    (TIMER_SUBSCRIBE_CAPTURE_EN_Enabled << TIMER_SUBSCRIBE_CAPTURE_EN_Pos);
+    NRF_DPPIC_S->CHENSET                    = 1 << dppi;
+    NRF_GPIOTE0_S->EVENTS_IN[channel]       = 0;
+    NRF_GPIOTE0_S->INTENSET                 = 1 << channel;
+
+    _gpio_capture_vars.count++;
+    return true;
+}
+
+void gpio_capture_flush(void) {
+    // Events captured meanwhile are kept for the next batch
+    uint8_t head    = _gpio_capture_vars.head;
+    uint8_t pending = head - _gpio_capture_vars.tail;
+    if (pending == 0) {
+        return;
+    }
+
+    const gpio_capture_event_t *oldest = &_gpio_capture_vars.events[_gpio_capture_vars.tail % GPIO_CAPTURE_EVENTS_MAX];
+    if ((pending < SWRMT_GPIO_EVENT_BATCH_MAX) && (timebase_now() - oldest->ticks < GPIO_CAPTURE_DELAY_US)) {
+        return;
+    }
+
+    uint8_t *buffer;
+    mari_tx_status_t status = mari_node_tx_reserve(&buffer, false);
+    if (status == MARI_TX_DISCONNECTED) {
+        // Drop the events, they would be sent late
+        _gpio_capture_vars.tail = head;
+        return;
+    } else if (status != MARI_TX_QUEUED) {
+        return;
+    }
+
+    uint8_t count = (pending < SWRMT_GPIO_EVENT_BATCH_MAX) ? pending : SWRMT_GPIO_EVENT_BATCH_MAX;
+    size_t length = 0;
+    buffer[length++] = SWRMT_NOTIFICATION_GPIO_EVENT;
+    buffer[length++] = count;
+    buffer[length++] = count * sizeof(swrmt_gpio_event_t);
+    for (uint8_t i = 0; i < count; i++) {
+        const gpio_capture_event_t *event = &_gpio_capture_vars.events[_gpio_capture_vars.tail++ % GPIO_CAPTURE_EVENTS_MAX];
+        swrmt_gpio_event_t *notification = (swrmt_gpio_event_t *)(buffer + length);
+        notification->timestamp = (uint32_t)ipc_network_time(event->ticks);
+        notification->data      = event->data;
+        length += sizeof(swrmt_gpio_event_t);
+    }
+    mari_node_tx_commit((uint8_t)length);
+}
+
+void GPIOTE0_IRQHandler(void) {
+    for (uint8_t channel = 0; channel < _gpio_capture_vars.count; channel++) {
+        if (!NRF_GPIOTE0_S->EVENTS_IN[channel]) {
+            continue;
+        }
+        NRF_GPIOTE0_S->EVENTS_IN[channel] = 0;
+
+        // Drop the event if the buffer is full, the oldest ones are still waiting to be sent
+        uint8_t head = _gpio_capture_vars.head;
+        if ((uint8_t)(head - _gpio_capture_vars.tail) >= GPIO_CAPTURE_EVENTS_MAX) {
+            continue;
+        }
+
+        // The pins are non secure, their level is read through the non secure peripheral
+        const gpio_data_t *pin       = &_gpio_capture_vars.pins[channel];
+        NRF_GPIO_Type *port          = (pin->port) ? NRF_P1_NS : NRF_P0_NS;
+        gpio_capture_event_t *event  = &_gpio_capture_vars.events[head % GPIO_CAPTURE_EVENTS_MAX];
+        event->ticks                 = TIMEBASE_TIMER->CC[TIMEBASE_CC_GPIO + channel];
+        event->data.port             = pin->port;
+        event->data.pin              = pin->pin;
+        event->data.value            = (port->IN >> pin->pin) & 0x01;
+        _gpio_capture_vars.head      = head + 1;
+    }
+}
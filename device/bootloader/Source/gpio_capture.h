@@ -0,0 +1,44 @@
+#ifndef __GPIO_CAPTURE_H
+#define __GPIO_CAPTURE_H
+
+/**
+ * @defgroup    bsp_gpio_capture  GPIO event capture
+ * @ingroup     bsp
+ * @brief       Timestamp GPIO edges in hardware and send them in batches
+ *
+ * GPIOTE events are routed through DPPI to captures of the secure timebase, so the timestamps
+ * don't depend on the interrupt latency. The captured pins are taken over as inputs by GPIOTE:
+ * to time an output of the user image, wire it to a captured pin.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define GPIO_CAPTURE_EVENTS_MAX     (64U)       ///< Number of buffered events, power of 2
+#define GPIO_CAPTURE_DELAY_US       (50000U)    ///< Max time an event is buffered before it is sent
+
+/**
+ * @brief Capture both edges of a pin
+ *
+ * @param[in] port  Port of the pin
+ * @param[in] pin   Pin number in the port
+ *
+ * @return true if the pin is captured, false if all the capture channels are used
+ */
+bool gpio_capture_enable(uint8_t port, uint8_t pin);
+
+/**
+ * @brief Send the buffered events if a batch is full or the oldest event waited long enough
+ *
+ * Events are converted to network time before being sent, from the last network time anchor.
+ * Must be called from the context sending the data packets, used by the TX ring.
+ */
+void gpio_capture_flush(void);
+
+#endif // __GPIO_CAPTURE_H
@@ -1,11 +1,15 @@
 #include <nrf.h>
 #include "ipc.h"
+#include "profile.h"
+#include "timebase.h"
 
 /**
  * @brief Variable in RAM containing the shared data structure
  */
 volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
 
+#define IPC_TIME_ANCHOR_DPPI    (1U)    ///< DPPI channel capturing the timebase on network time anchors
+
 /**
  * @brief Lock the mutex, blocks until the mutex is locked
  */
@@ -20,14 +24,101 @@ void mutex_unlock(void) {
     NRF_MUTEX_NS->MUTEX[0] = 0;
 }
 
+// The timeout compares the secure timebase, its interrupt is not enabled in the NVIC, the pending
+// interrupt only wakes up WFE because SEVONPEND is set.
+static void _timeout_start(uint32_t now, uint32_t timeout_us) {
+    TIMEBASE_TIMER->EVENTS_COMPARE[TIMEBASE_CC_TIMEOUT] = 0;
+    TIMEBASE_TIMER->CC[TIMEBASE_CC_TIMEOUT]             = now + timeout_us;
+    TIMEBASE_TIMER->INTENSET                            = (TIMER_INTENSET_COMPARE0_Enabled << TIMER_INTENSET_COMPARE0_Pos);
+    NVIC_ClearPendingIRQ(TIMEBASE_TIMER_IRQ);
+}
+
+static void _timeout_stop(void) {
+    TIMEBASE_TIMER->INTENCLR                            = (TIMER_INTENCLR_COMPARE0_Clear << TIMER_INTENCLR_COMPARE0_Pos);
+    TIMEBASE_TIMER->EVENTS_COMPARE[TIMEBASE_CC_TIMEOUT] = 0;
+    NVIC_ClearPendingIRQ(TIMEBASE_TIMER_IRQ);
+}
+
 void ipc_network_call(ipc_req_t req) {
+    ipc_network_call_timeout(req, 0);
+}
+
+bool ipc_network_call_timeout(ipc_req_t req, uint32_t timeout_us) {
+    // Pending interrupts wake up WFE even if they are disabled or masked
+    SCB->SCR |= SCB_SCR_SEVONPEND_Msk;
+
+    // The core sleeps until the ack, the call is profiled with the timebase since the cycle counter
+    // stops meanwhile. The timebase may already run for the GPIO capture, it is never cleared.
+    timebase_acquire();
+    uint32_t start = timebase_now();
+
+    // Ignore a late acknowledgment of a previous request that timed out
+    ipc_shared_data.net_ack = false;
+    if (timeout_us) {
+        _timeout_start(start, timeout_us);
+    }
     if (req != IPC_REQ_NONE) {
         ipc_shared_data.req                 = req;
         NRF_IPC_S->TASKS_SEND[IPC_CHAN_REQ] = 1;
     }
-    while (!ipc_shared_data.net_ack) {}
+
+    // The network core sends an event on the ack channel once the request is processed
+    bool acked = true;
+    while (!ipc_shared_data.net_ack) {
+        if (timeout_us && TIMEBASE_TIMER->EVENTS_COMPARE[TIMEBASE_CC_TIMEOUT]) {
+            acked = false;
+            break;
+        }
+        __WFE();
+    }
+    if (timeout_us) {
+        _timeout_stop();
+    }
     ipc_shared_data.net_ack = false;
-};
+    profile_add(PROFILE_IPC_NETWORK_CALL, (timebase_now() - start) * (SystemCoreClock / 1000000));
+    timebase_release();
+    return acked;
+}
+
+void ipc_time_init(void) {
+    // The network core sends an event on each anchor, it captures the timebase so the network time
+    // can be interpolated without jitter. The timebase keeps running to count from the anchor.
+    timebase_acquire();
+    NRF_IPC_S->PUBLISH_RECEIVE[IPC_CHAN_TIME_ANCHOR]        = (IPC_TIME_ANCHOR_DPPI << IPC_PUBLISH_RECEIVE_CHIDX_Pos) |
+                                                              (IPC_PUBLISH_RECEIVE_EN_Enabled << IPC_PUBLISH_RECEIVE_EN_Pos);
+    TIMEBASE_TIMER->SUBSCRIBE_CAPTURE[TIMEBASE_CC_ANCHOR]   = (IPC_TIME_ANCHOR_DPPI << TIMER_SUBSCRIBE_CAPTURE_CHIDX_Pos) |
+                                                              (TIMER_SUBSCRIBE_CAPTURE_EN_Enabled << TIMER_SUBSCRIBE_CAPTURE_EN_Pos);
+    NRF_DPPIC_S->CHENSET                                    = 1 << IPC_TIME_ANCHOR_DPPI;
+
+    // The last anchor may have been captured by the previous boot, wait for a new one
+    ipc_network_call(IPC_TIME_REQ);
+}
+
+uint64_t ipc_network_time(uint32_t ticks) {
+    volatile ipc_time_anchor_t *anchor = &ipc_shared_data.time_anchor;
+    uint32_t seq;
+    uint32_t anchor_ticks;
+    uint64_t network_us;
+    int64_t correction;
+    do {
+        seq = anchor->seq;
+        __DMB();
+        anchor_ticks    = TIMEBASE_TIMER->CC[TIMEBASE_CC_ANCHOR];
+        network_us      = anchor->network_us;
+        correction      = anchor->correction;
+        __DMB();
+    } while ((seq & 0x01) || (seq != anchor->seq));
+
+    // Ticks captured before the anchor are not slewed, the correction was larger back then
+    int32_t elapsed = (int32_t)(ticks - anchor_ticks);
+    if (elapsed <= 0) {
+        return network_us + elapsed;
+    }
+    // Same slew as the network core
+    int64_t slew_max = elapsed / IPC_TIME_SLEW_RATIO;
+    int64_t slew = (correction > slew_max) ? slew_max : (correction < -slew_max) ? -slew_max : correction;
+    return network_us + elapsed + slew;
+}
 
 void release_network_core(void) {
     // Do nothing if network core is already started and ready
@@ -3,6 +3,7 @@
 
 #include "localization.h"
 
+// Built-in homography, only used until homographies are uploaded with a calibration config request
 #define LH2_CALIBRATION_IS_VALID    (0)
 
 localization_homography_t swrmt_homography = { 0 };
@@ -1,53 +1,141 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "board_config.h"
 #include "lh2.h"
 #include "localization.h"
 #include "lh2_calibration.h"
+#include "nvmc.h"
+
+#define LOCALIZATION_CALIBRATION_MAGIC  (0x4C324843)    ///< "CH2L"
+
+typedef struct {
+    uint32_t magic;                                             ///< Set once a homography was stored
+    uint32_t valid;                                             ///< Bitmap of the basestations having a homography
+    int32_t  homographies[LOCALIZATION_BASESTATIONS_MAX][3][3]; ///< Homography matrices, each element multiplied by 1e6
+} localization_calibration_t;
 
 typedef struct {
-    db_lh2_t                lh2;
-    double                  coordinates[2];
+    db_lh2_t                    lh2;
+    double                      coordinates[2];
+    localization_calibration_t  calibration;
+    uint8_t                     basestation;    ///< Basestation used for the latest fix
 } localization_data_t;
 
 static localization_data_t _localization_data = { 0 };
 
+static uint8_t _basestations_count(void) {
+    // The LH2 driver may support less basestations than the calibration page
+    size_t count = sizeof(_localization_data.lh2.data_ready[0]) / sizeof(_localization_data.lh2.data_ready[0][0]);
+    return (uint8_t)((count < LOCALIZATION_BASESTATIONS_MAX) ? count : LOCALIZATION_BASESTATIONS_MAX);
+}
 
 void localization_init(void) {
     puts("Initialize localization");
     db_lh2_init(&_localization_data.lh2, &db_lh2_d, &db_lh2_e);
     db_lh2_start();
 
+    const localization_calibration_t *stored = (const localization_calibration_t *)LOCALIZATION_CALIBRATION_ADDRESS;
+    if (stored->magic == LOCALIZATION_CALIBRATION_MAGIC) {
+        memcpy(&_localization_data.calibration, stored, sizeof(localization_calibration_t));
+    }
 #if LH2_CALIBRATION_IS_VALID
-    puts("Store homography matrix");
-    for (int i = 0; i < 3; i++) {
-        for (int j = 0; j < 3; j++) {
-            printf("%i ", swrmt_homography[i][j]);
-        }
-        printf("\n");
+    else {
+        // Fall back on the homography built in the bootloader
+        memcpy(_localization_data.calibration.homographies[swrmt_homography.basestation_index], swrmt_homography.homography_matrix, sizeof(swrmt_homography.homography_matrix));
+        _localization_data.calibration.valid = 1 << swrmt_homography.basestation_index;
     }
-    // Only store the homography if a valid one is set in lh2_calibration.h
-    db_lh2_store_homography(&_localization_data.lh2, 0, swrmt_homography);
 #endif
 
+    for (uint8_t basestation = 0; basestation < _basestations_count(); basestation++) {
+        if (_localization_data.calibration.valid & (1 << basestation)) {
+            printf("Store homography of basestation %u\n", basestation);
+            db_lh2_store_homography(&_localization_data.lh2, basestation, _localization_data.calibration.homographies[basestation]);
+        }
+    }
+}
+
+bool localization_store_homography(const localization_homography_t *homography) {
+    uint8_t basestation = homography->basestation_index;
+    if (basestation >= _basestations_count()) {
+        return false;
+    }
+
+    // Calibrations are sent several times, only rewrite the flash page on changes
+    localization_calibration_t *calibration = &_localization_data.calibration;
+    if ((calibration->magic == LOCALIZATION_CALIBRATION_MAGIC) && (calibration->valid & (1 << basestation)) &&
+        !memcmp(calibration->homographies[basestation], homography->homography_matrix, sizeof(homography->homography_matrix))) {
+        return true;
+    }
+    calibration->magic = LOCALIZATION_CALIBRATION_MAGIC;
+    calibration->valid |= 1 << basestation;
+    memcpy(calibration->homographies[basestation], homography->homography_matrix, sizeof(homography->homography_matrix));
+    nvmc_page_erase(LOCALIZATION_CALIBRATION_ADDRESS / FLASH_PAGE_SIZE);
+    nvmc_write((const uint32_t *)LOCALIZATION_CALIBRATION_ADDRESS, calibration, sizeof(localization_calibration_t));
+    printf("Homography of basestation %u updated\n", basestation);
+
+    db_lh2_store_homography(&_localization_data.lh2, basestation, calibration->homographies[basestation]);
+    return true;
+}
+
+static bool _raw_data_available(void) {
+    const size_t sweeps = sizeof(_localization_data.lh2.data_ready) / sizeof(_localization_data.lh2.data_ready[0]);
+    const size_t basestations = sizeof(_localization_data.lh2.data_ready[0]) / sizeof(_localization_data.lh2.data_ready[0][0]);
+    for (size_t sweep = 0; sweep < sweeps; sweep++) {
+        for (size_t basestation = 0; basestation < basestations; basestation++) {
+            if (_localization_data.lh2.data_ready[sweep][basestation] == DB_LH2_RAW_DATA_AVAILABLE) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void localization_start(void) {
+    db_lh2_start();
+}
+
+void localization_stop(void) {
+    db_lh2_stop();
 }
 
 void localization_process_data(void) {
-    puts("localization_process_data");
+    // Sweeps are captured by the LH2 driver interrupts, only process them when new ones are available
+    if (!_raw_data_available()) {
+        return;
+    }
     db_lh2_process_location(&_localization_data.lh2);
 }
 
-void localization_get_position(position_2d_t *position) {
-    puts("Get position");
-    if (_localization_data.lh2.data_ready[0][0] == DB_LH2_PROCESSED_DATA_AVAILABLE && _localization_data.lh2.data_ready[1][0] == DB_LH2_PROCESSED_DATA_AVAILABLE) {
-        puts("Data available");
-#if LH2_CALIBRATION_IS_VALID
-        db_lh2_stop();
-        db_lh2_calculate_position(_localization_data.lh2.locations[0][0].lfsr_location, _localization_data.lh2.locations[1][0].lfsr_location, 0, _localization_data.coordinates);
-        position->x = (uint32_t)(_localization_data.coordinates[0] * 1e6);
-        position->y = (uint32_t)(_localization_data.coordinates[1] * 1e6);
-        printf("Position (%u,%u)\n", position->x, position->y);
-        db_lh2_start();
-#endif
+static bool _fix_available(uint8_t basestation) {
+    return (_localization_data.calibration.valid & (1 << basestation)) &&
+           _localization_data.lh2.data_ready[0][basestation] == DB_LH2_PROCESSED_DATA_AVAILABLE &&
+           _localization_data.lh2.data_ready[1][basestation] == DB_LH2_PROCESSED_DATA_AVAILABLE;
+}
+
+bool localization_get_position(position_2d_t *position) {
+    // Stick to the basestation of the previous fix while it is visible, homographies of
+    // different basestations never match exactly and switching would make the position jump
+    uint8_t basestation = _localization_data.basestation;
+    if (!_fix_available(basestation)) {
+        for (basestation = 0; basestation < _basestations_count(); basestation++) {
+            if (_fix_available(basestation)) {
+                break;
+            }
+        }
+        if (basestation == _basestations_count()) {
+            return false;
+        }
+        _localization_data.basestation = basestation;
     }
+
+    // Processed locations are only updated by localization_process_data, from the same context,
+    // so the capture of the next sweeps can go on during the computation
+    db_lh2_calculate_position(_localization_data.lh2.locations[0][basestation].lfsr_location, _localization_data.lh2.locations[1][basestation].lfsr_location, basestation, _localization_data.coordinates);
+    position->x = (uint32_t)(_localization_data.coordinates[0] * 1e6);
+    position->y = (uint32_t)(_localization_data.coordinates[1] * 1e6);
+    // The same sweeps must not be used twice by the control loop
+    _localization_data.lh2.data_ready[0][basestation] = DB_LH2_NO_NEW_DATA;
+    _localization_data.lh2.data_ready[1][basestation] = DB_LH2_NO_NEW_DATA;
+    return true;
 }
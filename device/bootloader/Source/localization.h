@@ -13,8 +13,12 @@
  * @}
  */
 
+#include <stdbool.h>
 #include "protocol.h"
 
+#define LOCALIZATION_BASESTATIONS_MAX       (4U)            ///< Max number of LH2 basestations with a homography
+#define LOCALIZATION_CALIBRATION_ADDRESS    (0x000FF000UL)  ///< Flash page holding the homographies, after the user image
+
 /// DotBot protocol LH2 computed location
 typedef struct __attribute__((packed)) {
     uint32_t x;  ///< X coordinate, multiplied by 1e6
@@ -28,8 +32,34 @@ typedef struct __attribute__((packed)) {
 
 void localization_init(void);
 
+/**
+ * @brief   Store the homography of a basestation in flash and use it right away
+ *
+ * @param[in]   homography  Homography to store
+ *
+ * @return  false if the basestation index is not supported
+ */
+bool localization_store_homography(const localization_homography_t *homography);
+
+/**
+ * @brief   Resume the capture of the lighthouse sweeps
+ */
+void localization_start(void);
+
+/**
+ * @brief   Stop the capture of the lighthouse sweeps, to save power when the position is not needed
+ */
+void localization_stop(void);
+
 void localization_process_data(void);
 
-void localization_get_position(position_2d_t *position);
+/**
+ * @brief   Compute the position from the latest processed lighthouse data
+ *
+ * @param[out]  position    Computed position, left untouched if no new data is available
+ *
+ * @return  true if a new position was computed
+ */
+bool localization_get_position(position_2d_t *position);
 
 #endif // __LOCALIZATION_H
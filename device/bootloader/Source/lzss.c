@@ -0,0 +1,79 @@
+/**
+ * @file
+ * @ingroup drv_lzss
+ *
+ * @brief  Implementation of the LZSS streaming decompression
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lzss.h"
+
+//=========================== defines ==========================================
+
+typedef enum {
+    LZSS_STATE_FLAGS,       ///< Next byte is the flags of a group of tokens
+    LZSS_STATE_TOKEN,       ///< Next byte is a literal or the distance of a back reference
+    LZSS_STATE_LENGTH,      ///< Next byte is the length of a back reference
+} lzss_state_t;
+
+//=========================== private ==========================================
+
+static void _output(lzss_decoder_t *decoder, uint8_t byte) {
+    decoder->window[decoder->window_pos++] = byte;
+    decoder->output(byte);
+}
+
+static void _next_token(lzss_decoder_t *decoder) {
+    decoder->flags >>= 1;
+    decoder->flags_remaining--;
+    decoder->state = (decoder->flags_remaining == 0) ? LZSS_STATE_FLAGS : LZSS_STATE_TOKEN;
+}
+
+//=========================== public ===========================================
+
+void lzss_decoder_init(lzss_decoder_t *decoder, lzss_output_cb_t output) {
+    memset(decoder, 0, sizeof(lzss_decoder_t));
+    decoder->state  = LZSS_STATE_FLAGS;
+    decoder->output = output;
+}
+
+void lzss_decode(lzss_decoder_t *decoder, const uint8_t *input, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        uint8_t byte = input[i];
+        switch (decoder->state) {
+            case LZSS_STATE_FLAGS:
+                decoder->flags           = byte;
+                decoder->flags_remaining = 8;
+                decoder->state           = LZSS_STATE_TOKEN;
+                break;
+            case LZSS_STATE_TOKEN:
+                if (decoder->flags & 0x01) {
+                    _output(decoder, byte);
+                    _next_token(decoder);
+                } else {
+                    decoder->distance = byte;
+                    decoder->state    = LZSS_STATE_LENGTH;
+                }
+                break;
+            case LZSS_STATE_LENGTH:
+            {
+                // The window size is 256 so positions naturally wrap around on 8 bits
+                uint16_t match_length = byte + LZSS_MATCH_LENGTH_MIN;
+                for (uint16_t j = 0; j < match_length; j++) {
+                    uint8_t src = decoder->window_pos - decoder->distance - 1;
+                    _output(decoder, decoder->window[src]);
+                }
+                _next_token(decoder);
+            } break;
+            default:
+                break;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef __LZSS_H
+#define __LZSS_H
+
+/**
+ * @defgroup    drv_lzss    LZSS streaming decompression
+ * @ingroup     drv
+ * @brief       Decompress LZSS encoded data received in consecutive chunks
+ *
+ * The encoded stream is a sequence of groups of 8 tokens, each group being
+ * preceded by a flags byte. A set flag bit (LSB first) marks a literal byte,
+ * a cleared bit marks a 2 bytes back reference: distance - 1 and
+ * length - LZSS_MATCH_LENGTH_MIN. The matching encoder is implemented in
+ * testbed/swarmit/compress.py.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+//=========================== defines ==========================================
+
+#define LZSS_WINDOW_SIZE        (256U)  ///< Size of the history window, distances are encoded on 1 byte
+#define LZSS_MATCH_LENGTH_MIN   (3U)    ///< Shortest back reference length
+
+typedef void (*lzss_output_cb_t)(uint8_t byte);  ///< Function called for each decompressed byte
+
+typedef struct {
+    uint8_t             window[LZSS_WINDOW_SIZE];   ///< Last decompressed bytes
+    uint8_t             window_pos;                 ///< Position of the next byte in the window
+    uint8_t             state;                      ///< Expected type of the next input byte
+    uint8_t             flags;                      ///< Flags of the remaining tokens in the current group
+    uint8_t             flags_remaining;            ///< Number of remaining tokens in the current group
+    uint8_t             distance;                   ///< Distance of the back reference being decoded
+    lzss_output_cb_t    output;                     ///< Output callback
+} lzss_decoder_t;
+
+//=========================== public ===========================================
+
+/**
+ * @brief   Initialize a decoder, must be called before decoding a new stream
+ *
+ * @param[out]  decoder     Pointer to the decoder state
+ * @param[in]   output      Callback called for each decompressed byte
+ */
+void lzss_decoder_init(lzss_decoder_t *decoder, lzss_output_cb_t output);
+
+/**
+ * @brief   Decode the next bytes of the stream, tokens can span several calls
+ *
+ * @param[in]   decoder     Pointer to the decoder state
+ * @param[in]   input       Bytes of the encoded stream
+ * @param[in]   length      Number of input bytes
+ */
+void lzss_decode(lzss_decoder_t *decoder, const uint8_t *input, size_t length);
+
+#endif
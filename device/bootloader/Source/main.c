@@ -10,16 +10,19 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 
 #include <arm_cmse.h>
 #include <nrf.h>
 
 #include "battery.h"
 #include "ipc.h"
+#include "lzss.h"
 #include "nvmc.h"
+#include "profile.h"
 #include "protocol.h"
+#include "recorder.h"
 #include "mari.h"
+#include "timebase.h"
 #include "tz.h"
 
 // DotBot-firmware includes
@@ -28,40 +31,103 @@
 #include "localization.h"
 #include "motors.h"
 #include "move.h"
+#include "nav.h"
+#include "sha256.h"
 #include "timer.h"
 
 #define SWARMIT_BASE_ADDRESS        (0x10000)
+#define SWARMIT_IMAGE_MAX_SIZE      (RECORDER_ADDRESS - SWARMIT_BASE_ADDRESS)
+#define OTA_CHUNKS_MAX              (SWARMIT_IMAGE_MAX_SIZE / SWRMT_OTA_CHUNK_SIZE)  ///< Chunks of an image of max size, using the smallest chunk size
+#define SWARMIT_BASE_PAGE           (SWARMIT_BASE_ADDRESS / FLASH_PAGE_SIZE)
+#define OTA_PAGES_MAX               (SWARMIT_IMAGE_MAX_SIZE / FLASH_PAGE_SIZE)
+#define OTA_STAGING_SIZE            (256U)  ///< Size of the buffer of decompressed bytes written at once, multiple of 4
+#define OTA_METADATA_ADDRESS        (RECORDER_ADDRESS + RECORDER_SIZE)  ///< Flash page holding the progress of the OTA, between the records and the calibration page
+#define OTA_SESSION_MAGIC           (0x4F544153UL)  ///< Marks a complete session header in the OTA metadata page
+#define OTA_METADATA_PAGE           (OTA_METADATA_ADDRESS / FLASH_PAGE_SIZE)
+#define OTA_PAGES_LOG_ADDRESS       (OTA_METADATA_ADDRESS + sizeof(ota_session_t))  ///< Indexes of the pages fully written, one word each
 
 #define BATTERY_UPDATE_DELAY        (1000U)
-#define POSITION_UPDATE_DELAY_MS    (500U) ///< 100ms delay between each position update
-
-#define ROBOT_DISTANCE_THRESHOLD    (0.05)
-#define ROBOT_DIRECTION_THRESHOLD   (0.01)
+#define BATTERY_IDLE_UPDATE_DELAY   (10000U) ///< Battery update delay when idle in ready state
+#define POSITION_UPDATE_DELAY_MS    (500U) ///< 500ms delay between each position update, when not resetting
+#define POSITION_REFRESH_UPDATES    (10U)  ///< Max number of position updates waiting for a fix when refreshing the position in ready state
+#define DUTY_CYCLE_SCALE            (10000U) ///< Duty cycle is reported in 1/100 %
+#define CONTROL_LOOP_PERIOD_MS      (20U)  ///< 50Hz reset control loop, the position is dead reckoned between 2 lighthouse fixes
+
+#define ROBOT_DISTANCE_THRESHOLD    (50000U)    ///< Distance to target in um below which the target is reached
+#define ROBOT_DIRECTION_THRESHOLD   (10000U)    ///< Min distance in um between 2 positions to compute a direction
+#define ROBOT_REDUCE_SPEED_DISTANCE (200000U)   ///< Distance to target in um below which the speed is reduced
 #define ROBOT_ROTATE_SPEED          (45)
 #define ROBOT_STRAIGHT_SPEED        (45)
 #define ROBOT_MAX_SPEED             (50)   ///< Max speed in autonomous control mode
-#define ROBOT_REDUCE_SPEED_FACTOR   (0.8)  ///< Reduction factor applied to speed when close to target or error angle is too large
+#define ROBOT_REDUCE_SPEED_PERCENT  (80)   ///< Reduction factor in % applied to speed when close to target or error angle is too large
 #define ROBOT_REDUCE_SPEED_ANGLE    (25)   ///< Max angle amplitude where speed reduction factor is applied
 #define ROBOT_ANGULAR_SPEED_FACTOR  (35)   ///< Constant applied to the normalized angle to target error
 #define ROBOT_ANGULAR_SIDE_FACTOR   (-1)   ///< Angular side factor
+#define ROBOT_WHEEL_SPEED_UM_S      (2000) ///< Wheel speed in um/s for each unit of motor speed, used for dead reckoning
+#define ROBOT_WHEEL_BASE_UM         (60000) ///< Distance between the 2 wheels in um, used for dead reckoning
+#define ROBOT_HEADING_FUSION_PERCENT (50)  ///< Weight in % of the heading measured between 2 fixes versus the dead reckoned one
 
 extern volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
 
+/// Image of an OTA, an OTA interrupted by a reboot is resumed if the next start request matches the stored one
+typedef struct __attribute__((packed)) {
+    uint32_t image_size;
+    uint32_t chunk_count;
+    uint32_t chunk_size;
+    uint8_t  compression;
+    uint8_t  reserved[3];
+    uint8_t  image_hash[SWRMT_OTA_SHA256_LENGTH];
+    uint32_t session_id;    ///< Set by the controller to flash the same image again from scratch
+    uint32_t magic;     ///< Written last in flash, the header of an interrupted write doesn't match
+} ota_session_t;
+
 typedef struct {
     uint8_t         notification_buffer[255]  __attribute__((aligned));
     uint32_t        base_addr;
     bool            ota_start_request;
-    bool            ota_require_erase;
+    ota_session_t   ota_session;                                    ///< Image of the current OTA, zeroed when there is none
+    uint8_t         ota_pages_erased[(OTA_PAGES_MAX + 7) / 8];      ///< Bitmap of the pages ready to be written
+    uint8_t         ota_pages_done[(OTA_PAGES_MAX + 7) / 8];        ///< Bitmap of the pages fully written, logged in flash
+    uint32_t        ota_pages_logged;                               ///< Number of entries of the pages log
     bool            ota_chunk_request;
+    bool            ota_chunk_bitmap_request;
+    bool            ota_page_hashes_request;
+    bool            record_read_request;
+    uint8_t         ota_chunks_bitmap[OTA_CHUNKS_MAX / 8];  ///< Bitmap of the chunks written during the current OTA
+    uint32_t        ota_chunks_written;
+    lzss_decoder_t  ota_decoder;                                    ///< Decoder state of a compressed image
+    uint32_t        ota_next_chunk;                                 ///< Index of the next compressed chunk to decode
+    uint32_t        ota_write_offset;                               ///< Offset in the image of the next staged bytes
+    uint32_t        ota_staging[OTA_STAGING_SIZE / sizeof(uint32_t)];  ///< Word aligned buffer of decompressed bytes
+    uint32_t        ota_staging_length;
+    bool            ota_overflow;                                   ///< Decompressed image is larger than announced
+    uint8_t         ota_image_hash[SWRMT_OTA_SHA256_LENGTH];
+    uint32_t        ota_hash_offset;                                ///< Number of image bytes already hashed
+    uint32_t        ota_hash_next_chunk;                            ///< Index of the first chunk not hashed yet
+    bool            ota_image_complete;                             ///< All chunks were written and the image verified
+    bool            ota_image_valid;                                ///< Result of the image verification
+    uint8_t         ota_page_hash[SWRMT_OTA_SHA256_LENGTH];
     bool            start_application;
-    position_2d_t   last_position;
     bool            position_update;
+    bool            control_update;
+    bool            calibration_request;
+    bool            reset_request;
     bool            battery_update;
+    uint32_t        battery_delay_ms;                               ///< Delay of the pending battery update
+    uint32_t        battery_update_cycles;                          ///< Cycle counter at the previous battery update
+    bool            localization_running;                           ///< Lighthouse sweeps are captured
+    uint8_t         position_refresh;                               ///< Remaining position updates to get a fix in ready state
 } bootloader_app_data_t;
 
 typedef struct {
-    position_2d_t   previous_position;
+    position_2d_t   previous_position;  ///< Latest fix used to measure the direction
+    position_2d_t   position;           ///< Estimated position, dead reckoned between 2 fixes
+    bool            position_known;
+    uint8_t         waypoint_index;     ///< Index of the reset waypoint being reached
     int16_t         direction;
+    int32_t         direction_q16;      ///< Estimated direction in Q16 degrees, keeps the dead reckoned fractions
+    int16_t         left_speed;         ///< Latest motors speed, used for dead reckoning
+    int16_t         right_speed;
     bool            initial_direction_compensated;
     bool            final_direction_compensated;
     bool            target_reached;
@@ -210,7 +276,6 @@ static void setup_ns_user(void) {
     NVIC_SetTargetState(TIMER1_IRQn);
     NVIC_SetTargetState(USBD_IRQn);
     NVIC_SetTargetState(USBREGULATOR_IRQn);
-    NVIC_SetTargetState(GPIOTE0_IRQn);
     NVIC_SetTargetState(GPIOTE1_IRQn);
 
     // All GPIOs are non secure
@@ -222,34 +287,359 @@ static void setup_ns_user(void) {
 }
 
 static void _update_position(void) {
-    puts("Update position");
     _bootloader_vars.position_update = true;
 }
 
+static void _update_control(void) {
+    _bootloader_vars.control_update = true;
+}
+
 static void _read_battery(void) {
     _bootloader_vars.battery_update = true;
 }
 
+static void _schedule_battery_update(void) {
+    // Nothing happens while idle in ready state, the battery level doesn't need to be fresh
+    bool idle = (ipc_shared_data.status == SWRMT_APPLICATION_READY) && !_bootloader_vars.localization_running;
+    _bootloader_vars.battery_delay_ms = idle ? BATTERY_IDLE_UPDATE_DELAY : BATTERY_UPDATE_DELAY;
+    db_timer_set_oneshot_ms(1, 2, _bootloader_vars.battery_delay_ms, &_read_battery);
+}
+
+static void _update_duty_cycle(void) {
+    // The cycle counter is stopped while the core sleeps, it only counts the active cycles
+    uint32_t cycles = DWT->CYCCNT;
+    uint64_t active = (uint64_t)(cycles - _bootloader_vars.battery_update_cycles) * DUTY_CYCLE_SCALE;
+    uint64_t duty_cycle = active / ((uint64_t)_bootloader_vars.battery_delay_ms * (SystemCoreClock / 1000));
+    ipc_shared_data.duty_cycle = (uint16_t)((duty_cycle > DUTY_CYCLE_SCALE) ? DUTY_CYCLE_SCALE : duty_cycle);
+    _bootloader_vars.battery_update_cycles = cycles;
+}
+
+static bool _ota_chunk_is_written(uint32_t index) {
+    return (_bootloader_vars.ota_chunks_bitmap[index >> 3] & (1 << (index & 0x07))) != 0;
+}
+
+static void _ota_chunk_set_written(uint32_t index) {
+    _bootloader_vars.ota_chunks_bitmap[index >> 3] |= (1 << (index & 0x07));
+    _bootloader_vars.ota_chunks_written++;
+}
+
+static bool _ota_page_is_done(uint32_t page) {
+    return (_bootloader_vars.ota_pages_done[page >> 3] & (1 << (page & 0x07))) != 0;
+}
+
+static bool _ota_page_is_changed(uint32_t page) {
+    // Pages fully written before a reboot already hold the new image
+    if (_ota_page_is_done(page)) {
+        return false;
+    }
+
+    // Without delta, or when the image is compressed, all pages of the image are rewritten
+    if (!ipc_shared_data.ota.delta || ipc_shared_data.ota.compression != SWRMT_OTA_COMPRESSION_NONE) {
+        return true;
+    }
+    return (ipc_shared_data.ota.pages_bitmap[page >> 3] & (1 << (page & 0x07))) != 0;
+}
+
+static bool _ota_chunk_is_changed(uint32_t index) {
+    uint32_t start = index * ipc_shared_data.ota.nominal_chunk_size;
+    uint32_t end = start + ipc_shared_data.ota.nominal_chunk_size - 1;
+    for (uint32_t page = start / FLASH_PAGE_SIZE; page <= end / FLASH_PAGE_SIZE; page++) {
+        if (_ota_page_is_changed(page)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _ota_page_set_done(uint32_t page) {
+    _bootloader_vars.ota_pages_done[page >> 3] |= (1 << (page & 0x07));
+    uint32_t entry = page;
+    nvmc_write((const uint32_t *)OTA_PAGES_LOG_ADDRESS + _bootloader_vars.ota_pages_logged, &entry, sizeof(uint32_t));
+    _bootloader_vars.ota_pages_logged++;
+}
+
+static void _ota_log_written_pages(uint32_t chunk_index) {
+    // A page is logged once all the chunks it overlaps are written, the last chunk can end before the page
+    uint32_t chunk_size = ipc_shared_data.ota.nominal_chunk_size;
+    uint32_t start = chunk_index * chunk_size;
+    uint32_t end = start + chunk_size - 1;
+    for (uint32_t page = start / FLASH_PAGE_SIZE; page <= end / FLASH_PAGE_SIZE && page < OTA_PAGES_MAX; page++) {
+        if (_ota_page_is_done(page)) {
+            continue;
+        }
+        uint32_t first = (page * FLASH_PAGE_SIZE) / chunk_size;
+        uint32_t last = ((page + 1) * FLASH_PAGE_SIZE - 1) / chunk_size;
+        if (last >= ipc_shared_data.ota.chunk_count) {
+            last = ipc_shared_data.ota.chunk_count - 1;
+        }
+        bool complete = true;
+        for (uint32_t index = first; index <= last && complete; index++) {
+            complete = _ota_chunk_is_written(index);
+        }
+        if (complete) {
+            _ota_page_set_done(page);
+        }
+    }
+}
+
+static void _ota_prepare_page(uint32_t page) {
+    if (_bootloader_vars.ota_pages_erased[page >> 3] & (1 << (page & 0x07))) {
+        return;
+    }
+
+    // Pages that are already blank, e.g. beyond the previous image, are not erased again
+    if (!nvmc_page_is_blank(SWARMIT_BASE_PAGE + page)) {
+        printf("Erasing page %u at %p\n", SWARMIT_BASE_PAGE + page, (uint32_t *)(_bootloader_vars.base_addr + page * FLASH_PAGE_SIZE));
+        nvmc_page_erase(SWARMIT_BASE_PAGE + page);
+    }
+    _bootloader_vars.ota_pages_erased[page >> 3] |= (1 << (page & 0x07));
+}
+
+static void _ota_write(uint32_t offset, const uint8_t *data, uint32_t length) {
+    // Split the write at page boundaries, pages are erased before their first write
+    // and unchanged pages already contain the right content
+    while (length) {
+        uint32_t page = offset / FLASH_PAGE_SIZE;
+        uint32_t segment = FLASH_PAGE_SIZE - (offset % FLASH_PAGE_SIZE);
+        if (segment > length) {
+            segment = length;
+        }
+        if (_ota_page_is_changed(page)) {
+            _ota_prepare_page(page);
+            nvmc_write((uint32_t *)(_bootloader_vars.base_addr + offset), data, segment);
+        }
+        offset += segment;
+        data += segment;
+        length -= segment;
+    }
+}
+
+static void _ota_flush_staging(void) {
+    uint32_t length = _bootloader_vars.ota_staging_length;
+    if (length == 0) {
+        return;
+    }
+
+    // Flash is written by words, only the last flush of an image can be incomplete
+    uint32_t write_size = (length + 3) & ~0x03;
+    memset((uint8_t *)_bootloader_vars.ota_staging + length, 0xFF, write_size - length);
+    _ota_write(_bootloader_vars.ota_write_offset, (const uint8_t *)_bootloader_vars.ota_staging, write_size);
+    _bootloader_vars.ota_write_offset += length;
+    _bootloader_vars.ota_staging_length = 0;
+}
+
+static void _ota_decompressed_byte(uint8_t byte) {
+    if (_bootloader_vars.ota_write_offset + _bootloader_vars.ota_staging_length >= ipc_shared_data.ota.image_size) {
+        _bootloader_vars.ota_overflow = true;
+        return;
+    }
+
+    ((uint8_t *)_bootloader_vars.ota_staging)[_bootloader_vars.ota_staging_length++] = byte;
+    if (_bootloader_vars.ota_staging_length == OTA_STAGING_SIZE) {
+        _ota_flush_staging();
+    }
+}
+
+static void _ota_hash_update(void) {
+    // The image hash is computed in order, as soon as the beginning of the image is written
+    uint32_t written = 0;
+    if (ipc_shared_data.ota.compression == SWRMT_OTA_COMPRESSION_LZSS) {
+        written = _bootloader_vars.ota_write_offset;
+    } else {
+        while (_bootloader_vars.ota_hash_next_chunk < ipc_shared_data.ota.chunk_count && _ota_chunk_is_written(_bootloader_vars.ota_hash_next_chunk)) {
+            _bootloader_vars.ota_hash_next_chunk++;
+        }
+        written = _bootloader_vars.ota_hash_next_chunk * ipc_shared_data.ota.nominal_chunk_size;
+        if (written > ipc_shared_data.ota.image_size) {
+            written = ipc_shared_data.ota.image_size;
+        }
+    }
+
+    if (written > _bootloader_vars.ota_hash_offset) {
+        crypto_sha256_update((const uint8_t *)(_bootloader_vars.base_addr + _bootloader_vars.ota_hash_offset), written - _bootloader_vars.ota_hash_offset);
+        _bootloader_vars.ota_hash_offset = written;
+    }
+}
+
+static bool _ota_image_verify(void) {
+    _ota_hash_update();
+    if (_bootloader_vars.ota_overflow || _bootloader_vars.ota_hash_offset != ipc_shared_data.ota.image_size) {
+        return false;
+    }
+
+    crypto_sha256(_bootloader_vars.ota_image_hash);
+    return memcmp(_bootloader_vars.ota_image_hash, (const uint8_t *)ipc_shared_data.ota.image_hash, SWRMT_OTA_SHA256_LENGTH) == 0;
+}
+
+static void _ota_session_init(const ota_session_t *session) {
+    _bootloader_vars.ota_session = *session;
+    // Drop the chunks of a previous OTA still queued
+    ipc_shared_data.ota.chunk_tail = ipc_shared_data.ota.chunk_head;
+    memset(_bootloader_vars.ota_pages_erased, 0, sizeof(_bootloader_vars.ota_pages_erased));
+    memset(_bootloader_vars.ota_pages_done, 0, sizeof(_bootloader_vars.ota_pages_done));
+    _bootloader_vars.ota_pages_logged = 0;
+    memset(_bootloader_vars.ota_chunks_bitmap, 0, sizeof(_bootloader_vars.ota_chunks_bitmap));
+    _bootloader_vars.ota_chunks_written = 0;
+    lzss_decoder_init(&_bootloader_vars.ota_decoder, _ota_decompressed_byte);
+    _bootloader_vars.ota_next_chunk = 0;
+    _bootloader_vars.ota_write_offset = 0;
+    _bootloader_vars.ota_staging_length = 0;
+    _bootloader_vars.ota_overflow = false;
+    _bootloader_vars.ota_hash_offset = 0;
+    _bootloader_vars.ota_hash_next_chunk = 0;
+    _bootloader_vars.ota_image_complete = false;
+    _bootloader_vars.ota_image_valid = false;
+    crypto_sha256_init();
+}
+
+static void _ota_session_store(void) {
+    // The progress of the previous OTA is dropped before its image is overwritten
+    if (!nvmc_page_is_blank(OTA_METADATA_PAGE)) {
+        nvmc_page_erase(OTA_METADATA_PAGE);
+    }
+
+    // Compressed images are decoded in order, they are not resumed after a reboot
+    if (_bootloader_vars.ota_session.compression == SWRMT_OTA_COMPRESSION_NONE) {
+        nvmc_write((const uint32_t *)OTA_METADATA_ADDRESS, &_bootloader_vars.ota_session, sizeof(ota_session_t));
+    }
+}
+
+static void _ota_session_restore(void) {
+    // Chunks are written again unless all the pages they overlap were logged, partially written pages
+    // are erased again when first written
+    const uint32_t *log = (const uint32_t *)OTA_PAGES_LOG_ADDRESS;
+    while (_bootloader_vars.ota_pages_logged < OTA_PAGES_MAX && log[_bootloader_vars.ota_pages_logged] != UINT32_MAX) {
+        uint32_t page = log[_bootloader_vars.ota_pages_logged++];
+        if (page < OTA_PAGES_MAX) {
+            _bootloader_vars.ota_pages_done[page >> 3] |= (1 << (page & 0x07));
+        }
+    }
+    printf("OTA resumed with %u pages written\n", _bootloader_vars.ota_pages_logged);
+}
+
+static void _ota_session_clear(void) {
+    // The next start request is a new OTA, even for the same image
+    memset(&_bootloader_vars.ota_session, 0, sizeof(ota_session_t));
+    if (!nvmc_page_is_blank(OTA_METADATA_PAGE)) {
+        nvmc_page_erase(OTA_METADATA_PAGE);
+    }
+}
+
+static void _ota_notify_verify(void) {
+    size_t length = 0;
+    _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_VERIFY;
+    _bootloader_vars.notification_buffer[length++] = _bootloader_vars.ota_image_valid;
+    mari_node_tx(_bootloader_vars.notification_buffer, length);
+}
+
+static void _ota_complete(void) {
+    // A start request for the same image only notifies the result again
+    _bootloader_vars.ota_image_complete = true;
+    _ota_flush_staging();
+    _bootloader_vars.ota_image_valid = _ota_image_verify();
+    if (_bootloader_vars.ota_image_valid) {
+        puts("Image verified");
+        ipc_shared_data.status = SWRMT_APPLICATION_READY;
+    } else {
+        // Stay in programming state so the image cannot be started
+        puts("Image verification failed");
+        _ota_session_clear();
+    }
+    _ota_notify_verify();
+}
+
+static void _ota_process_chunk(uint32_t chunk_index, uint8_t *chunk, uint32_t chunk_size) {
+    bool chunk_written = false;
+    if (!_ota_chunk_is_written(chunk_index) && ipc_shared_data.ota.compression == SWRMT_OTA_COMPRESSION_LZSS) {
+        // Compressed chunks depend on the previous ones so they are decompressed in order,
+        // out of order chunks are dropped and will be sent again by the controller
+        if (chunk_index == _bootloader_vars.ota_next_chunk) {
+            printf("Decompressing chunk %d/%d at offset %u\n", chunk_index, ipc_shared_data.ota.chunk_count - 1, _bootloader_vars.ota_write_offset + _bootloader_vars.ota_staging_length);
+            lzss_decode(&_bootloader_vars.ota_decoder, chunk, chunk_size);
+            _bootloader_vars.ota_next_chunk++;
+            chunk_written = true;
+        }
+    } else if (!_ota_chunk_is_written(chunk_index)) {
+        // Write chunk to flash
+        uint32_t addr = _bootloader_vars.base_addr + chunk_index * ipc_shared_data.ota.nominal_chunk_size;
+        // Flash is written by words, pad the last chunk with erased flash value
+        uint32_t write_size = (chunk_size + 3) & ~0x03;
+        memset(chunk + chunk_size, 0xFF, write_size - chunk_size);
+        printf("Writing chunk %d/%d at address %p\n", chunk_index, ipc_shared_data.ota.chunk_count - 1, (uint32_t *)addr);
+        _ota_write(addr - _bootloader_vars.base_addr, chunk, write_size);
+        chunk_written = true;
+    }
+
+    if (chunk_written) {
+        _ota_chunk_set_written(chunk_index);
+        if (ipc_shared_data.ota.compression == SWRMT_OTA_COMPRESSION_NONE) {
+            _ota_log_written_pages(chunk_index);
+        }
+        _ota_hash_update();
+    }
+    ipc_shared_data.ota.last_chunk_acked = chunk_index;
+
+    // Notify chunk has been written, in windowed mode chunks are acknowledged on demand with a bitmap
+    if (ipc_shared_data.ota.mode == SWRMT_OTA_MODE_STOP_AND_WAIT && _ota_chunk_is_written(chunk_index)) {
+        size_t length = 0;
+        _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_CHUNK_ACK;
+        memcpy(_bootloader_vars.notification_buffer + length, &chunk_index, sizeof(uint32_t));
+        length += sizeof(uint32_t);
+        mari_node_tx(_bootloader_vars.notification_buffer, length);
+    }
+
+    // If all chunks are written, verify the image and set back to ready state. The result is
+    // sent again when a chunk is received after completion, in case the notification was lost
+    if (chunk_written && _bootloader_vars.ota_chunks_written == ipc_shared_data.ota.chunk_count) {
+        _ota_complete();
+    } else if (_bootloader_vars.ota_image_complete) {
+        _ota_notify_verify();
+    }
+}
+
 static void _compute_angle(const position_2d_t *head, const position_2d_t *tail, int16_t *angle) {
-    float dx = ((float)head->x / 1e6) - ((float)tail->x / 1e6);
-    float dy = ((float)head->y / 1e6) - ((float)tail->y / 1e6);
-    float distance = sqrtf(powf(dx, 2) + powf(dy, 2));
+    uint32_t distance = 0;
+    int16_t result = nav_heading(head, tail, &distance);
 
     if (distance < ROBOT_DIRECTION_THRESHOLD) {
         return;
     }
 
-    int8_t sideFactor = (dx > 0) ? -1 : 1;
-    int16_t result = (int16_t)(acosf(dy / distance) * 180 / M_PI) * sideFactor;
-    if (result < -360) {
-        result += 360;
-    }
     *angle = result;
 }
 
+static int16_t _wrap_angle(int16_t angle) {
+    if (angle < -180) {
+        return angle + 360;
+    } else if (angle > 180) {
+        return angle - 360;
+    }
+    return angle;
+}
+
+static void _set_direction_q16(int32_t direction) {
+    if (direction <= -(180 << 16)) {
+        direction += 360 << 16;
+    } else if (direction > (180 << 16)) {
+        direction -= 360 << 16;
+    }
+    _control_loop_vars.direction_q16 = direction;
+    _control_loop_vars.direction = _wrap_angle((int16_t)((direction + (1 << 15)) >> 16));
+}
+
+static void _set_motors_speed(int16_t left_speed, int16_t right_speed) {
+    _control_loop_vars.left_speed = left_speed;
+    _control_loop_vars.right_speed = right_speed;
+    db_motors_set_speed(left_speed, right_speed);
+}
+
 static void _compensate_angle(int16_t angle) {
     int8_t speed = ROBOT_ROTATE_SPEED * -1;
 
+    // Motors are stopped once the rotation is done
+    _control_loop_vars.left_speed = 0;
+    _control_loop_vars.right_speed = 0;
+
     if (angle < 0) {
         speed *= -1;
         angle *= -1;
@@ -266,9 +656,10 @@ static void _compensate_initial_direction(void) {
 
     // Compute angle to target and rotate
     int16_t angle_to_target = 0;
-    _compute_angle((const position_2d_t *)&ipc_shared_data.target_position, (const position_2d_t *)&_bootloader_vars.last_position, &angle_to_target);
-    int16_t error_angle = angle_to_target - _control_loop_vars.direction;
+    _compute_angle((const position_2d_t *)&ipc_shared_data.target_position, &_control_loop_vars.position, &angle_to_target);
+    int16_t error_angle = _wrap_angle(angle_to_target - _control_loop_vars.direction);
     _compensate_angle(error_angle);
+    _set_direction_q16((int32_t)angle_to_target << 16);
     db_move_straight(ROBOT_STRAIGHT_SPEED, ROBOT_STRAIGHT_SPEED);
     _control_loop_vars.initial_direction_compensated = true;
 }
@@ -278,41 +669,33 @@ static void _update_control_loop(void) {
         return;
     }
 
-    float dx = ((float)ipc_shared_data.target_position.x / 1e6) - ((float)_bootloader_vars.last_position.x / 1e6);
-    float dy = ((float)ipc_shared_data.target_position.y / 1e6) - ((float)_bootloader_vars.last_position.y / 1e6);
-    float distanceToTarget = sqrtf(powf(dx, 2) + powf(dy, 2));
-    float speedReductionFactor = 1.0;  // No reduction by default
+    uint32_t distanceToTarget = 0;
+    int16_t angle_to_target = nav_heading((const position_2d_t *)&ipc_shared_data.target_position, &_control_loop_vars.position, &distanceToTarget);
+    int16_t speedReductionFactor = 100;  // No reduction by default
 
-    if ((uint32_t)(distanceToTarget) < 0.2) {
-        speedReductionFactor = ROBOT_REDUCE_SPEED_FACTOR;
+    if (distanceToTarget < ROBOT_REDUCE_SPEED_DISTANCE) {
+        speedReductionFactor = ROBOT_REDUCE_SPEED_PERCENT;
     }
 
     int16_t left_speed      = 0;
     int16_t right_speed     = 0;
     int16_t angular_speed   = 0;
     int16_t error_angle     = 0;
-    int16_t angle_to_target = 0;
     if (distanceToTarget < ROBOT_DISTANCE_THRESHOLD) {
         _control_loop_vars.target_reached = true;
      } else if (_control_loop_vars.direction == -1000) {
         // Unknown direction, just move forward a bit
-        left_speed  = (int16_t)ROBOT_MAX_SPEED * speedReductionFactor;
-        right_speed = (int16_t)ROBOT_MAX_SPEED * speedReductionFactor;
+        left_speed  = ROBOT_MAX_SPEED * speedReductionFactor / 100;
+        right_speed = ROBOT_MAX_SPEED * speedReductionFactor / 100;
     } else {
         // compute angle to target waypoint
-        _compute_angle((const position_2d_t *)&ipc_shared_data.target_position, (const position_2d_t *)&_bootloader_vars.last_position, &angle_to_target);
-        error_angle = angle_to_target - _control_loop_vars.direction;
-        if (error_angle < -180) {
-            error_angle += 360;
-        } else if (error_angle > 180) {
-            error_angle -= 360;
-        }
+        error_angle = _wrap_angle(angle_to_target - _control_loop_vars.direction);
         if (error_angle > ROBOT_REDUCE_SPEED_ANGLE || error_angle < -ROBOT_REDUCE_SPEED_ANGLE) {
-            speedReductionFactor = ROBOT_REDUCE_SPEED_FACTOR;
+            speedReductionFactor = ROBOT_REDUCE_SPEED_PERCENT;
         }
-        angular_speed = (int16_t)(((float)error_angle / 180) * ROBOT_ANGULAR_SPEED_FACTOR);
-        left_speed    = (int16_t)(((ROBOT_MAX_SPEED * speedReductionFactor) - (angular_speed * ROBOT_ANGULAR_SIDE_FACTOR)));
-        right_speed   = (int16_t)(((ROBOT_MAX_SPEED * speedReductionFactor) + (angular_speed * ROBOT_ANGULAR_SIDE_FACTOR)));
+        angular_speed = error_angle * ROBOT_ANGULAR_SPEED_FACTOR / 180;
+        left_speed    = (ROBOT_MAX_SPEED * speedReductionFactor / 100) - (angular_speed * ROBOT_ANGULAR_SIDE_FACTOR);
+        right_speed   = (ROBOT_MAX_SPEED * speedReductionFactor / 100) + (angular_speed * ROBOT_ANGULAR_SIDE_FACTOR);
         if (left_speed > ROBOT_MAX_SPEED) {
             left_speed = ROBOT_MAX_SPEED;
         }
@@ -321,12 +704,114 @@ static void _update_control_loop(void) {
         }
     }
 
-    db_motors_set_speed(left_speed, right_speed);
+    _set_motors_speed(left_speed, right_speed);
+}
+
+static void _fuse_position(const position_2d_t *fix) {
+    _control_loop_vars.position = *fix;
+    if (!_control_loop_vars.position_known) {
+        _control_loop_vars.position_known = true;
+        _control_loop_vars.previous_position = *fix;
+        return;
+    }
+
+    // The direction is measured once the robot moved far enough since the previous fix used
+    int16_t measured_direction = -1000;
+    _compute_angle(fix, &_control_loop_vars.previous_position, &measured_direction);
+    if (measured_direction == -1000) {
+        return;
+    }
+    _control_loop_vars.previous_position = *fix;
+
+    if (_control_loop_vars.direction == -1000) {
+        _set_direction_q16((int32_t)measured_direction << 16);
+        return;
+    }
+    int32_t error = _wrap_angle(measured_direction - _control_loop_vars.direction);
+    _set_direction_q16(_control_loop_vars.direction_q16 + (error << 16) * ROBOT_HEADING_FUSION_PERCENT / 100);
+}
+
+static void _dead_reckoning(void) {
+    if (!_control_loop_vars.position_known || _control_loop_vars.direction == -1000) {
+        return;
+    }
+
+    // Differential drive model driven by the latest motors speed
+    int32_t left_speed = _control_loop_vars.left_speed;
+    int32_t right_speed = _control_loop_vars.right_speed;
+    int32_t distance = (left_speed + right_speed) * ROBOT_WHEEL_SPEED_UM_S * (int32_t)CONTROL_LOOP_PERIOD_MS / 2000;
+    int64_t rotation = (int64_t)(left_speed - right_speed) * -ROBOT_ANGULAR_SIDE_FACTOR * ROBOT_WHEEL_SPEED_UM_S * CONTROL_LOOP_PERIOD_MS * NAV_Q16_DEGREES_PER_RADIAN / (1000LL * ROBOT_WHEEL_BASE_UM);
+
+    // Move along the mean heading of the period
+    nav_advance(&_control_loop_vars.position, _control_loop_vars.direction_q16 + (int32_t)(rotation / 2), distance);
+    _set_direction_q16(_control_loop_vars.direction_q16 + (int32_t)rotation);
+}
+
+static void _control_loop_reset(void) {
+    _control_loop_vars.direction = -1000;
+    _control_loop_vars.target_reached = false;
+    _control_loop_vars.initial_direction_compensated = false;
+    _control_loop_vars.final_direction_compensated = false;
+    _control_loop_vars.position_known = false;
+    _control_loop_vars.waypoint_index = 0;
+    _control_loop_vars.left_speed = 0;
+    _control_loop_vars.right_speed = 0;
+}
+
+static void _control_loop_step(void) {
+    position_2d_t fix = { 0 };
+    bool fix_available = localization_get_position(&fix);
+    if (fix_available) {
+        ipc_shared_data.current_position.x = fix.x;
+        ipc_shared_data.current_position.y = fix.y;
+        _fuse_position(&fix);
+    } else {
+        _dead_reckoning();
+    }
+
+    if (!_control_loop_vars.position_known) {
+        return;
+    }
+
+    // The initial direction is searched with blocking moves, only retry on new fixes
+    if (!_control_loop_vars.initial_direction_compensated) {
+        if (fix_available) {
+            _compensate_initial_direction();
+        }
+        return;
+    }
+
+    if (!_control_loop_vars.target_reached) {
+        _update_control_loop();
+    }
+
+    // Intermediate waypoints are passed through without stopping
+    if (_control_loop_vars.target_reached && _control_loop_vars.waypoint_index + 1 < ipc_shared_data.reset_waypoints_count) {
+        _control_loop_vars.waypoint_index++;
+        ipc_shared_data.target_position.x = ipc_shared_data.reset_waypoints[_control_loop_vars.waypoint_index].x;
+        ipc_shared_data.target_position.y = ipc_shared_data.reset_waypoints[_control_loop_vars.waypoint_index].y;
+        _control_loop_vars.target_reached = false;
+        _update_control_loop();
+        return;
+    }
+
+    if (_control_loop_vars.target_reached) {
+        _compensate_angle(_control_loop_vars.direction);
+        ipc_shared_data.status = SWRMT_APPLICATION_READY;
+        _control_loop_reset();
+    }
 }
 
 int main(void) {
 
+    // Active cycles are counted to measure the boot time, report the duty cycle and profile the secure code
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    profile_init();
+
     setup_watchdog1();
+    timebase_init();
 
     // First 4 flash regions (64kiB) is secure and contains the bootloader
     tz_configure_flash_secure(0, 4);
@@ -344,17 +829,29 @@ int main(void) {
                             1 << IPC_CHAN_RADIO_RX |
                             1 << IPC_CHAN_OTA_START |
                             1 << IPC_CHAN_OTA_CHUNK |
-                            1 << IPC_CHAN_APPLICATION_START
-                            //1 << IPC_CHAN_APPLICATION_RESET
+                            1 << IPC_CHAN_OTA_CHUNK_BITMAP |
+                            1 << IPC_CHAN_OTA_PAGE_HASHES |
+                            1 << IPC_CHAN_REQ_ACK |
+                            1 << IPC_CHAN_CALIBRATION |
+                            1 << IPC_CHAN_RECORD_READ |
+                            1 << IPC_CHAN_APPLICATION_START |
+                            1 << IPC_CHAN_APPLICATION_RESET
                         );
     NRF_IPC_S->SEND_CNF[IPC_CHAN_REQ]                   = 1 << IPC_CHAN_REQ;
     NRF_IPC_S->SEND_CNF[IPC_CHAN_LOG_EVENT]             = 1 << IPC_CHAN_LOG_EVENT;
+    NRF_IPC_S->SEND_CNF[IPC_CHAN_RADIO_TX]              = 1 << IPC_CHAN_RADIO_TX;
     NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_RADIO_RX]           = 1 << IPC_CHAN_RADIO_RX;
     NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_APPLICATION_START]  = 1 << IPC_CHAN_APPLICATION_START;
     NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_APPLICATION_STOP]   = 1 << IPC_CHAN_APPLICATION_STOP;
-    //NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_APPLICATION_RESET]  = 1 << IPC_CHAN_APPLICATION_RESET;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_APPLICATION_RESET]  = 1 << IPC_CHAN_APPLICATION_RESET;
     NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_OTA_START]          = 1 << IPC_CHAN_OTA_START;
     NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_OTA_CHUNK]          = 1 << IPC_CHAN_OTA_CHUNK;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_OTA_CHUNK_BITMAP]   = 1 << IPC_CHAN_OTA_CHUNK_BITMAP;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_OTA_PAGE_HASHES]    = 1 << IPC_CHAN_OTA_PAGE_HASHES;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_REQ_ACK]            = 1 << IPC_CHAN_REQ_ACK;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_CALIBRATION]        = 1 << IPC_CHAN_CALIBRATION;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_RECORD_READ]        = 1 << IPC_CHAN_RECORD_READ;
+    NRF_IPC_S->RECEIVE_CNF[IPC_CHAN_TIME_ANCHOR]        = 1 << IPC_CHAN_TIME_ANCHOR;
     NVIC_EnableIRQ(IPC_IRQn);
     NVIC_ClearPendingIRQ(IPC_IRQn);
     NVIC_SetPriority(IPC_IRQn, IPC_IRQ_PRIORITY);
@@ -379,15 +876,9 @@ int main(void) {
     ipc_shared_data.device_type = SWRMT_DEVICE_TYPE_UNKNOWN;
 #endif
 
-    // Start the network core
+    // Start the network core, returns right away if it kept running since the previous boot
     release_network_core();
-
-    mari_init();
-
-    battery_level_init();
-    ipc_shared_data.battery_level = battery_level_read();
-
-    localization_init();
+    ipc_time_init();
 
     // Check reset reason and switch to user image if reset was not triggered by any wdt timeout
     uint32_t resetreas = NRF_RESET_S->RESETREAS;
@@ -395,6 +886,8 @@ int main(void) {
 
      //Boot user image after soft system reset
     if (resetreas & RESET_RESETREAS_SREQ_Detected << RESET_RESETREAS_SREQ_Pos) {
+        // Mari is still running in the network core since the start request, the battery level
+        // and the localization are initialized on first use so the image starts as soon as possible
         // Experiment is running
         ipc_shared_data.status = SWRMT_APPLICATION_RUNNING;
 
@@ -412,6 +905,8 @@ int main(void) {
         // Flush and refill pipeline
         __ISB();
 
+        ipc_shared_data.boot_time_us = DWT->CYCCNT / (SystemCoreClock / 1000000);
+
         // Jump to non secure image
         reset_handler_t reset_handler_ns = (reset_handler_t)(cmse_nsfptr_create(table->reset_handler));
         reset_handler_ns();
@@ -419,14 +914,20 @@ int main(void) {
         while (1) {}
     }
 
+    mari_init();
+
+    battery_level_init();
+    ipc_shared_data.battery_level = battery_level_read();
+
+    localization_init();
+
+    // Records buffered by the stopped image are written back before they are read
+    recorder_init();
+
     _bootloader_vars.base_addr = SWARMIT_BASE_ADDRESS;
-    _bootloader_vars.ota_require_erase = true;
 
     // Initialize current angle to invalid value to force a recomputation when reset is called
-    _control_loop_vars.direction = -1000;
-    _control_loop_vars.target_reached = false;
-    _control_loop_vars.initial_direction_compensated = false;
-    _control_loop_vars.final_direction_compensated = false;
+    _control_loop_reset();
 
     // PWM, Motors and move library initialization
     // Allows enable the regulator and relay switch (v3 only) pins
@@ -434,10 +935,14 @@ int main(void) {
 
     // Status LED
     db_gpio_init(&_status_led, DB_GPIO_OUT);
-    // Periodic Timer and Lighthouse initialization
+    // Timers are only armed when needed, the position and control loop timers are started with the lighthouse capture
+    // and the reset, so the core can sleep through the ready state
     db_timer_init(1);
-    db_timer_set_periodic_ms(1, 1, POSITION_UPDATE_DELAY_MS, &_update_position);
-    db_timer_set_periodic_ms(1, 2, BATTERY_UPDATE_DELAY, &_read_battery);
+    _schedule_battery_update();
+
+    // Lighthouse capture is resumed once to get the position, and while resetting
+    localization_stop();
+    _bootloader_vars.position_refresh = POSITION_REFRESH_UPDATES;
 
     // Experiment is ready
     ipc_shared_data.status = SWRMT_APPLICATION_READY;
@@ -448,47 +953,159 @@ int main(void) {
         if (_bootloader_vars.ota_start_request) {
             _bootloader_vars.ota_start_request = false;
 
-            if (_bootloader_vars.ota_require_erase) {
-                // Erase non secure flash
-                uint32_t pages_count = (ipc_shared_data.ota.image_size / FLASH_PAGE_SIZE) + (ipc_shared_data.ota.image_size % FLASH_PAGE_SIZE != 0);
-                printf("Pages to erase: %u\n", pages_count);
-                for (uint32_t page = 0; page < pages_count; page++) {
-                    uint32_t addr = _bootloader_vars.base_addr + page * FLASH_PAGE_SIZE;
-                    printf("Erasing page %u at %p\n", page + 16, (uint32_t *)addr);
-                    nvmc_page_erase(page + 16);
+            // Chunk size is advertised in the ACK, the controller restarts with a supported size if needed
+            uint32_t nominal_chunk_size = ipc_shared_data.ota.nominal_chunk_size;
+            bool chunk_size_valid = (nominal_chunk_size >= SWRMT_OTA_CHUNK_SIZE) && (nominal_chunk_size <= SWRMT_OTA_CHUNK_SIZE_MAX) && ((nominal_chunk_size & 0x03) == 0);
+            if (chunk_size_valid && ipc_shared_data.ota.chunk_count > OTA_CHUNKS_MAX) {
+                printf("Image too large (%u chunks)\n", ipc_shared_data.ota.chunk_count);
+                continue;
+            }
+
+            // Pages are erased lazily when first written so the start is acknowledged right away.
+            // The state is kept if the image, chunk size and session ID are the ones of the current OTA, e.g.
+            // if it's a retry or if the controller restarted, and restored from flash if the device rebooted
+            // meanwhile
+            ota_session_t session = { 0 };
+            session.image_size = ipc_shared_data.ota.image_size;
+            session.chunk_count = ipc_shared_data.ota.chunk_count;
+            session.chunk_size = nominal_chunk_size;
+            session.compression = ipc_shared_data.ota.compression;
+            memcpy(session.image_hash, (const uint8_t *)ipc_shared_data.ota.image_hash, SWRMT_OTA_SHA256_LENGTH);
+            session.session_id = ipc_shared_data.ota.session_id;
+            session.magic = OTA_SESSION_MAGIC;
+            if (chunk_size_valid && memcmp(&session, &_bootloader_vars.ota_session, sizeof(ota_session_t)) != 0) {
+                bool resume = (session.compression == SWRMT_OTA_COMPRESSION_NONE) && (memcmp(&session, (const void *)OTA_METADATA_ADDRESS, sizeof(ota_session_t)) == 0);
+                _ota_session_init(&session);
+                if (resume) {
+                    _ota_session_restore();
+                } else {
+                    _ota_session_store();
+                }
+
+                // Chunks only covering pages already holding the new image are not written again, in delta mode
+                // the unchanged pages are already in flash
+                if (session.compression == SWRMT_OTA_COMPRESSION_NONE) {
+                    for (uint32_t index = 0; index < ipc_shared_data.ota.chunk_count; index++) {
+                        if (!_ota_chunk_is_changed(index)) {
+                            _ota_chunk_set_written(index);
+                        }
+                    }
+                    printf("Chunks to write: %u\n", ipc_shared_data.ota.chunk_count - _bootloader_vars.ota_chunks_written);
                 }
-                printf("Erasing done\n");
-                _bootloader_vars.ota_require_erase = false;
             }
 
-            // Notify erase is done
+            // Notify the device is ready to receive chunks, with the number of chunks already written
+            // so the controller only sends the missing ones
+            uint32_t chunks_written = chunk_size_valid ? _bootloader_vars.ota_chunks_written : 0;
             size_t length = 0;
             _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_START_ACK;
+            _bootloader_vars.notification_buffer[length++] = SWRMT_OTA_CHUNK_SIZE_MAX;
+            memcpy(_bootloader_vars.notification_buffer + length, &chunks_written, sizeof(uint32_t));
+            length += sizeof(uint32_t);
             mari_node_tx(_bootloader_vars.notification_buffer, length);
+
+            // The image can be complete already, in delta mode if it's identical to the installed one or
+            // if the verification result was lost
+            if (chunk_size_valid && _bootloader_vars.ota_image_complete) {
+                if (_bootloader_vars.ota_image_valid) {
+                    ipc_shared_data.status = SWRMT_APPLICATION_READY;
+                }
+                _ota_notify_verify();
+            } else if (chunk_size_valid && _bootloader_vars.ota_chunks_written == ipc_shared_data.ota.chunk_count) {
+                _ota_complete();
+            }
         }
 
         if (_bootloader_vars.ota_chunk_request) {
             _bootloader_vars.ota_chunk_request = false;
 
-            if (ipc_shared_data.ota.last_chunk_acked != (int32_t)ipc_shared_data.ota.chunk_index) {
-                // Write chunk to flash
-                uint32_t addr = _bootloader_vars.base_addr + ipc_shared_data.ota.chunk_index * SWRMT_OTA_CHUNK_SIZE;
-                printf("Writing chunk %d/%d at address %p\n", ipc_shared_data.ota.chunk_index, ipc_shared_data.ota.chunk_count - 1, (uint32_t *)addr);
-                nvmc_write((uint32_t *)addr, (void *)ipc_shared_data.ota.chunk, ipc_shared_data.ota.chunk_size);
-                _bootloader_vars.ota_require_erase = true;
+            // Process all chunks queued by the network core, it can verify the next ones meanwhile
+            while (ipc_shared_data.ota.chunk_tail != ipc_shared_data.ota.chunk_head) {
+                volatile ipc_ota_chunk_slot_t *slot = &ipc_shared_data.ota.chunks[ipc_shared_data.ota.chunk_tail % IPC_OTA_CHUNK_SLOTS];
+                _ota_process_chunk(slot->index, (uint8_t *)slot->data, slot->size);
+
+                // Release the slot once the chunk was processed
+                __DMB();
+                ipc_shared_data.ota.chunk_tail++;
             }
+        }
 
-            // Notify chunk has been written
+        if (_bootloader_vars.ota_chunk_bitmap_request) {
+            _bootloader_vars.ota_chunk_bitmap_request = false;
+
+            // Bitmaps are byte aligned
+            uint32_t base_index = ipc_shared_data.ota.bitmap_base & ~0x07;
             size_t length = 0;
-            _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_CHUNK_ACK;
-            memcpy(_bootloader_vars.notification_buffer + length, (void *)&ipc_shared_data.ota.chunk_index, sizeof(uint32_t));
+            _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_CHUNK_BITMAP;
+            memcpy(_bootloader_vars.notification_buffer + length, &base_index, sizeof(uint32_t));
             length += sizeof(uint32_t);
-            ipc_shared_data.ota.last_chunk_acked = ipc_shared_data.ota.chunk_index;
+            for (uint32_t byte = (base_index >> 3); byte < (base_index >> 3) + SWRMT_OTA_CHUNK_BITMAP_SIZE; byte++) {
+                _bootloader_vars.notification_buffer[length++] = (byte < sizeof(_bootloader_vars.ota_chunks_bitmap)) ? _bootloader_vars.ota_chunks_bitmap[byte] : 0;
+            }
             mari_node_tx(_bootloader_vars.notification_buffer, length);
+        }
+
+        if (_bootloader_vars.ota_page_hashes_request) {
+            _bootloader_vars.ota_page_hashes_request = false;
 
-            // If last chunk, finalize computed hash, set back to ready state
-            if (ipc_shared_data.ota.chunk_index == ipc_shared_data.ota.chunk_count - 1) {
-                ipc_shared_data.status = SWRMT_APPLICATION_READY;
+            uint32_t page_start = ipc_shared_data.ota.page_hashes_start;
+            uint8_t page_count = ipc_shared_data.ota.page_hashes_count;
+            if (page_start >= OTA_PAGES_MAX) {
+                page_count = 0;
+            } else if (page_start + page_count > OTA_PAGES_MAX) {
+                page_count = OTA_PAGES_MAX - page_start;
+            }
+            if (page_count > SWRMT_OTA_PAGE_HASHES_MAX) {
+                page_count = SWRMT_OTA_PAGE_HASHES_MAX;
+            }
+
+            size_t length = 0;
+            _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_OTA_PAGE_HASHES;
+            memcpy(_bootloader_vars.notification_buffer + length, &page_start, sizeof(uint32_t));
+            length += sizeof(uint32_t);
+            _bootloader_vars.notification_buffer[length++] = page_count;
+            _bootloader_vars.notification_buffer[length++] = page_count * SWRMT_OTA_PAGE_HASH_LENGTH;
+            for (uint32_t page = page_start; page < page_start + page_count; page++) {
+                crypto_sha256_init();
+                crypto_sha256_update((const uint8_t *)(_bootloader_vars.base_addr + page * FLASH_PAGE_SIZE), FLASH_PAGE_SIZE);
+                crypto_sha256(_bootloader_vars.ota_page_hash);
+                memcpy(_bootloader_vars.notification_buffer + length, _bootloader_vars.ota_page_hash, SWRMT_OTA_PAGE_HASH_LENGTH);
+                length += SWRMT_OTA_PAGE_HASH_LENGTH;
+            }
+            mari_node_tx(_bootloader_vars.notification_buffer, length);
+        }
+
+        if (_bootloader_vars.record_read_request) {
+            _bootloader_vars.record_read_request = false;
+
+            // Consecutive chunks are streamed, at least one so the controller learns the recorded size
+            uint32_t total = recorder_size();
+            uint32_t offset = ipc_shared_data.record_read.offset;
+            uint8_t count = ipc_shared_data.record_read.count;
+            if (count == 0) {
+                count = 1;
+            } else if (count > SWRMT_RECORD_WINDOW_MAX) {
+                count = SWRMT_RECORD_WINDOW_MAX;
+            }
+            for (uint8_t i = 0; i < count; i++, offset += SWRMT_RECORD_CHUNK_SIZE) {
+                if (i && offset >= total) {
+                    break;
+                }
+                uint8_t size = 0;
+                if (offset < total) {
+                    size = (total - offset < SWRMT_RECORD_CHUNK_SIZE) ? total - offset : SWRMT_RECORD_CHUNK_SIZE;
+                }
+
+                size_t length = 0;
+                _bootloader_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_RECORD_DATA;
+                memcpy(_bootloader_vars.notification_buffer + length, &total, sizeof(uint32_t));
+                length += sizeof(uint32_t);
+                memcpy(_bootloader_vars.notification_buffer + length, &offset, sizeof(uint32_t));
+                length += sizeof(uint32_t);
+                _bootloader_vars.notification_buffer[length++] = size;
+                memcpy(_bootloader_vars.notification_buffer + length, (const uint8_t *)(RECORDER_ADDRESS + offset), size);
+                length += size;
+                mari_node_tx(_bootloader_vars.notification_buffer, length);
             }
         }
 
@@ -498,53 +1115,79 @@ int main(void) {
 
         if (_bootloader_vars.battery_update) {
             db_gpio_toggle(&_status_led);
-            ipc_shared_data.battery_level = battery_level_read();
+            if (battery_level_update()) {
+                ipc_shared_data.battery_level = battery_level_read();
+            }
+            _update_duty_cycle();
+            _schedule_battery_update();
             _bootloader_vars.battery_update = false;
         }
 
-        // Process available lighthouse data
-        localization_process_data();
-        if (_bootloader_vars.position_update) {
-            puts("Update position");
-            localization_get_position((position_2d_t *)&ipc_shared_data.current_position);
-
-            if (ipc_shared_data.status != SWRMT_APPLICATION_RESETTING) {
-                continue;
-            }
-
-            int16_t new_direction = -1000;
-            _compute_angle(
-                (const position_2d_t *)&ipc_shared_data.current_position,
-                &_control_loop_vars.previous_position,
-                &new_direction
-            );
-            if (new_direction != -1000) {
-                _control_loop_vars.direction = new_direction;
+        if (_bootloader_vars.calibration_request) {
+            _bootloader_vars.calibration_request = false;
+            localization_homography_t homographies[IPC_CALIBRATION_SLOTS];
+            mutex_lock();
+            uint8_t pending = ipc_shared_data.calibration_pending;
+            memcpy(homographies, (const uint8_t *)ipc_shared_data.calibrations, sizeof(homographies));
+            ipc_shared_data.calibration_pending = 0;
+            mutex_unlock();
+            // Flash is written out of the lock, the network core may queue other homographies meanwhile
+            for (uint8_t index = 0; index < IPC_CALIBRATION_SLOTS; index++) {
+                if (pending & (1 << index)) {
+                    if (localization_store_homography(&homographies[index])) {
+                        _bootloader_vars.position_refresh = POSITION_REFRESH_UPDATES;
+                    }
+                }
             }
+        }
 
-            _control_loop_vars.previous_position.x = ipc_shared_data.current_position.x;
-            _control_loop_vars.previous_position.y = ipc_shared_data.current_position.y;
+        if (_bootloader_vars.reset_request) {
+            _bootloader_vars.reset_request = false;
+            db_timer_set_oneshot_ms(1, 3, CONTROL_LOOP_PERIOD_MS, &_update_control);
+        }
 
-            if (!_control_loop_vars.initial_direction_compensated) {
-                _compensate_initial_direction();
+        // Robots don't move in ready state, the lighthouse capture only runs while resetting or until a fix is available
+        bool localization_needed = (ipc_shared_data.status == SWRMT_APPLICATION_RESETTING) || _bootloader_vars.position_refresh;
+        if (localization_needed != _bootloader_vars.localization_running) {
+            _bootloader_vars.localization_running = localization_needed;
+            if (localization_needed) {
+                localization_start();
+                db_timer_set_oneshot_ms(1, 1, POSITION_UPDATE_DELAY_MS, &_update_position);
+            } else {
+                localization_stop();
             }
+        }
 
-            if (!_control_loop_vars.target_reached) {
-                _update_control_loop();
+        // Process available lighthouse data
+        if (_bootloader_vars.localization_running) {
+            localization_process_data();
+        }
+        if (_bootloader_vars.position_update) {
+            // Fixes are consumed by the control loop while resetting
+            if ((ipc_shared_data.status != SWRMT_APPLICATION_RESETTING) && _bootloader_vars.position_refresh) {
+                bool fix_available = localization_get_position((position_2d_t *)&ipc_shared_data.current_position);
+                _bootloader_vars.position_refresh = fix_available ? 0 : _bootloader_vars.position_refresh - 1;
             }
+            if (_bootloader_vars.localization_running) {
+                db_timer_set_oneshot_ms(1, 1, POSITION_UPDATE_DELAY_MS, &_update_position);
+            }
+            _bootloader_vars.position_update = false;
+        }
 
-            if (_control_loop_vars.target_reached) {
-                _compensate_angle(_control_loop_vars.direction);
-                ipc_shared_data.status = SWRMT_APPLICATION_READY;
-                _control_loop_vars.direction = -1000;
-                _control_loop_vars.target_reached = false;
-                _control_loop_vars.initial_direction_compensated = false;
-                _control_loop_vars.final_direction_compensated = false;
-                _control_loop_vars.previous_position.x = 0;
-                _control_loop_vars.previous_position.y = 0;
+        if (_bootloader_vars.control_update) {
+            if (ipc_shared_data.status == SWRMT_APPLICATION_RESETTING) {
+                _control_loop_step();
+            } else if (_control_loop_vars.position_known) {
+                // Reset interrupted, start from scratch next time
+                _set_motors_speed(0, 0);
+                _control_loop_reset();
             }
 
-            _bootloader_vars.position_update = false;
+            // The control loop only runs while resetting
+            if (ipc_shared_data.status == SWRMT_APPLICATION_RESETTING) {
+                db_timer_set_oneshot_ms(1, 3, CONTROL_LOOP_PERIOD_MS, &_update_control);
+            }
+            _bootloader_vars.control_update = false;
         }
     }
 }
@@ -553,6 +1196,11 @@ int main(void) {
 
 void IPC_IRQHandler(void) {
 
+    // Request acks only need to wake up the core, ipc_network_call checks the net_ack flag
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_REQ_ACK]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_REQ_ACK] = 0;
+    }
+
     if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_START]) {
         NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_START] = 0;
         _bootloader_vars.ota_start_request = true;
@@ -563,8 +1211,33 @@ void IPC_IRQHandler(void) {
         _bootloader_vars.ota_chunk_request = true;
     }
 
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_CHUNK_BITMAP]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_CHUNK_BITMAP] = 0;
+        _bootloader_vars.ota_chunk_bitmap_request = true;
+    }
+
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_PAGE_HASHES]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_OTA_PAGE_HASHES] = 0;
+        _bootloader_vars.ota_page_hashes_request = true;
+    }
+
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_CALIBRATION]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_CALIBRATION] = 0;
+        _bootloader_vars.calibration_request = true;
+    }
+
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RECORD_READ]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_RECORD_READ] = 0;
+        _bootloader_vars.record_read_request = true;
+    }
+
     if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_APPLICATION_START]) {
         NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_APPLICATION_START] = 0;
         _bootloader_vars.start_application = true;
     }
+
+    if (NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_APPLICATION_RESET]) {
+        NRF_IPC_S->EVENTS_RECEIVE[IPC_CHAN_APPLICATION_RESET] = 0;
+        _bootloader_vars.reset_request = true;
+    }
 }
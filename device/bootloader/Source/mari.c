@@ -22,6 +22,12 @@
 
 extern volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
 
+//=========================== private ==========================================
+
+static bool _tx_ring_full(void) {
+    return (uint8_t)(ipc_shared_data.tx_ring.head - ipc_shared_data.tx_ring.tail) >= IPC_RADIO_PDU_SLOTS;
+}
+
 //=========================== public ===========================================
 
 void mari_init(void) {
@@ -33,8 +39,45 @@ void mari_init(void) {
     ipc_network_call(IPC_MARI_INIT_REQ);
 }
 
+mari_tx_status_t mari_node_tx_reserve(uint8_t **buffer, bool blocking) {
+    if (blocking) {
+        // Wait for a free slot, the network core releases them as soon as the packets are handed to Mari
+        while (_tx_ring_full()) {}
+    } else if (!ipc_shared_data.net_connected) {
+        // Packets are not queued while disconnected, they would be sent late with stale content
+        return MARI_TX_DISCONNECTED;
+    } else if (_tx_ring_full()) {
+        return MARI_TX_FULL;
+    }
+
+    *buffer = (uint8_t *)ipc_shared_data.tx_ring.pdus[ipc_shared_data.tx_ring.head % IPC_RADIO_PDU_SLOTS].buffer;
+    return MARI_TX_QUEUED;
+}
+
+void mari_node_tx_commit(uint8_t length) {
+    uint8_t head = ipc_shared_data.tx_ring.head;
+    ipc_shared_data.tx_ring.pdus[head % IPC_RADIO_PDU_SLOTS].length = length;
+
+    // Publish the slot once its content is complete
+    __DMB();
+    ipc_shared_data.tx_ring.head = head + 1;
+    NRF_IPC_S->TASKS_SEND[IPC_CHAN_RADIO_TX] = 1;
+}
+
 void mari_node_tx(const uint8_t *packet, uint8_t length) {
-    ipc_shared_data.tx_pdu.length = length;
-    memcpy((void *)ipc_shared_data.tx_pdu.buffer, packet, length);
-    ipc_network_call(IPC_MARI_NODE_TX_REQ);
+    uint8_t *buffer;
+    mari_node_tx_reserve(&buffer, true);
+    memcpy(buffer, packet, length);
+    mari_node_tx_commit(length);
+}
+
+mari_tx_status_t mari_node_tx_nonblocking(const uint8_t *packet, uint8_t length) {
+    uint8_t *buffer;
+    mari_tx_status_t status = mari_node_tx_reserve(&buffer, false);
+    if (status != MARI_TX_QUEUED) {
+        return status;
+    }
+    memcpy(buffer, packet, length);
+    mari_node_tx_commit(length);
+    return MARI_TX_QUEUED;
 }
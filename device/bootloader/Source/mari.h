@@ -13,9 +13,18 @@
  * @}
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <nrf.h>
 
+//=========================== defines ==========================================
+
+typedef enum {
+    MARI_TX_QUEUED,         ///< Packet queued for transmission
+    MARI_TX_FULL,           ///< Packet dropped, the TX queue is full
+    MARI_TX_DISCONNECTED,   ///< Packet dropped, the node is not connected to a gateway
+} mari_tx_status_t;
+
 //=========================== prototypes =======================================
 
 /**
@@ -32,4 +41,31 @@ void mari_init(void);
  */
 void mari_node_tx(const uint8_t *packet, uint8_t length);
 
+/**
+ * @brief Queues a single node packet to send through mari, without waiting for a free slot
+ *
+ * @param[in] packet pointer to the array of data to send over the radio
+ * @param[in] length Number of bytes to send
+ *
+ * @return MARI_TX_QUEUED if the packet was queued, the reason why it was dropped otherwise
+ */
+mari_tx_status_t mari_node_tx_nonblocking(const uint8_t *packet, uint8_t length);
+
+/**
+ * @brief Reserves the next TX slot so the packet can be written in place, must be followed by mari_node_tx_commit
+ *
+ * @param[out] buffer   Set to the buffer of the slot, UINT8_MAX bytes long
+ * @param[in]  blocking Wait for a free slot, even while disconnected
+ *
+ * @return MARI_TX_QUEUED if a slot was reserved, the reason why it wasn't otherwise
+ */
+mari_tx_status_t mari_node_tx_reserve(uint8_t **buffer, bool blocking);
+
+/**
+ * @brief Queues the packet written in the reserved TX slot
+ *
+ * @param[in] length Number of bytes written in the slot
+ */
+void mari_node_tx_commit(uint8_t length);
+
 #endif
@@ -0,0 +1,140 @@
+/**
+ * @file
+ * @ingroup drv_nav
+ *
+ * @brief  Implementation of the fixed-point navigation kernel
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "nav.h"
+
+//=========================== defines ==========================================
+
+#define NAV_CORDIC_ITERATIONS   (16U)
+#define NAV_CORDIC_INPUT_MAX    (1 << 29)   ///< The CORDIC gain (~1.65) must not overflow int32
+#define NAV_Q16_90_DEG          (90 << 16)
+#define NAV_Q16_180_DEG         (180 << 16)
+#define NAV_CORDIC_GAIN_INV_Q30 (652032874) ///< Inverse of the CORDIC gain in Q30
+
+/// atan(2^-i) in Q16 degrees
+static const int32_t _cordic_angles[NAV_CORDIC_ITERATIONS] = {
+    2949120, 1740967, 919879, 466945, 234379, 117304, 58666, 29335,
+    14668, 7334, 3667, 1833, 917, 458, 229, 115,
+};
+
+//=========================== public ===========================================
+
+int32_t nav_atan2_q16(int32_t y, int32_t x) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+
+    // Only the direction matters, scale the vector down to keep some headroom
+    while (abs(x) >= NAV_CORDIC_INPUT_MAX || abs(y) >= NAV_CORDIC_INPUT_MAX) {
+        x /= 2;
+        y /= 2;
+    }
+
+    // CORDIC converges for angles in [-90, 90], the other half plane is rotated by 180
+    int32_t angle = 0;
+    if (x < 0) {
+        angle = (y >= 0) ? NAV_Q16_180_DEG : -NAV_Q16_180_DEG;
+        x = -x;
+        y = -y;
+    }
+
+    // Rotate the vector towards the X axis, accumulating the rotation angle
+    for (uint8_t i = 0; i < NAV_CORDIC_ITERATIONS; i++) {
+        int32_t x_shifted = x >> i;
+        int32_t y_shifted = y >> i;
+        if (y > 0) {
+            x += y_shifted;
+            y -= x_shifted;
+            angle += _cordic_angles[i];
+        } else {
+            x -= y_shifted;
+            y += x_shifted;
+            angle -= _cordic_angles[i];
+        }
+    }
+
+    if (angle <= -NAV_Q16_180_DEG) {
+        angle += 2 * NAV_Q16_180_DEG;
+    } else if (angle > NAV_Q16_180_DEG) {
+        angle -= 2 * NAV_Q16_180_DEG;
+    }
+    return angle;
+}
+
+uint32_t nav_distance(int32_t dx, int32_t dy) {
+    uint64_t value = (uint64_t)((int64_t)dx * dx) + (uint64_t)((int64_t)dy * dy);
+
+    // Bitwise integer square root
+    uint64_t result = 0;
+    uint64_t bit = 1ULL << 62;
+    while (bit > value) {
+        bit >>= 2;
+    }
+    while (bit) {
+        if (value >= result + bit) {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        } else {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)result;
+}
+
+int16_t nav_heading(const position_2d_t *head, const position_2d_t *tail, uint32_t *distance) {
+    int32_t dx = (int32_t)(head->x - tail->x);
+    int32_t dy = (int32_t)(head->y - tail->y);
+
+    if (distance) {
+        *distance = nav_distance(dx, dy);
+    }
+
+    // Round to the nearest degree
+    int32_t heading = (nav_atan2_q16(-dx, dy) + (1 << 15)) >> 16;
+    return (int16_t)((heading <= -180) ? heading + 360 : heading);
+}
+
+void nav_advance(position_2d_t *position, int32_t heading, int32_t distance) {
+    // CORDIC converges for angles in [-90, 90], the other half plane is rotated by 180
+    int32_t angle = heading;
+    if (angle > NAV_Q16_90_DEG) {
+        angle -= NAV_Q16_180_DEG;
+        distance = -distance;
+    } else if (angle < -NAV_Q16_90_DEG) {
+        angle += NAV_Q16_180_DEG;
+        distance = -distance;
+    }
+
+    // Rotate the unit vector by the heading, pre-scaled by the inverse of the gain
+    int32_t cos = NAV_CORDIC_GAIN_INV_Q30;
+    int32_t sin = 0;
+    for (uint8_t i = 0; i < NAV_CORDIC_ITERATIONS; i++) {
+        int32_t cos_shifted = cos >> i;
+        int32_t sin_shifted = sin >> i;
+        if (angle >= 0) {
+            cos -= sin_shifted;
+            sin += cos_shifted;
+            angle -= _cordic_angles[i];
+        } else {
+            cos += sin_shifted;
+            sin -= cos_shifted;
+            angle += _cordic_angles[i];
+        }
+    }
+
+    // Heading 0 is along Y and positive towards -X
+    position->x -= (int32_t)(((int64_t)distance * sin) >> 30);
+    position->y += (int32_t)(((int64_t)distance * cos) >> 30);
+}
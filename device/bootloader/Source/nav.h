@@ -0,0 +1,71 @@
+#ifndef __NAV_H
+#define __NAV_H
+
+/**
+ * @defgroup    drv_nav     Fixed-point navigation kernel
+ * @ingroup     drv
+ * @brief       Integer heading and distance computations used by the reset control loop
+ *
+ * Positions are handled in micrometers, as reported by the localization, and
+ * angles in degrees. The heading is computed with a CORDIC in Q16 degrees so
+ * the control loop doesn't need any floating point operation.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+#include "localization.h"
+
+//=========================== defines ==========================================
+
+#define NAV_Q16_DEGREES_PER_RADIAN  (3754936)   ///< 180 / pi in Q16
+
+//=========================== public ===========================================
+
+/**
+ * @brief   Compute the angle of a vector, like atan2
+ *
+ * @param[in]   y   Y coordinate of the vector
+ * @param[in]   x   X coordinate of the vector
+ *
+ * @return  angle between the vector and the X axis in Q16 degrees, in ]-180, 180]
+ */
+int32_t nav_atan2_q16(int32_t y, int32_t x);
+
+/**
+ * @brief   Compute the length of a vector
+ *
+ * @param[in]   dx  X coordinate of the vector in micrometers
+ * @param[in]   dy  Y coordinate of the vector in micrometers
+ *
+ * @return  length of the vector in micrometers
+ */
+uint32_t nav_distance(int32_t dx, int32_t dy);
+
+/**
+ * @brief   Compute the heading from a position to another one
+ *
+ * The heading is 0 along the Y axis and positive towards the negative X axis.
+ *
+ * @param[in]   head        Destination position
+ * @param[in]   tail        Origin position
+ * @param[out]  distance    Distance between the 2 positions in micrometers, can be NULL
+ *
+ * @return  heading in degrees, in ]-180, 180]
+ */
+int16_t nav_heading(const position_2d_t *head, const position_2d_t *tail, uint32_t *distance);
+
+/**
+ * @brief   Move a position along a heading, using the same convention as nav_heading
+ *
+ * @param[in,out]   position    Position to move
+ * @param[in]       heading     Heading in Q16 degrees, in [-180, 180]
+ * @param[in]       distance    Distance to move in micrometers, negative to move backward
+ */
+void nav_advance(position_2d_t *position, int32_t heading, int32_t distance);
+
+#endif
@@ -14,27 +14,47 @@
 
 #include <nrf.h>
 #include "nvmc.h"
+#include "profile.h"
 
 //=========================== public ==========================================
 
 void nvmc_page_erase(uint32_t page) {
 
+    uint32_t start = profile_start();
     const uint32_t *addr = (const uint32_t *)(page * FLASH_PAGE_SIZE);
 
     NRF_NVMC_S->CONFIGNS = (NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos);
     *(uint32_t *)addr  = 0xFFFFFFFF;
     while (!NRF_NVMC_S->READY) {}
+    profile_stop(PROFILE_NVMC_PAGE_ERASE, start);
+}
+
+bool nvmc_page_is_blank(uint32_t page) {
+
+    const uint32_t *addr = (const uint32_t *)(page * FLASH_PAGE_SIZE);
+
+    for (uint32_t i = 0; i < (FLASH_PAGE_SIZE >> 2); i++) {
+        if (addr[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void nvmc_write(const uint32_t *addr, const void *data, size_t len) {
 
+    uint32_t start = profile_start();
     uint32_t       *dest_addr = (uint32_t *)addr;
     const uint32_t *data_addr = data;
 
     NRF_NVMC_S->CONFIGNS = (NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos);
     for (uint32_t i = 0; i < (len >> 2); i++) {
-        *dest_addr++ = data_addr[i];
+        // Skip words already holding the value, e.g. padding written over erased flash
+        if (dest_addr[i] != data_addr[i]) {
+            dest_addr[i] = data_addr[i];
+        }
     }
 
     NRF_NVMC_S->CONFIGNS = (NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos);
+    profile_stop(PROFILE_NVMC_WRITE, start);
 }
@@ -1,6 +1,7 @@
 #ifndef __NVMC_H
 #define __NVMC_H
 
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
 
@@ -12,6 +13,7 @@
 //=========================== public ===========================================
 
 void nvmc_page_erase(uint32_t page);
+bool nvmc_page_is_blank(uint32_t page);
 void nvmc_write(const uint32_t *addr, const void *input, size_t len);
 
 #endif
@@ -0,0 +1,28 @@
+#include <nrf.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "ipc.h"
+#include "profile.h"
+
+extern volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
+
+_Static_assert(PROFILE_COUNT <= SWRMT_PROFILE_APP_ENTRIES, "Profiled sections don't fit in shared RAM");
+
+void profile_init(void) {
+    memset((void *)&ipc_shared_data.profile, 0, sizeof(ipc_profile_t));
+    ipc_shared_data.profile.cpu_mhz = (uint8_t)(SystemCoreClock / 1000000);
+}
+
+void profile_add(profile_id_t id, uint32_t cycles) {
+    // Not atomic, a nested measure of the same section may be lost, which is fine for statistics
+    volatile swrmt_profile_entry_t *entry = &ipc_shared_data.profile.entries[id];
+    if (entry->count == 0 || cycles < entry->min) {
+        entry->min = cycles;
+    }
+    if (cycles > entry->max) {
+        entry->max = cycles;
+    }
+    entry->total += cycles;
+    entry->count++;
+}
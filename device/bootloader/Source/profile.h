@@ -0,0 +1,85 @@
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+/**
+ * @defgroup    bsp_profile  Secure side profiling
+ * @ingroup     bsp
+ * @brief       Accumulate the cycles spent in the NSC entries, the IPC requests and the flash operations
+ *
+ * The statistics are kept in shared RAM, the network core sends them in answer to a profile request.
+ * Sections are measured with the DWT cycle counter, which doesn't count while the core sleeps, so
+ * IPC requests are measured with the timebase instead and converted to cycles.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+#include <nrf.h>
+
+/// Profiled sections of the application core, the order is mirrored by the controller
+typedef enum {
+    PROFILE_NSC_KEEP_ALIVE,
+    PROFILE_NSC_SEND_DATA_PACKET,
+    PROFILE_NSC_SEND_RAW_DATA,
+    PROFILE_NSC_SEND_DATA_PACKET_NONBLOCKING,
+    PROFILE_NSC_SEND_DATA_IOV,
+    PROFILE_NSC_TX_STATS,
+    PROFILE_NSC_IPC_ISR,
+    PROFILE_NSC_IPC_ISR_DRAIN,
+    PROFILE_NSC_INIT_RNG,
+    PROFILE_NSC_READ_RNG,
+    PROFILE_NSC_READ_DEVICE_ID,
+    PROFILE_NSC_GET_TIME,
+    PROFILE_NSC_GPIO_CAPTURE,
+    PROFILE_NSC_GPIO_CAPTURE_FLUSH,
+    PROFILE_NSC_LOG_DATA,
+    PROFILE_NSC_LOG_FORMAT,
+    PROFILE_NSC_RECORD_APPEND,
+    PROFILE_NSC_RECORD_FLUSH,
+    PROFILE_NSC_LOCALIZATION_PROCESS_DATA,
+    PROFILE_NSC_LOCALIZATION_GET_POSITION,
+    PROFILE_NSC_LOCALIZATION_HANDLE_ISR,
+    PROFILE_NSC_SAADC_READ,
+    PROFILE_IPC_NETWORK_CALL,
+    PROFILE_NVMC_WRITE,
+    PROFILE_NVMC_PAGE_ERASE,
+    PROFILE_COUNT,
+} profile_id_t;
+
+/**
+ * @brief Clear the statistics, the DWT cycle counter must be enabled
+ */
+void profile_init(void);
+
+/**
+ * @brief Add a measure to the statistics of a section
+ *
+ * @param[in] id        Profiled section
+ * @param[in] cycles    Cycles spent in the section
+ */
+void profile_add(profile_id_t id, uint32_t cycles);
+
+/**
+ * @brief Start measuring a section
+ *
+ * @return value of the cycle counter, to pass to profile_stop
+ */
+static inline uint32_t profile_start(void) {
+    return DWT->CYCCNT;
+}
+
+/**
+ * @brief Stop measuring a section and add the elapsed cycles to its statistics
+ *
+ * @param[in] id        Profiled section
+ * @param[in] start     Value returned by profile_start
+ */
+static inline void profile_stop(profile_id_t id, uint32_t start) {
+    profile_add(id, DWT->CYCCNT - start);
+}
+
+#endif
@@ -24,12 +24,24 @@
 #define GATEWAY_ADDRESS   0x0000000000000000UL  ///< Gateway address
 
 #define SWRMT_PREAMBLE_LENGTH       (8U)
-#define SWRMT_OTA_CHUNK_SIZE        (64U)
+#define SWRMT_OTA_CHUNK_SIZE        (64U)    ///< Default size of OTA chunks
+#define SWRMT_OTA_CHUNK_SIZE_MAX    (192U)   ///< Largest OTA chunk size supported by the device, multiple of 4
+#define SWRMT_OTA_SHA256_LENGTH     (32U)
+#define SWRMT_OTA_CHUNK_BITMAP_SIZE (32U)   ///< Size in bytes of a chunk bitmap, covers 256 chunks
+#define SWRMT_OTA_PAGES_BITMAP_SIZE (32U)   ///< Size in bytes of a flash pages bitmap, covers 256 pages (1MiB)
+#define SWRMT_OTA_PAGE_HASH_LENGTH  (8U)    ///< Length of the truncated SHA256 hash of a flash page
+#define SWRMT_OTA_PAGE_HASHES_MAX   (16U)   ///< Max number of page hashes in a notification
+#define SWRMT_LOG_FORMAT_FLAG       (0x80U) ///< Set in the length of log entries holding a format ID and its arguments
+#define SWRMT_RESET_WAYPOINTS_MAX   (8U)    ///< Max number of waypoints of a reset request
+#define SWRMT_GPIO_EVENT_BATCH_MAX  (31U)   ///< Max number of GPIO events in a notification
+#define SWRMT_RECORD_CHUNK_SIZE     (192U)  ///< Size of the recorded data chunks read back in a notification
+#define SWRMT_RECORD_WINDOW_MAX     (32U)   ///< Max number of chunks sent in answer to a read request
+#define SWRMT_PROFILE_APP_ENTRIES   (32U)   ///< Number of profiled sections of the application core
 
 typedef struct __attribute__((packed)) {
     uint32_t index;                             ///< Index of the chunk
     uint8_t  chunk_size;                        ///< Size of the chunk
-    uint8_t  chunk[SWRMT_OTA_CHUNK_SIZE];       ///< Bytes array of the firmware chunk
+    uint8_t  chunk[SWRMT_OTA_CHUNK_SIZE_MAX];   ///< Bytes array of the firmware chunk
 } swrmt_ota_chunk_pkt_t;
 
 typedef enum {
@@ -47,6 +59,16 @@ typedef enum {
     SWRMT_REQUEST_RESET = 0x83,
     SWRMT_REQUEST_OTA_START = 0x84,
     SWRMT_REQUEST_OTA_CHUNK = 0x85,
+    SWRMT_REQUEST_OTA_CHUNK_BITMAP = 0x86,
+    SWRMT_REQUEST_OTA_PAGE_HASHES = 0x87,
+    SWRMT_REQUEST_OTA_RAW_CHUNK = 0x88,
+    SWRMT_REQUEST_CONFIG = 0x89,
+    SWRMT_REQUEST_MULTICAST = 0x8A,
+    SWRMT_REQUEST_RESET_WAYPOINTS = 0x8B,
+    SWRMT_REQUEST_START_AT = 0x8C,
+    SWRMT_REQUEST_TIME_SYNC = 0x8D,
+    SWRMT_REQUEST_RECORD_READ = 0x8E,
+    SWRMT_REQUEST_PROFILE = 0x8F,
 } swrmt_request_type_t;
 
 typedef enum {
@@ -57,8 +79,25 @@ typedef enum {
     SWRMT_NOTIFICATION_OTA_CHUNK_ACK = 0x94,
     SWRMT_NOTIFICATION_GPIO_EVENT = 0x95,
     SWRMT_NOTIFICATION_LOG_EVENT = 0x96,
+    SWRMT_NOTIFICATION_OTA_CHUNK_BITMAP = 0x97,
+    SWRMT_NOTIFICATION_OTA_PAGE_HASHES = 0x98,
+    SWRMT_NOTIFICATION_OTA_VERIFY = 0x99,
+    SWRMT_NOTIFICATION_LOG_BATCH = 0x9A,
+    SWRMT_NOTIFICATION_LINK_STATS = 0x9B,
+    SWRMT_NOTIFICATION_RECORD_DATA = 0x9C,
+    SWRMT_NOTIFICATION_PROFILE = 0x9D,
 } swrmt_notification_type_t;
 
+typedef enum {
+    SWRMT_OTA_MODE_STOP_AND_WAIT = 0,   ///< Each chunk is acknowledged individually
+    SWRMT_OTA_MODE_WINDOWED = 1,        ///< Chunks are streamed and acknowledged with bitmaps on demand
+} swrmt_ota_mode_t;
+
+typedef enum {
+    SWRMT_OTA_COMPRESSION_NONE = 0,     ///< Chunks contain the raw image
+    SWRMT_OTA_COMPRESSION_LZSS = 1,     ///< Chunks contain the LZSS compressed image, decompressed in order
+} swrmt_ota_compression_t;
+
 /// Application type
 typedef enum {
     DotBot        = 0,  ///< DotBot application
@@ -93,6 +132,25 @@ typedef enum {
     PROTOCOL_LH2_PROCESSED_DATA = 12,  ///< Lighthouse 2 data processed at the DotBot
 } protocol_data_type_t;
 
+typedef struct __attribute__((packed)) {
+    uint8_t port;  ///< Port number of the GPIO
+    uint8_t pin;   ///< Pin number of the GPIO
+    uint8_t value; ///< Level of the GPIO
+} gpio_data_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t timestamp;     ///< Network time of the event in us, truncated to 32 bits
+    gpio_data_t data;
+} swrmt_gpio_event_t;
+
+/// Statistics of a profiled section, in cycles of the core running it
+typedef struct __attribute__((packed)) {
+    uint32_t count;                             ///< Number of measures
+    uint32_t min;                               ///< Shortest measure
+    uint32_t max;                               ///< Longest measure
+    uint64_t total;                             ///< Sum of the measures
+} swrmt_profile_entry_t;
+
 /// DotBot protocol header
 typedef struct __attribute__((packed)) {
     uint8_t       version;      ///< Version of the firmware
@@ -0,0 +1,124 @@
+#include <nrf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nvmc.h"
+#include "recorder.h"
+
+#define RECORDER_MAGIC          (0x52435244UL)  ///< Marks a buffer holding records not written yet
+#define RECORDER_HEADER_SIZE    (sizeof(uint16_t))
+#define RECORDER_BLANK_LENGTH   (0xFFFF)        ///< Length read from erased flash, after the last record
+
+typedef struct {
+    uint32_t magic;
+    uint32_t offset;                                ///< Offset in the region of the buffered page
+    uint32_t length;                                ///< Number of buffered bytes
+    uint32_t written;                               ///< Number of buffered bytes already written to flash
+    uint32_t data[FLASH_PAGE_SIZE / sizeof(uint32_t)];
+} recorder_buffer_t;
+
+typedef struct {
+    bool     started;   ///< Records were appended since the boot
+    uint32_t size;      ///< Size of the records found in flash at boot
+} recorder_vars_t;
+
+// Kept through resets, the bootloader writes back what the stopped image didn't
+static __attribute__((section(".non_init"))) recorder_buffer_t _recorder_buffer;
+static recorder_vars_t _recorder_vars = { 0 };
+
+static void _write(void) {
+    nvmc_write((const uint32_t *)(RECORDER_ADDRESS + _recorder_buffer.offset + _recorder_buffer.written),
+               (const uint8_t *)_recorder_buffer.data + _recorder_buffer.written,
+               _recorder_buffer.length - _recorder_buffer.written);
+    _recorder_buffer.written = _recorder_buffer.length;
+}
+
+static void _start_page(uint32_t offset) {
+    _recorder_buffer.offset  = offset;
+    _recorder_buffer.length  = 0;
+    _recorder_buffer.written = 0;
+    // The page ahead is erased right away, the records found at boot end in the current page
+    nvmc_page_erase((RECORDER_ADDRESS + offset) / FLASH_PAGE_SIZE);
+}
+
+static void _put(const uint8_t *data, size_t length) {
+    while (length) {
+        size_t chunk = FLASH_PAGE_SIZE - _recorder_buffer.length;
+        if (chunk > length) {
+            chunk = length;
+        }
+        uint8_t *dst = (uint8_t *)_recorder_buffer.data + _recorder_buffer.length;
+        if (data) {
+            memcpy(dst, data, chunk);
+            data += chunk;
+        } else {
+            memset(dst, 0, chunk);
+        }
+        _recorder_buffer.length += chunk;
+        length -= chunk;
+
+        if (_recorder_buffer.length == FLASH_PAGE_SIZE) {
+            _write();
+            if (_recorder_buffer.offset + FLASH_PAGE_SIZE < RECORDER_SIZE) {
+                _start_page(_recorder_buffer.offset + FLASH_PAGE_SIZE);
+            } else {
+                _recorder_buffer.offset += FLASH_PAGE_SIZE;
+                _recorder_buffer.length  = 0;
+                _recorder_buffer.written = 0;
+            }
+        }
+    }
+}
+
+void recorder_init(void) {
+    if (_recorder_buffer.magic == RECORDER_MAGIC &&
+        _recorder_buffer.offset < RECORDER_SIZE &&
+        _recorder_buffer.length <= FLASH_PAGE_SIZE &&
+        _recorder_buffer.written <= _recorder_buffer.length) {
+        _write();
+    }
+    _recorder_buffer.magic = 0;
+
+    uint32_t offset = 0;
+    while (offset + RECORDER_HEADER_SIZE <= RECORDER_SIZE) {
+        uint16_t length = *(const uint16_t *)(RECORDER_ADDRESS + offset);
+        if (length == RECORDER_BLANK_LENGTH) {
+            break;
+        }
+        offset += (RECORDER_HEADER_SIZE + length + 3) & ~0x03;
+    }
+    _recorder_vars.size = (offset < RECORDER_SIZE) ? offset : RECORDER_SIZE;
+}
+
+bool recorder_append(const uint8_t *data, uint8_t length) {
+    if (!_recorder_vars.started) {
+        _recorder_vars.started = true;
+        _start_page(0);
+        _recorder_buffer.magic = RECORDER_MAGIC;
+    }
+
+    size_t size = (RECORDER_HEADER_SIZE + length + 3) & ~0x03;
+    if (recorder_size() + size > RECORDER_SIZE) {
+        return false;
+    }
+
+    const uint16_t header = length;
+    _put((const uint8_t *)&header, RECORDER_HEADER_SIZE);
+    _put(data, length);
+    _put(NULL, size - RECORDER_HEADER_SIZE - length);
+    return true;
+}
+
+void recorder_flush(void) {
+    if (_recorder_vars.started && _recorder_buffer.offset < RECORDER_SIZE) {
+        _write();
+    }
+}
+
+uint32_t recorder_size(void) {
+    if (!_recorder_vars.started) {
+        return _recorder_vars.size;
+    }
+    return _recorder_buffer.offset + _recorder_buffer.length;
+}
@@ -0,0 +1,57 @@
+#ifndef __RECORDER_H
+#define __RECORDER_H
+
+/**
+ * @defgroup    bsp_recorder  Experiment data recorder
+ * @ingroup     bsp
+ * @brief       Append records of the user image to a flash region, read back once the image is stopped
+ *
+ * A run of the user image records from the start of the region, erasing the pages as they are
+ * reached. Records are buffered by page in RAM that is not initialized at boot, so the records of
+ * an image stopped by a reset are written back by the bootloader.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "localization.h"
+
+#define RECORDER_ADDRESS    (0x000DF000UL)  ///< First flash page of the records, after the user image
+#define RECORDER_SIZE       (LOCALIZATION_CALIBRATION_ADDRESS - 0x1000UL - RECORDER_ADDRESS)   ///< 124kiB, one page is kept before the calibration page
+
+/**
+ * @brief Write back the records buffered by the previous image and find the size of the records
+ */
+void recorder_init(void);
+
+/**
+ * @brief Append a record, the first record of a run restarts from the start of the region
+ *
+ * Blocks while a full page is written and the next one erased.
+ *
+ * @param[in] data      Content of the record
+ * @param[in] length    Length of the record in bytes
+ *
+ * @return false if the region is full
+ */
+bool recorder_append(const uint8_t *data, uint8_t length);
+
+/**
+ * @brief Write the buffered records to flash
+ */
+void recorder_flush(void);
+
+/**
+ * @brief Return the number of recorded bytes, records start with their 16-bit length and are padded to 4 bytes
+ *
+ * @return size of the records in bytes
+ */
+uint32_t recorder_size(void);
+
+#endif // __RECORDER_H
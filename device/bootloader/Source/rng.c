@@ -26,6 +26,9 @@ void rng_init(void) {
 }
 
 void rng_read(uint8_t *value) {
-    ipc_network_call(IPC_RNG_READ_REQ);
+    // Leave the value unchanged if the network core doesn't answer
+    if (!ipc_network_call_timeout(IPC_RNG_READ_REQ, IPC_REQ_TIMEOUT_US)) {
+        return;
+    }
     *value = ipc_shared_data.rng.value;
 }
@@ -0,0 +1,32 @@
+#include <nrf.h>
+#include <stdint.h>
+
+#include "timebase.h"
+
+static uint8_t _timebase_users = 0;
+
+void timebase_init(void) {
+    TIMEBASE_TIMER->TASKS_STOP  = 1;
+    TIMEBASE_TIMER->TASKS_CLEAR = 1;
+    TIMEBASE_TIMER->PRESCALER   = 4;  // Run TIMER at 1MHz
+    TIMEBASE_TIMER->BITMODE     = (TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos);
+    TIMEBASE_TIMER->SHORTS      = 0;
+    _timebase_users             = 0;
+}
+
+void timebase_acquire(void) {
+    if (_timebase_users++ == 0) {
+        TIMEBASE_TIMER->TASKS_START = 1;
+    }
+}
+
+void timebase_release(void) {
+    if (_timebase_users && --_timebase_users == 0) {
+        TIMEBASE_TIMER->TASKS_STOP = 1;
+    }
+}
+
+uint32_t timebase_now(void) {
+    TIMEBASE_TIMER->TASKS_CAPTURE[TIMEBASE_CC_NOW] = 1;
+    return TIMEBASE_TIMER->CC[TIMEBASE_CC_NOW];
+}
@@ -0,0 +1,57 @@
+#ifndef __TIMEBASE_H
+#define __TIMEBASE_H
+
+/**
+ * @defgroup    bsp_timebase  Secure microsecond timebase
+ * @ingroup     bsp
+ * @brief       Free-running 1MHz secure timer shared by the IPC timeouts, the network time and the GPIO capture
+ *
+ * The timer only runs while it is used by at least one module. It is never cleared, so each
+ * module uses its own capture/compare channel relative to the current value.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+#include <nrf.h>
+
+#define TIMEBASE_TIMER          (NRF_TIMER2_S)
+#define TIMEBASE_TIMER_IRQ      (TIMER2_IRQn)
+
+/// Capture/compare channels of the timebase timer
+typedef enum {
+    TIMEBASE_CC_TIMEOUT         = 0,    ///< Compared to wake up on IPC request timeouts
+    TIMEBASE_CC_NOW             = 1,    ///< Captured by software to read the current value
+    TIMEBASE_CC_ANCHOR          = 2,    ///< Captured by hardware on the network time anchors
+    TIMEBASE_CC_GPIO            = 3,    ///< First channel captured by hardware on GPIO events
+} timebase_cc_t;
+
+#define TIMEBASE_CC_GPIO_COUNT  (3U)    ///< Number of channels captured on GPIO events, up to the last one
+
+/**
+ * @brief Configure the timer, it doesn't run until it is acquired
+ */
+void timebase_init(void);
+
+/**
+ * @brief Start the timer if it is not already used by another module
+ */
+void timebase_acquire(void);
+
+/**
+ * @brief Stop the timer if it is not used by another module anymore
+ */
+void timebase_release(void);
+
+/**
+ * @brief Return the current value of the timer, it must be acquired
+ *
+ * @return value of the timer in us
+ */
+uint32_t timebase_now(void);
+
+#endif // __TIMEBASE_H
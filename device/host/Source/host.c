@@ -0,0 +1,935 @@
+/**
+ * @file
+ * @ingroup host
+ *
+ * @brief  Scheduling of the cores and peripherals of the simulated devices
+ *
+ * The firmware globals of each core are linked in their own section, the
+ * sections of the selected device are swapped in before it runs and its flash is
+ * moved at the addresses used by the firmware.
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <nrf.h>
+#include "host.h"
+
+//=========================== defines ==========================================
+
+#define HOST_APP_FLASH_ADDRESS  (0x00010000UL)  ///< Flash after the bootloader, holding the user image, the records and the calibration
+#define HOST_APP_FLASH_SIZE     (0x000F0000UL)
+#define HOST_NET_FLASH_ADDRESS  (0x0103F000UL)  ///< Last page of the network core flash, holding its configuration
+#define HOST_NET_FLASH_SIZE     (0x00001000UL)
+#define HOST_STACK_SIZE         (128U * 1024U)
+#define HOST_INBOX_SLOTS        (32U)           ///< Frames received by a device and not handled yet
+#define HOST_RECORD_SLOTS       (64U)           ///< Data queued for the user image of a device
+#define HOST_OUTBOX_SLOTS       (4096U)         ///< Frames sent by the swarm and not transmitted yet
+#define HOST_STEPS_MAX          (100000U)       ///< Core switches in a row after which a device is considered stuck
+#define HOST_IRQS_MAX           (1000U)         ///< Interrupts taken in a row after which an interrupt is considered stuck
+#define HOST_WDT_CLOCK_HZ       (32768U)
+#define HOST_APP_CPU_MHZ        (64U)
+#define HOST_NET_CPU_MHZ        (128U)
+
+typedef enum {
+    HOST_CORE_APP,
+    HOST_CORE_NET,
+    HOST_CORE_COUNT,
+} host_core_id_t;
+
+typedef enum {
+    HOST_CORE_OFF,      ///< Returned from main
+    HOST_CORE_RUNNING,
+    HOST_CORE_WAITING,  ///< Waiting for an event, or reset and not started yet
+    HOST_CORE_HALTED,   ///< Requested a system reset
+} host_core_state_t;
+
+typedef struct {
+    bool            armed;
+    uint64_t        deadline;
+    uint32_t        period;     ///< 0 for a one shot timer
+    host_timer_cb_t cb;
+} host_timer_t;
+
+typedef struct {
+    bool        running;
+    uint32_t    base;           ///< Counter value when started
+    uint64_t    started_at;
+    uint32_t    last;           ///< Counter value at the previous update, compares are matched since then
+    uint32_t    inten;
+} host_timer2_t;
+
+typedef struct {
+    host_core_id_t      id;
+    host_node_t         *node;
+    host_core_state_t   state;
+    ucontext_t          context;
+    ucontext_t          caller;     ///< Context resumed when the core waits
+    uint8_t             *stack;
+    host_peripherals_t  regs;
+    bool                event;      ///< Event register of WFE
+    host_timer_t        timers[HOST_TIMER_CHANNELS];
+    host_timer2_t       timer2;
+    bool                wdt1_running;   ///< Survives the system reset requests, only the watchdog reset stops it
+    uint64_t            wdt1_deadline;
+    uint32_t            cpu_mhz;
+    uint64_t            cycles_at;  ///< Host time of the latest cycle counter update in ns, 0 when not running
+    bool                line_start;
+} host_core_t;
+
+typedef struct {
+    uint8_t length;
+    int8_t  rssi;
+    uint8_t buffer[HOST_FRAME_SIZE_MAX];
+} host_frame_t;
+
+typedef struct {
+    uint8_t length;
+    uint8_t data[UINT8_MAX];
+} host_record_t;
+
+struct host_node {
+    host_swarm_t    *swarm;
+    size_t          index;          ///< Index in the swarm
+    uint64_t        device_id;
+    uint64_t        now;
+    uint64_t        deadline;       ///< Next time the device must run
+    host_core_t     cores[HOST_CORE_COUNT];
+    uint8_t         *app_state;     ///< Globals of the cores while the device isn't selected
+    uint8_t         *net_state;
+    uint8_t         *retained;
+    uint8_t         *app_flash;     ///< Current address of the flash mappings
+    uint8_t         *net_flash;
+    host_robot_t    robot;
+    host_frame_t    inbox[HOST_INBOX_SLOTS];
+    uint32_t        inbox_head;
+    uint32_t        inbox_tail;
+    host_record_t   records[HOST_RECORD_SLOTS];
+    uint32_t        records_head;
+    uint32_t        records_tail;
+    bool            user_image;     ///< The application core runs the user image
+};
+
+typedef struct {
+    uint64_t        source;
+    host_frame_t    frame;
+} host_outbox_frame_t;
+
+struct host_swarm {
+    host_node_t         **nodes;
+    size_t              count;
+    size_t              capacity;
+    host_outbox_frame_t outbox[HOST_OUTBOX_SLOTS];
+    uint32_t            outbox_head;
+    uint32_t            outbox_tail;
+};
+
+//=========================== variables ========================================
+
+// Sections created by host.ld, renamed for each core when the shims are linked
+extern uint8_t __start_host_app_state[], __stop_host_app_state[];
+extern uint8_t __start_host_net_state[], __stop_host_net_state[];
+extern uint8_t __start_host_app_retained[], __stop_host_app_retained[];
+
+static host_peripherals_t _no_peripherals;
+host_peripherals_t *host_peripherals = &_no_peripherals;
+
+static struct {
+    bool        initialized;
+    bool        verbose;
+    int         flash_fd;           ///< Erased flash, mapped copy on write by each device
+    uint8_t     *app_state_init;    ///< Globals of the cores at load time
+    uint8_t     *net_state_init;
+    host_node_t *selected;          ///< Device whose globals and flash are in place
+    host_core_t *current;           ///< Core running
+} _host_vars;
+
+//=========================== private ==========================================
+
+static size_t _app_state_size(void) {
+    return __stop_host_app_state - __start_host_app_state;
+}
+
+static size_t _net_state_size(void) {
+    return __stop_host_net_state - __start_host_net_state;
+}
+
+static size_t _retained_size(void) {
+    return __stop_host_app_retained - __start_host_app_retained;
+}
+
+static uint64_t _clock_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static bool _reserve(uintptr_t address, size_t size) {
+    void *ptr = mmap((void *)address, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    if (ptr == MAP_FAILED || ptr != (void *)address) {
+        if (ptr != MAP_FAILED) {
+            munmap(ptr, size);
+        }
+        return false;
+    }
+    return true;
+}
+
+static uint8_t *_flash_move(uint8_t *from, size_t size, uint8_t *to) {
+    // mremap keeps a mapping in place when it doesn't grow, it is moved over a placeholder
+    if (to == NULL) {
+        to = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (to == MAP_FAILED) {
+            perror("host: flash placeholder");
+            abort();
+        }
+    }
+    void *moved = mremap(from, size, size, MREMAP_MAYMOVE | MREMAP_FIXED, to);
+    if (moved == MAP_FAILED) {
+        perror("host: flash move");
+        abort();
+    }
+    return moved;
+}
+
+static void _flash_park(host_node_t *node) {
+    node->app_flash = _flash_move(node->app_flash, HOST_APP_FLASH_SIZE, NULL);
+    node->net_flash = _flash_move(node->net_flash, HOST_NET_FLASH_SIZE, NULL);
+    if (!_reserve(HOST_APP_FLASH_ADDRESS, HOST_APP_FLASH_SIZE) || !_reserve(HOST_NET_FLASH_ADDRESS, HOST_NET_FLASH_SIZE)) {
+        fputs("host: flash address range taken\n", stderr);
+        abort();
+    }
+}
+
+static void _flash_place(host_node_t *node) {
+    node->app_flash = _flash_move(node->app_flash, HOST_APP_FLASH_SIZE, (uint8_t *)HOST_APP_FLASH_ADDRESS);
+    node->net_flash = _flash_move(node->net_flash, HOST_NET_FLASH_SIZE, (uint8_t *)HOST_NET_FLASH_ADDRESS);
+}
+
+static void _select(host_node_t *node) {
+    if (_host_vars.selected == node) {
+        return;
+    }
+
+    host_node_t *previous = _host_vars.selected;
+    if (previous) {
+        memcpy(previous->app_state, __start_host_app_state, _app_state_size());
+        memcpy(previous->net_state, __start_host_net_state, _net_state_size());
+        memcpy(previous->retained, __start_host_app_retained, _retained_size());
+        _flash_park(previous);
+    }
+    _host_vars.selected = node;
+    if (node) {
+        memcpy(__start_host_app_state, node->app_state, _app_state_size());
+        memcpy(__start_host_net_state, node->net_state, _net_state_size());
+        memcpy(__start_host_app_retained, node->retained, _retained_size());
+        _flash_place(node);
+    }
+}
+
+static void _cycles_sync(host_core_t *core) {
+    uint64_t now = _clock_ns();
+    if (core->cycles_at && (core->regs.dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+        core->regs.dwt.CYCCNT += (uint32_t)((now - core->cycles_at) * core->cpu_mhz / 1000);
+    }
+    core->cycles_at = now;
+}
+
+static void _cycles_start(host_core_t *core) {
+    if (core) {
+        core->cycles_at = _clock_ns();
+    }
+}
+
+static void _cycles_stop(host_core_t *core) {
+    if (core) {
+        _cycles_sync(core);
+        core->cycles_at = 0;
+    }
+}
+
+//=========================== timer2 ===========================================
+
+static uint32_t _timer2_value(host_core_t *core) {
+    const host_timer2_t *timer = &core->timer2;
+    if (!timer->running) {
+        return timer->base;
+    }
+    return timer->base + (uint32_t)(core->node->now - timer->started_at);
+}
+
+static void _timer2_update(host_core_t *core) {
+    NRF_TIMER_Type *regs = &core->regs.timer2;
+    host_timer2_t *timer = &core->timer2;
+
+    // Tasks are triggered by the firmware writes, they are handled on the next access
+    if (regs->TASKS_STOP) {
+        regs->TASKS_STOP = 0;
+        timer->base = _timer2_value(core);
+        timer->running = false;
+    }
+    if (regs->TASKS_CLEAR) {
+        regs->TASKS_CLEAR = 0;
+        timer->base = 0;
+        timer->started_at = core->node->now;
+        timer->last = 0;
+    }
+    if (regs->TASKS_START) {
+        regs->TASKS_START = 0;
+        if (!timer->running) {
+            timer->running = true;
+            timer->started_at = core->node->now;
+        }
+    }
+
+    uint32_t value = _timer2_value(core);
+    for (uint8_t channel = 0; channel < 6; channel++) {
+        if (regs->TASKS_CAPTURE[channel]) {
+            regs->TASKS_CAPTURE[channel] = 0;
+            regs->CC[channel] = value;
+        }
+    }
+    timer->inten = (timer->inten | regs->INTENSET) & ~regs->INTENCLR;
+    regs->INTENSET = 0;
+    regs->INTENCLR = 0;
+
+    // Compares reached since the previous update
+    if (timer->running) {
+        for (uint8_t channel = 0; channel < 6; channel++) {
+            if ((uint32_t)(regs->CC[channel] - timer->last - 1) < (uint32_t)(value - timer->last)) {
+                regs->EVENTS_COMPARE[channel] = 1;
+            }
+        }
+    }
+    timer->last = value;
+}
+
+static bool _timer2_compare0_enabled(host_core_t *core) {
+    return core->timer2.running && (core->timer2.inten & (TIMER_INTENSET_COMPARE0_Enabled << TIMER_INTENSET_COMPARE0_Pos));
+}
+
+static bool _timer2_wakeup(host_core_t *core) {
+    // The timer interrupt is not enabled in the NVIC, pending it only wakes up WFE with SEVONPEND
+    _timer2_update(core);
+    return _timer2_compare0_enabled(core) && core->regs.timer2.EVENTS_COMPARE[0] && (core->regs.scb.SCR & SCB_SCR_SEVONPEND_Msk);
+}
+
+static uint64_t _timer2_deadline(host_core_t *core) {
+    _timer2_update(core);
+    if (!_timer2_compare0_enabled(core) || core->regs.timer2.EVENTS_COMPARE[0]) {
+        return HOST_NEVER;
+    }
+    uint32_t remaining = core->regs.timer2.CC[0] - _timer2_value(core);
+    return core->node->now + (remaining ? remaining : (1ULL << 32));
+}
+
+//=========================== interrupts =======================================
+
+static bool _ipc_pending(host_core_t *core) {
+    const NVIC_Type *nvic = &core->regs.nvic;
+    const NRF_IPC_Type *ipc = &core->regs.ipc;
+    uint32_t mask = 1UL << (IPC_IRQn & 0x1F);
+
+    if (!(nvic->ISER[IPC_IRQn >> 5] & mask)) {
+        return false;
+    }
+    if (nvic->ISPR[IPC_IRQn >> 5] & mask) {
+        return true;
+    }
+    for (uint8_t channel = 0; channel < 16; channel++) {
+        if (ipc->EVENTS_RECEIVE[channel] && (ipc->INTENSET & (1UL << channel))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static host_timer_t *_timer_expired(host_core_t *core) {
+    host_timer_t *expired = NULL;
+    for (uint8_t channel = 0; channel < HOST_TIMER_CHANNELS; channel++) {
+        host_timer_t *timer = &core->timers[channel];
+        if (timer->armed && timer->deadline <= core->node->now && (expired == NULL || timer->deadline < expired->deadline)) {
+            expired = timer;
+        }
+    }
+    return expired;
+}
+
+static bool _radio_pending(host_core_t *core) {
+    return core->id == HOST_CORE_NET && core->node->inbox_head != core->node->inbox_tail;
+}
+
+static bool _irq_pending(host_core_t *core) {
+    return _timer_expired(core) || _radio_pending(core) || _ipc_pending(core) || _timer2_wakeup(core);
+}
+
+static void _take_irqs(host_core_t *core) {
+    for (uint32_t taken = 0; taken < HOST_IRQS_MAX; taken++) {
+        host_timer_t *timer = _timer_expired(core);
+        if (timer) {
+            if (timer->period) {
+                timer->deadline += timer->period;
+                if (timer->deadline <= core->node->now) {
+                    timer->deadline = core->node->now + timer->period;
+                }
+            } else {
+                timer->armed = false;
+            }
+            timer->cb();
+        } else if (_radio_pending(core)) {
+            host_net_radio_irq();
+        } else if (_ipc_pending(core)) {
+            // The pending state is cleared when the handler is entered
+            core->regs.nvic.ISPR[IPC_IRQn >> 5] &= ~(1UL << (IPC_IRQn & 0x1F));
+            if (core->id == HOST_CORE_NET) {
+                host_net_ipc_irq();
+            } else if (core->regs.nvic.ITNS[IPC_IRQn >> 5] & (1UL << (IPC_IRQn & 0x1F))) {
+                host_app_user_ipc_irq();
+            } else {
+                host_app_ipc_irq();
+            }
+        } else {
+            return;
+        }
+    }
+    host_puts("host: interrupt stuck");
+}
+
+//=========================== ipc ==============================================
+
+static void _publish(host_core_t *core, uint32_t channel) {
+    // DPPI channels are connected to the watchdog 1 start and to the timebase captures only
+    NRF_WDT_Type *wdt = &core->regs.wdt1;
+    if ((wdt->SUBSCRIBE_START & (WDT_SUBSCRIBE_START_EN_Enabled << WDT_SUBSCRIBE_START_EN_Pos)) &&
+        (wdt->SUBSCRIBE_START & WDT_SUBSCRIBE_START_CHIDX_Msk) == channel && !core->wdt1_running) {
+        core->wdt1_running = true;
+        core->wdt1_deadline = core->node->now + ((uint64_t)wdt->CRV + 1) * 1000000 / HOST_WDT_CLOCK_HZ;
+    }
+
+    NRF_TIMER_Type *timer = &core->regs.timer2;
+    for (uint8_t cc = 0; cc < 6; cc++) {
+        if ((timer->SUBSCRIBE_CAPTURE[cc] & (TIMER_SUBSCRIBE_CAPTURE_EN_Enabled << TIMER_SUBSCRIBE_CAPTURE_EN_Pos)) &&
+            (timer->SUBSCRIBE_CAPTURE[cc] & TIMER_SUBSCRIBE_CAPTURE_CHIDX_Msk) == channel) {
+            _timer2_update(core);
+            timer->CC[cc] = _timer2_value(core);
+        }
+    }
+}
+
+static void _route(host_core_t *sender) {
+    host_core_t *peer = &sender->node->cores[(sender->id == HOST_CORE_APP) ? HOST_CORE_NET : HOST_CORE_APP];
+    NRF_IPC_Type *tx = &sender->regs.ipc;
+    NRF_IPC_Type *rx = &peer->regs.ipc;
+
+    for (uint8_t task = 0; task < 16; task++) {
+        if (!tx->TASKS_SEND[task]) {
+            continue;
+        }
+        tx->TASKS_SEND[task] = 0;
+        for (uint8_t event = 0; event < 16; event++) {
+            if (!(rx->RECEIVE_CNF[event] & tx->SEND_CNF[task])) {
+                continue;
+            }
+            rx->EVENTS_RECEIVE[event] = 1;
+            if (rx->PUBLISH_RECEIVE[event] & (IPC_PUBLISH_RECEIVE_EN_Enabled << IPC_PUBLISH_RECEIVE_EN_Pos)) {
+                _publish(peer, rx->PUBLISH_RECEIVE[event] & IPC_PUBLISH_RECEIVE_CHIDX_Msk);
+            }
+        }
+    }
+}
+
+//=========================== cores ============================================
+
+static void _resume(host_core_t *core) {
+    host_core_t *previous = _host_vars.current;
+    _cycles_stop(previous);
+    _host_vars.current = core;
+    host_peripherals = &core->regs;
+    core->state = HOST_CORE_RUNNING;
+    _cycles_start(core);
+
+    swapcontext(&core->caller, &core->context);
+
+    _cycles_stop(core);
+    _host_vars.current = previous;
+    host_peripherals = previous ? &previous->regs : &_no_peripherals;
+    _cycles_start(previous);
+}
+
+static void _yield(host_core_t *core) {
+    swapcontext(&core->context, &core->caller);
+}
+
+static void _core_entry(void) {
+    host_core_t *core = _host_vars.current;
+    if (core->id == HOST_CORE_APP) {
+        host_app_main();
+    } else {
+        host_net_main();
+    }
+    core->state = HOST_CORE_OFF;
+    _yield(core);
+}
+
+static void _core_reset(host_core_t *core, uint32_t reason) {
+    host_node_t *node = core->node;
+
+    // RAM is kept, it is initialized again like by the startup code
+    if (core->id == HOST_CORE_APP) {
+        memcpy(__start_host_app_state, _host_vars.app_state_init, _app_state_size());
+        node->user_image = false;
+        node->records_tail = node->records_head;
+    } else {
+        memcpy(__start_host_net_state, _host_vars.net_state_init, _net_state_size());
+    }
+
+    memset(&core->regs, 0, sizeof(host_peripherals_t));
+    core->regs.ficr.INFO.DEVICEID[0] = (uint32_t)node->device_id;
+    core->regs.ficr.INFO.DEVICEID[1] = (uint32_t)(node->device_id >> 32);
+    core->regs.nvmc.READY = 1;
+    core->regs.reset.NETWORK.FORCEOFF = RESET_NETWORK_FORCEOFF_FORCEOFF_Release << RESET_NETWORK_FORCEOFF_FORCEOFF_Pos;
+    core->regs.reset.RESETREAS = reason;
+    memset(core->timers, 0, sizeof(core->timers));
+    memset(&core->timer2, 0, sizeof(host_timer2_t));
+    core->cycles_at = 0;
+    core->line_start = true;
+
+    getcontext(&core->context);
+    core->context.uc_stack.ss_sp = core->stack;
+    core->context.uc_stack.ss_size = HOST_STACK_SIZE;
+    core->context.uc_link = NULL;
+    makecontext(&core->context, _core_entry, 0);
+
+    // Started on the next step, like after an event
+    core->state = HOST_CORE_WAITING;
+    core->event = true;
+}
+
+static bool _core_ready(host_core_t *core) {
+    return core->state == HOST_CORE_WAITING && (core->event || _irq_pending(core));
+}
+
+static uint64_t _core_deadline(host_core_t *core) {
+    uint64_t deadline = core->wdt1_running ? core->wdt1_deadline : HOST_NEVER;
+    if (core->state != HOST_CORE_WAITING) {
+        return deadline;
+    }
+    for (uint8_t channel = 0; channel < HOST_TIMER_CHANNELS; channel++) {
+        if (core->timers[channel].armed && core->timers[channel].deadline < deadline) {
+            deadline = core->timers[channel].deadline;
+        }
+    }
+    uint64_t timeout = _timer2_deadline(core);
+    return (timeout < deadline) ? timeout : deadline;
+}
+
+//=========================== nodes ============================================
+
+static uint64_t _node_deadline(host_node_t *node) {
+    uint64_t deadline = HOST_NEVER;
+    for (uint8_t id = 0; id < HOST_CORE_COUNT; id++) {
+        uint64_t core_deadline = _core_deadline(&node->cores[id]);
+        if (core_deadline < deadline) {
+            deadline = core_deadline;
+        }
+    }
+    return deadline;
+}
+
+static void _node_step(host_node_t *node) {
+    host_core_t *app = &node->cores[HOST_CORE_APP];
+    host_core_t *net = &node->cores[HOST_CORE_NET];
+
+    // The network core runs first, it must be ready when the application core boots
+    for (uint32_t step = 0; step < HOST_STEPS_MAX; step++) {
+        if (app->wdt1_running && app->wdt1_deadline <= node->now) {
+            app->wdt1_running = false;
+            _core_reset(app, RESET_RESETREAS_DOG1_Detected << RESET_RESETREAS_DOG1_Pos);
+        } else if (net->state == HOST_CORE_HALTED) {
+            _core_reset(net, RESET_RESETREAS_SREQ_Detected << RESET_RESETREAS_SREQ_Pos);
+        } else if (app->state == HOST_CORE_HALTED) {
+            _core_reset(app, RESET_RESETREAS_SREQ_Detected << RESET_RESETREAS_SREQ_Pos);
+        } else if (_core_ready(net)) {
+            _resume(net);
+        } else if (_core_ready(app)) {
+            _resume(app);
+        } else {
+            node->deadline = _node_deadline(node);
+            return;
+        }
+    }
+    fprintf(stderr, "host: device %016" PRIX64 " stuck\n", node->device_id);
+    node->deadline = _node_deadline(node);
+}
+
+static void _node_run(host_node_t *node, uint64_t now) {
+    _select(node);
+    _node_step(node);
+    while (node->deadline <= now) {
+        if (node->deadline > node->now) {
+            node->now = node->deadline;
+        }
+        _node_step(node);
+    }
+    if (now > node->now) {
+        node->now = now;
+    }
+    node->deadline = _node_deadline(node);
+}
+
+static void _power_on(host_node_t *node) {
+    // Only the flash content is kept
+    memset(__start_host_app_retained, 0, _retained_size());
+    node->inbox_tail = node->inbox_head;
+    for (uint8_t id = 0; id < HOST_CORE_COUNT; id++) {
+        node->cores[id].wdt1_running = false;
+        _core_reset(&node->cores[id], 0);
+    }
+    node->robot.left_speed = 0;
+    node->robot.right_speed = 0;
+    node->robot.moved_at = node->now;
+    _node_step(node);
+}
+
+//=========================== public ===========================================
+
+bool host_init(bool verbose) {
+    _host_vars.verbose = verbose;
+    if (_host_vars.initialized) {
+        return true;
+    }
+
+    if (!_reserve(HOST_APP_FLASH_ADDRESS, HOST_APP_FLASH_SIZE)) {
+        return false;
+    }
+    if (!_reserve(HOST_NET_FLASH_ADDRESS, HOST_NET_FLASH_SIZE)) {
+        munmap((void *)HOST_APP_FLASH_ADDRESS, HOST_APP_FLASH_SIZE);
+        return false;
+    }
+
+    // Erased flash reads 0xFF, the pages written by each device are copied on write
+    size_t flash_size = HOST_APP_FLASH_SIZE + HOST_NET_FLASH_SIZE;
+    _host_vars.flash_fd = memfd_create("swarmit-flash", MFD_CLOEXEC);
+    if (_host_vars.flash_fd < 0 || ftruncate(_host_vars.flash_fd, flash_size) < 0) {
+        return false;
+    }
+    uint8_t *flash = mmap(NULL, flash_size, PROT_READ | PROT_WRITE, MAP_SHARED, _host_vars.flash_fd, 0);
+    if (flash == MAP_FAILED) {
+        return false;
+    }
+    memset(flash, 0xFF, flash_size);
+    munmap(flash, flash_size);
+
+    _host_vars.app_state_init = malloc(_app_state_size());
+    _host_vars.net_state_init = malloc(_net_state_size());
+    memcpy(_host_vars.app_state_init, __start_host_app_state, _app_state_size());
+    memcpy(_host_vars.net_state_init, __start_host_net_state, _net_state_size());
+    _host_vars.initialized = true;
+    return true;
+}
+
+host_swarm_t *host_swarm_create(void) {
+    return calloc(1, sizeof(host_swarm_t));
+}
+
+void host_swarm_destroy(host_swarm_t *swarm) {
+    while (swarm->count) {
+        host_node_destroy(swarm->nodes[swarm->count - 1]);
+    }
+    free(swarm->nodes);
+    free(swarm);
+}
+
+uint64_t host_swarm_run(host_swarm_t *swarm, uint64_t now) {
+    uint64_t deadline = HOST_NEVER;
+    for (size_t index = 0; index < swarm->count; index++) {
+        host_node_t *node = swarm->nodes[index];
+        if (node->deadline <= now) {
+            _node_run(node, now);
+        }
+        if (node->deadline < deadline) {
+            deadline = node->deadline;
+        }
+    }
+    return deadline;
+}
+
+size_t host_swarm_transmit(host_swarm_t *swarm, uint64_t *source, uint8_t *buffer) {
+    if (swarm->outbox_head == swarm->outbox_tail) {
+        return 0;
+    }
+    const host_outbox_frame_t *frame = &swarm->outbox[swarm->outbox_tail++ % HOST_OUTBOX_SLOTS];
+    *source = frame->source;
+    memcpy(buffer, frame->frame.buffer, frame->frame.length);
+    return frame->frame.length;
+}
+
+host_node_t *host_node_create(host_swarm_t *swarm, uint64_t device_id, uint64_t now, int32_t x, int32_t y) {
+    // Both cores share a mapping for their stacks, the number of mappings of a process is limited
+    uint8_t *stacks = mmap(NULL, HOST_STACK_SIZE * HOST_CORE_COUNT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+    uint8_t *app_flash = mmap(NULL, HOST_APP_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, _host_vars.flash_fd, 0);
+    uint8_t *net_flash = mmap(NULL, HOST_NET_FLASH_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE, _host_vars.flash_fd, HOST_APP_FLASH_SIZE);
+    if (stacks == MAP_FAILED || app_flash == MAP_FAILED || net_flash == MAP_FAILED) {
+        if (stacks != MAP_FAILED) {
+            munmap(stacks, HOST_STACK_SIZE * HOST_CORE_COUNT);
+        }
+        if (app_flash != MAP_FAILED) {
+            munmap(app_flash, HOST_APP_FLASH_SIZE);
+        }
+        if (net_flash != MAP_FAILED) {
+            munmap(net_flash, HOST_NET_FLASH_SIZE);
+        }
+        return NULL;
+    }
+
+    host_node_t *node = calloc(1, sizeof(host_node_t));
+    node->swarm = swarm;
+    node->device_id = device_id;
+    node->now = now;
+    node->app_state = malloc(_app_state_size());
+    node->net_state = malloc(_net_state_size());
+    node->retained = calloc(1, _retained_size() ? _retained_size() : 1);
+    node->app_flash = app_flash;
+    node->net_flash = net_flash;
+    memcpy(node->app_state, _host_vars.app_state_init, _app_state_size());
+    memcpy(node->net_state, _host_vars.net_state_init, _net_state_size());
+    node->robot.x = x;
+    node->robot.y = y;
+
+    for (uint8_t id = 0; id < HOST_CORE_COUNT; id++) {
+        host_core_t *core = &node->cores[id];
+        core->id = id;
+        core->node = node;
+        core->cpu_mhz = (id == HOST_CORE_APP) ? HOST_APP_CPU_MHZ : HOST_NET_CPU_MHZ;
+        core->stack = stacks + id * HOST_STACK_SIZE;
+    }
+
+    if (swarm->count == swarm->capacity) {
+        swarm->capacity = swarm->capacity ? swarm->capacity * 2 : 64;
+        swarm->nodes = realloc(swarm->nodes, swarm->capacity * sizeof(host_node_t *));
+    }
+    node->index = swarm->count;
+    swarm->nodes[swarm->count++] = node;
+
+    _select(node);
+    _power_on(node);
+    return node;
+}
+
+void host_node_destroy(host_node_t *node) {
+    if (_host_vars.selected == node) {
+        _select(NULL);
+    }
+
+    host_swarm_t *swarm = node->swarm;
+    swarm->nodes[node->index] = swarm->nodes[--swarm->count];
+    swarm->nodes[node->index]->index = node->index;
+
+    munmap(node->app_flash, HOST_APP_FLASH_SIZE);
+    munmap(node->net_flash, HOST_NET_FLASH_SIZE);
+    munmap(node->cores[HOST_CORE_APP].stack, HOST_STACK_SIZE * HOST_CORE_COUNT);
+    free(node->app_state);
+    free(node->net_state);
+    free(node->retained);
+    free(node);
+}
+
+void host_node_reboot(host_node_t *node, uint64_t now) {
+    _node_run(node, now);
+    _power_on(node);
+}
+
+void host_node_receive(host_node_t *node, uint64_t now, const uint8_t *buffer, size_t length, int8_t rssi) {
+    _node_run(node, now);
+    if (length == 0 || length > HOST_FRAME_SIZE_MAX || node->inbox_head - node->inbox_tail >= HOST_INBOX_SLOTS) {
+        return;
+    }
+    host_frame_t *frame = &node->inbox[node->inbox_head++ % HOST_INBOX_SLOTS];
+    frame->length = length;
+    frame->rssi = rssi;
+    memcpy(frame->buffer, buffer, length);
+    _node_step(node);
+}
+
+uint8_t host_node_status(host_node_t *node) {
+    _select(node);
+    return host_net_status();
+}
+
+bool host_node_record(host_node_t *node, uint64_t now, const uint8_t *data, uint8_t length) {
+    _node_run(node, now);
+    if (!node->user_image || node->records_head - node->records_tail >= HOST_RECORD_SLOTS) {
+        return false;
+    }
+    host_record_t *record = &node->records[node->records_head++ % HOST_RECORD_SLOTS];
+    record->length = length;
+    memcpy(record->data, data, length);
+    node->cores[HOST_CORE_APP].event = true;
+    _node_step(node);
+    return true;
+}
+
+bool host_node_flash_read(host_node_t *node, uint32_t address, uint8_t *buffer, size_t length) {
+    if (address >= HOST_APP_FLASH_ADDRESS && address + length <= HOST_APP_FLASH_ADDRESS + HOST_APP_FLASH_SIZE) {
+        memcpy(buffer, node->app_flash + (address - HOST_APP_FLASH_ADDRESS), length);
+        return true;
+    }
+    if (address >= HOST_NET_FLASH_ADDRESS && address + length <= HOST_NET_FLASH_ADDRESS + HOST_NET_FLASH_SIZE) {
+        memcpy(buffer, node->net_flash + (address - HOST_NET_FLASH_ADDRESS), length);
+        return true;
+    }
+    return false;
+}
+
+//=========================== stubs ============================================
+
+uint64_t host_time_us(void) {
+    return _host_vars.current->node->now;
+}
+
+void host_timer_set(uint8_t channel, uint32_t delay_us, uint32_t period_us, host_timer_cb_t cb) {
+    host_timer_t *timer = &_host_vars.current->timers[channel % HOST_TIMER_CHANNELS];
+    timer->armed = true;
+    timer->deadline = host_time_us() + delay_us;
+    timer->period = period_us;
+    timer->cb = cb;
+}
+
+void host_timer_cancel(uint8_t channel) {
+    _host_vars.current->timers[channel % HOST_TIMER_CHANNELS].armed = false;
+}
+
+host_robot_t *host_robot(void) {
+    return &_host_vars.current->node->robot;
+}
+
+void host_radio_push(const uint8_t *buffer, size_t length) {
+    host_swarm_t *swarm = _host_vars.current->node->swarm;
+    if (length == 0 || length > HOST_FRAME_SIZE_MAX || swarm->outbox_head - swarm->outbox_tail >= HOST_OUTBOX_SLOTS) {
+        return;
+    }
+    host_outbox_frame_t *frame = &swarm->outbox[swarm->outbox_head++ % HOST_OUTBOX_SLOTS];
+    frame->source = _host_vars.current->node->device_id;
+    frame->frame.length = length;
+    memcpy(frame->frame.buffer, buffer, length);
+}
+
+size_t host_radio_pop(uint8_t *buffer, int8_t *rssi) {
+    host_node_t *node = _host_vars.current->node;
+    if (node->inbox_head == node->inbox_tail) {
+        return 0;
+    }
+    const host_frame_t *frame = &node->inbox[node->inbox_tail++ % HOST_INBOX_SLOTS];
+    memcpy(buffer, frame->buffer, frame->length);
+    *rssi = frame->rssi;
+    return frame->length;
+}
+
+bool host_record_pop(uint8_t *buffer, uint8_t *length) {
+    host_node_t *node = _host_vars.current->node;
+    if (node->records_head == node->records_tail) {
+        return false;
+    }
+    const host_record_t *record = &node->records[node->records_tail++ % HOST_RECORD_SLOTS];
+    memcpy(buffer, record->data, record->length);
+    *length = record->length;
+    return true;
+}
+
+void host_user_image_started(void) {
+    _host_vars.current->node->user_image = true;
+}
+
+static void _print(const char *text) {
+    host_core_t *core = _host_vars.current;
+    for (; *text; text++) {
+        if (core && core->line_start) {
+            printf("%016" PRIX64 " %s: ", core->node->device_id, (core->id == HOST_CORE_APP) ? "app" : "net");
+        }
+        putchar(*text);
+        if (core) {
+            core->line_start = (*text == '\n');
+        }
+    }
+    fflush(stdout);
+}
+
+int host_printf(const char *format, ...) {
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    if (_host_vars.verbose) {
+        _print(text);
+    }
+    return length;
+}
+
+int host_puts(const char *string) {
+    if (_host_vars.verbose) {
+        _print(string);
+        _print("\n");
+    }
+    return 1;
+}
+
+//=========================== peripherals ======================================
+
+DWT_Type *host_dwt(void) {
+    if (_host_vars.current) {
+        _cycles_sync(_host_vars.current);
+    }
+    return &host_peripherals->dwt;
+}
+
+NRF_TIMER_Type *host_timer2(void) {
+    if (_host_vars.current) {
+        _timer2_update(_host_vars.current);
+    }
+    return &host_peripherals->timer2;
+}
+
+void host_wfe(void) {
+    host_core_t *core = _host_vars.current;
+    _route(core);
+    if (!core->event && !_irq_pending(core)) {
+        core->state = HOST_CORE_WAITING;
+        _yield(core);
+    }
+    core->event = false;
+    _take_irqs(core);
+}
+
+void host_barrier(void) {
+    host_core_t *core = _host_vars.current;
+    _route(core);
+
+    // The network core runs meanwhile on the device, it catches up with the application core here
+    // so the loops waiting for it without sleeping make progress
+    host_core_t *net = &core->node->cores[HOST_CORE_NET];
+    if (core->id == HOST_CORE_APP && _core_ready(net)) {
+        _resume(net);
+    }
+}
+
+void NVIC_SystemReset(void) {
+    host_core_t *core = _host_vars.current;
+    _route(core);
+    core->state = HOST_CORE_HALTED;
+    while (1) {
+        _yield(core);
+    }
+}
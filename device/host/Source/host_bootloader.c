@@ -0,0 +1,326 @@
+/**
+ * @file
+ * @ingroup host
+ *
+ * @brief  Drivers of the bootloader built for the host
+ *
+ * The bootloader sources are built unchanged, only the drivers touching the
+ * flash, the TrustZone configuration and the robot hardware are replaced. The
+ * user image is replaced by a loop recording the data queued by the simulator.
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <arm_cmse.h>
+#include <nrf.h>
+
+#include "battery.h"
+#include "cmse_implib.h"
+#include "gpio.h"
+#include "gpio_capture.h"
+#include "host.h"
+#include "lh2.h"
+#include "motors.h"
+#include "move.h"
+#include "nav.h"
+#include "nvmc.h"
+#include "profile.h"
+#include "saadc.h"
+#include "timer.h"
+#include "tz.h"
+
+//=========================== defines ==========================================
+
+#define HOST_LH2_TIMER_CHANNEL      (0U)        ///< Host timer channel not used by the bootloader
+#define HOST_LH2_SWEEP_PERIOD_US    (20000U)    ///< Period of the simulated sweeps
+#define HOST_BATTERY_LEVEL          (90U)       ///< Battery level in %
+#define HOST_SAADC_VALUE            (2048U)     ///< Value of all the SAADC conversions
+#define HOST_WHEEL_SPEED_UM_S       (2000)      ///< Same as the dead reckoning of the bootloader
+#define HOST_WHEEL_BASE_UM          (60000)
+
+//=========================== variables ========================================
+
+uint32_t SystemCoreClock = 64000000;
+
+const gpio_t db_lh2_d = { .port = 0, .pin = 29 };
+const gpio_t db_lh2_e = { .port = 0, .pin = 30 };
+
+static db_lh2_t *_lh2;
+
+//=========================== robot ============================================
+
+static void _robot_update(host_robot_t *robot) {
+    // Differential drive model, moving along the mean heading of the elapsed time
+    uint64_t now = host_time_us();
+    double elapsed = (now - robot->moved_at) / 1e6;
+    robot->moved_at = now;
+    if (robot->left_speed == 0 && robot->right_speed == 0) {
+        return;
+    }
+    double distance = (robot->left_speed + robot->right_speed) * HOST_WHEEL_SPEED_UM_S * elapsed / 2;
+    double rotation = (robot->left_speed - robot->right_speed) * HOST_WHEEL_SPEED_UM_S * elapsed * NAV_Q16_DEGREES_PER_RADIAN / HOST_WHEEL_BASE_UM;
+    double heading = (robot->heading + rotation / 2) / 65536 * M_PI / 180;
+    robot->x -= (int32_t)(distance * sin(heading));
+    robot->y += (int32_t)(distance * cos(heading));
+    int32_t direction = robot->heading + (int32_t)rotation;
+    robot->heading = direction - (int32_t)lround(direction / (360.0 * 65536)) * (360 << 16);
+}
+
+static void _robot_advance(int32_t heading, int32_t distance) {
+    host_robot_t *robot = host_robot();
+    position_2d_t position = { .x = (uint32_t)robot->x, .y = (uint32_t)robot->y };
+    nav_advance(&position, heading, distance);
+    robot->x = (int32_t)position.x;
+    robot->y = (int32_t)position.y;
+}
+
+//=========================== user image =======================================
+
+static void _rx_data_callback(const uint8_t *data, size_t length) {
+    (void)data;
+    (void)length;
+}
+
+void host_user_image(void) {
+    host_user_image_started();
+    uint8_t data[UINT8_MAX];
+    uint8_t length;
+    while (1) {
+        __WFE();
+        swarmit_keep_alive();
+        while (host_record_pop(data, &length)) {
+            swarmit_record_append(data, length);
+        }
+    }
+}
+
+void host_app_user_ipc_irq(void) {
+    swarmit_ipc_isr_drain(_rx_data_callback);
+}
+
+//=========================== tz ===============================================
+
+void tz_configure_periph_non_secure(uint8_t periph_id) {
+    (void)periph_id;
+}
+
+void tz_configure_periph_dma_non_secure(uint8_t periph_id) {
+    (void)periph_id;
+}
+
+void tz_configure_flash_secure(uint8_t start_region, size_t length) {
+    (void)start_region;
+    (void)length;
+}
+
+void tz_configure_flash_non_secure(uint8_t start_region, size_t length) {
+    (void)start_region;
+    (void)length;
+}
+
+void tz_configure_ram_secure(uint8_t start_region, size_t length) {
+    (void)start_region;
+    (void)length;
+}
+
+void tz_configure_ram_non_secure(uint8_t start_region, size_t length) {
+    (void)start_region;
+    (void)length;
+}
+
+//=========================== nvmc =============================================
+
+void nvmc_page_erase(uint32_t page) {
+    uint32_t start = profile_start();
+    memset((void *)(page * FLASH_PAGE_SIZE), 0xFF, FLASH_PAGE_SIZE);
+    profile_stop(PROFILE_NVMC_PAGE_ERASE, start);
+}
+
+bool nvmc_page_is_blank(uint32_t page) {
+    const uint32_t *addr = (const uint32_t *)(page * FLASH_PAGE_SIZE);
+    for (uint32_t i = 0; i < (FLASH_PAGE_SIZE >> 2); i++) {
+        if (addr[i] != 0xFFFFFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void nvmc_write(const uint32_t *addr, const void *data, size_t len) {
+    // Programming only clears bits, like on the flash
+    uint32_t start = profile_start();
+    uint32_t *dest_addr = (uint32_t *)addr;
+    const uint32_t *data_addr = data;
+    for (uint32_t i = 0; i < (len >> 2); i++) {
+        dest_addr[i] &= data_addr[i];
+    }
+    profile_stop(PROFILE_NVMC_WRITE, start);
+}
+
+//=========================== battery ==========================================
+
+void battery_level_init(void) {}
+
+bool battery_level_update(void) {
+    return true;
+}
+
+void battery_level_flush(void) {}
+
+uint8_t battery_level_read(void) {
+    return HOST_BATTERY_LEVEL;
+}
+
+//=========================== gpio =============================================
+
+bool gpio_capture_enable(uint8_t port, uint8_t pin) {
+    (void)port;
+    (void)pin;
+    return false;
+}
+
+void gpio_capture_flush(void) {}
+
+void db_gpio_init(const gpio_t *gpio, gpio_mode_t mode) {
+    (void)gpio;
+    (void)mode;
+}
+
+void db_gpio_set(const gpio_t *gpio) {
+    (void)gpio;
+}
+
+void db_gpio_clear(const gpio_t *gpio) {
+    (void)gpio;
+}
+
+void db_gpio_toggle(const gpio_t *gpio) {
+    (void)gpio;
+}
+
+uint8_t db_gpio_read(const gpio_t *gpio) {
+    (void)gpio;
+    return 0;
+}
+
+//=========================== saadc ============================================
+
+void db_saadc_init(db_saadc_resolution_t resolution) {
+    (void)resolution;
+}
+
+void db_saadc_read(db_saadc_input_t input, uint16_t *value) {
+    (void)input;
+    *value = HOST_SAADC_VALUE;
+}
+
+//=========================== motors ===========================================
+
+void db_motors_init(void) {}
+
+void db_motors_set_speed(int16_t left_speed, int16_t right_speed) {
+    host_robot_t *robot = host_robot();
+    _robot_update(robot);
+    robot->left_speed = left_speed;
+    robot->right_speed = right_speed;
+}
+
+void db_move_init(void) {
+    db_motors_init();
+}
+
+void db_move_straight(uint16_t distance, int8_t speed) {
+    // Movements are done at once, the bootloader waits for them
+    db_motors_set_speed(0, 0);
+    int32_t distance_um = (int32_t)distance * 1000;
+    _robot_advance(host_robot()->heading, (speed < 0) ? -distance_um : distance_um);
+}
+
+void db_move_rotate(uint16_t angle, int8_t speed) {
+    db_motors_set_speed(0, 0);
+    host_robot_t *robot = host_robot();
+    int32_t rotation = (int32_t)angle << 16;
+    int32_t heading = robot->heading + ((speed < 0) ? rotation : -rotation);
+    if (heading <= -(180 << 16)) {
+        heading += 360 << 16;
+    } else if (heading > (180 << 16)) {
+        heading -= 360 << 16;
+    }
+    robot->heading = heading;
+}
+
+//=========================== timer ============================================
+
+void db_timer_init(uint8_t timer) {
+    (void)timer;
+}
+
+void db_timer_set_periodic_ms(uint8_t timer, uint8_t channel, uint32_t ms, timer_cb_t cb) {
+    (void)timer;
+    host_timer_set(channel, ms * 1000, ms * 1000, cb);
+}
+
+void db_timer_set_oneshot_ms(uint8_t timer, uint8_t channel, uint32_t ms, timer_cb_t cb) {
+    (void)timer;
+    host_timer_set(channel, ms * 1000, 0, cb);
+}
+
+//=========================== lh2 ==============================================
+
+static void _lh2_sweep(void) {
+    // Both sweeps of all the basestations see the robot
+    for (uint8_t sweep = 0; sweep < LH2_SWEEP_COUNT; sweep++) {
+        for (uint8_t basestation = 0; basestation < LH2_BASESTATION_COUNT; basestation++) {
+            _lh2->data_ready[sweep][basestation] = DB_LH2_RAW_DATA_AVAILABLE;
+        }
+    }
+}
+
+void db_lh2_init(db_lh2_t *lh2, const gpio_t *gpio_d, const gpio_t *gpio_e) {
+    (void)gpio_d;
+    (void)gpio_e;
+    memset(lh2, 0, sizeof(db_lh2_t));
+    _lh2 = lh2;
+}
+
+void db_lh2_start(void) {
+    host_timer_set(HOST_LH2_TIMER_CHANNEL, HOST_LH2_SWEEP_PERIOD_US, HOST_LH2_SWEEP_PERIOD_US, _lh2_sweep);
+}
+
+void db_lh2_stop(void) {
+    host_timer_cancel(HOST_LH2_TIMER_CHANNEL);
+}
+
+void db_lh2_process_location(db_lh2_t *lh2) {
+    for (uint8_t sweep = 0; sweep < LH2_SWEEP_COUNT; sweep++) {
+        for (uint8_t basestation = 0; basestation < LH2_BASESTATION_COUNT; basestation++) {
+            if (lh2->data_ready[sweep][basestation] == DB_LH2_RAW_DATA_AVAILABLE) {
+                lh2->data_ready[sweep][basestation] = DB_LH2_PROCESSED_DATA_AVAILABLE;
+            }
+        }
+    }
+}
+
+void db_lh2_handle_isr(void) {}
+
+void db_lh2_store_homography(db_lh2_t *lh2, uint8_t basestation_index, int32_t homography_matrix[3][3]) {
+    (void)lh2;
+    (void)basestation_index;
+    (void)homography_matrix;
+}
+
+void db_lh2_calculate_position(uint32_t count1, uint32_t count2, uint32_t basestation_index, double *coordinates) {
+    (void)count1;
+    (void)count2;
+    (void)basestation_index;
+    host_robot_t *robot = host_robot();
+    _robot_update(robot);
+    coordinates[0] = robot->x / 1e6;
+    coordinates[1] = robot->y / 1e6;
+}
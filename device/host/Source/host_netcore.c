@@ -0,0 +1,131 @@
+/**
+ * @file
+ * @ingroup host
+ *
+ * @brief  Mari stack and drivers of the network core built for the host
+ *
+ * The network core sources are built unchanged. Mari is replaced by the host
+ * frame queues: the node is connected as soon as it is started and every frame
+ * received is handed to the event callback, with its RSSI in the radio sample.
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <nrf.h>
+
+#include "host.h"
+#include "ipc.h"
+#include "mari.h"
+#include "models.h"
+#include "mr_timer_hf.h"
+#include "rng.h"
+
+//=========================== defines ==========================================
+
+#define HOST_GATEWAY_ID     (0x0000000000000001ULL) ///< Reported on connection, the simulator is the only gateway
+
+//=========================== variables ========================================
+
+uint32_t SystemCoreClock = 128000000;
+
+extern volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
+
+// Schedules are only forwarded to Mari, their content doesn't matter
+schedule_t schedule_minuscule, schedule_tiny, schedule_small, schedule_huge, schedule_only_beacons, schedule_only_beacons_optimized_scan;
+
+static struct {
+    mr_event_cb_t   callback;
+    bool            connected;
+    uint64_t        rng_state;
+} _mari_vars;
+
+//=========================== mari =============================================
+
+void mari_init(mr_node_type_t node_type, uint16_t net_id, schedule_t *app_schedule, mr_event_cb_t app_event_callback) {
+    (void)node_type;
+    (void)net_id;
+    (void)app_schedule;
+    _mari_vars.callback = app_event_callback;
+    _mari_vars.connected = true;
+    mr_event_data_t event_data = { .data.gateway_info.gateway_id = HOST_GATEWAY_ID };
+    _mari_vars.callback(MARI_CONNECTED, event_data);
+}
+
+void mari_event_loop(void) {}
+
+void mari_node_tx_payload(uint8_t *payload, uint8_t payload_len) {
+    if (_mari_vars.connected) {
+        host_radio_push(payload, payload_len);
+    }
+}
+
+bool mari_node_is_connected(void) {
+    return _mari_vars.connected;
+}
+
+uint64_t mari_node_gateway_id(void) {
+    return _mari_vars.connected ? HOST_GATEWAY_ID : 0;
+}
+
+void host_net_radio_irq(void) {
+    uint8_t frame[HOST_FRAME_SIZE_MAX];
+    int8_t rssi;
+    size_t length = host_radio_pop(frame, &rssi);
+    if (length == 0 || !_mari_vars.connected) {
+        return;
+    }
+    NRF_RADIO_NS->RSSISAMPLE = (uint8_t)-rssi;
+    mr_event_data_t event_data = { .data.new_packet = { .payload = frame, .payload_len = (uint8_t)length } };
+    _mari_vars.callback(MARI_NEW_PACKET, event_data);
+}
+
+uint8_t host_net_status(void) {
+    return ipc_shared_data.status;
+}
+
+//=========================== timer ============================================
+
+void mr_timer_hf_init(uint8_t timer) {
+    (void)timer;
+}
+
+uint32_t mr_timer_hf_now(uint8_t timer) {
+    (void)timer;
+    return (uint32_t)host_time_us();
+}
+
+void mr_timer_hf_set_periodic_us(uint8_t timer, uint8_t channel, uint32_t us, timer_hf_cb_t cb) {
+    (void)timer;
+    host_timer_set(channel, us, us, cb);
+}
+
+void mr_timer_hf_set_oneshot_us(uint8_t timer, uint8_t channel, uint32_t us, timer_hf_cb_t cb) {
+    (void)timer;
+    host_timer_set(channel, us, 0, cb);
+}
+
+void mr_timer_hf_cancel(uint8_t timer, uint8_t channel) {
+    (void)timer;
+    host_timer_cancel(channel);
+}
+
+//=========================== rng ==============================================
+
+void db_rng_init(void) {
+    // Seeded with the device ID so the simulations are reproducible
+    _mari_vars.rng_state = ((uint64_t)NRF_FICR_NS->INFO.DEVICEID[1] << 32 | NRF_FICR_NS->INFO.DEVICEID[0]) | 1;
+}
+
+void db_rng_read(uint8_t *value) {
+    // xorshift64
+    uint64_t x = _mari_vars.rng_state ? _mari_vars.rng_state : 1;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    _mari_vars.rng_state = x;
+    *value = (uint8_t)(x >> 32);
+}
@@ -0,0 +1,118 @@
+/**
+ * @file
+ * @ingroup host
+ *
+ * @brief  Software SHA256, replacing the CryptoCell driver of the DotBot firmware
+ *
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ *
+ * @copyright Inria, 2025
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "sha256.h"
+
+//=========================== defines ==========================================
+
+#define SHA256_BLOCK_SIZE   (64U)
+
+#define ROTR(x, n)  (((x) >> (n)) | ((x) << (32 - (n))))
+
+typedef struct {
+    uint32_t state[8];
+    uint8_t  block[SHA256_BLOCK_SIZE];
+    size_t   block_length;
+    uint64_t length;            ///< Number of bytes hashed
+} sha256_vars_t;
+
+//=========================== variables ========================================
+
+static const uint32_t _k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static sha256_vars_t _sha256_vars;
+
+//=========================== private ==========================================
+
+static void _compress(const uint8_t *block) {
+    uint32_t w[64];
+    for (uint8_t i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[4 * i] << 24 | (uint32_t)block[4 * i + 1] << 16 | (uint32_t)block[4 * i + 2] << 8 | block[4 * i + 3];
+    }
+    for (uint8_t i = 16; i < 64; i++) {
+        uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t v[8];
+    memcpy(v, _sha256_vars.state, sizeof(v));
+    for (uint8_t i = 0; i < 64; i++) {
+        uint32_t s1 = ROTR(v[4], 6) ^ ROTR(v[4], 11) ^ ROTR(v[4], 25);
+        uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+        uint32_t t1 = v[7] + s1 + ch + _k[i] + w[i];
+        uint32_t s0 = ROTR(v[0], 2) ^ ROTR(v[0], 13) ^ ROTR(v[0], 22);
+        uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+        memmove(&v[1], &v[0], 7 * sizeof(uint32_t));
+        v[4] += t1;
+        v[0] = t1 + s0 + maj;
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        _sha256_vars.state[i] += v[i];
+    }
+}
+
+//=========================== public ===========================================
+
+void crypto_sha256_init(void) {
+    static const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(_sha256_vars.state, initial, sizeof(initial));
+    _sha256_vars.block_length = 0;
+    _sha256_vars.length = 0;
+}
+
+void crypto_sha256_update(const uint8_t *data, size_t length) {
+    _sha256_vars.length += length;
+    while (length) {
+        size_t count = SHA256_BLOCK_SIZE - _sha256_vars.block_length;
+        if (count > length) {
+            count = length;
+        }
+        memcpy(&_sha256_vars.block[_sha256_vars.block_length], data, count);
+        _sha256_vars.block_length += count;
+        data += count;
+        length -= count;
+        if (_sha256_vars.block_length == SHA256_BLOCK_SIZE) {
+            _compress(_sha256_vars.block);
+            _sha256_vars.block_length = 0;
+        }
+    }
+}
+
+void crypto_sha256(uint8_t *digest) {
+    uint64_t bits = _sha256_vars.length * 8;
+    uint8_t padding[SHA256_BLOCK_SIZE + 8] = { 0x80 };
+    size_t padding_length = ((_sha256_vars.block_length < 56) ? 56 : 120) - _sha256_vars.block_length;
+    for (uint8_t i = 0; i < 8; i++) {
+        padding[padding_length + i] = (uint8_t)(bits >> (56 - 8 * i));
+    }
+    crypto_sha256_update(padding, padding_length + 8);
+    for (uint8_t i = 0; i < 8; i++) {
+        digest[4 * i] = (uint8_t)(_sha256_vars.state[i] >> 24);
+        digest[4 * i + 1] = (uint8_t)(_sha256_vars.state[i] >> 16);
+        digest[4 * i + 2] = (uint8_t)(_sha256_vars.state[i] >> 8);
+        digest[4 * i + 3] = (uint8_t)_sha256_vars.state[i];
+    }
+}
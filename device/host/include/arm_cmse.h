@@ -0,0 +1,32 @@
+#ifndef __ARM_CMSE_H
+#define __ARM_CMSE_H
+
+/**
+ * @ingroup     host
+ * @brief       TrustZone intrinsics, the user image is replaced by a host function
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stddef.h>
+
+#define CMSE_MPU_READWRITE  (1)
+#define CMSE_MPU_READ       (8)
+#define CMSE_NONSECURE      (0x10000)
+
+/// Non secure user image, called instead of the reset handler of the flashed image
+void host_user_image(void);
+
+#define cmse_nsfptr_create(p)   ((void)(p), (__typeof__(p))host_user_image)
+
+static inline void *cmse_check_address_range(void *p, size_t size, int flags) {
+    (void)size;
+    (void)flags;
+    return p;
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef __BOARD_CONFIG_H
+#define __BOARD_CONFIG_H
+
+/**
+ * @ingroup     host
+ * @brief       Board configuration of the DotBot drivers, empty on the host
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#endif
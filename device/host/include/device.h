@@ -0,0 +1,26 @@
+#ifndef __DEVICE_H
+#define __DEVICE_H
+
+/**
+ * @ingroup     host
+ * @brief       Device ID of the DotBot firmware, read from the simulated FICR
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+#include <nrf.h>
+
+static inline uint64_t db_device_id(void) {
+#if defined(NRF_NETWORK)
+    return ((uint64_t)NRF_FICR_NS->INFO.DEVICEID[1]) << 32 | (uint64_t)NRF_FICR_NS->INFO.DEVICEID[0];
+#else
+    return ((uint64_t)NRF_FICR_S->INFO.DEVICEID[1]) << 32 | (uint64_t)NRF_FICR_S->INFO.DEVICEID[0];
+#endif
+}
+
+#endif
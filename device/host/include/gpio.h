@@ -0,0 +1,35 @@
+#ifndef __GPIO_H
+#define __GPIO_H
+
+/**
+ * @ingroup     host
+ * @brief       GPIO driver of the DotBot firmware, the pins are not simulated
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+typedef struct {
+    uint8_t port;
+    uint8_t pin;
+} gpio_t;
+
+typedef enum {
+    DB_GPIO_OUT,
+    DB_GPIO_IN,
+    DB_GPIO_IN_PU,
+    DB_GPIO_IN_PD,
+} gpio_mode_t;
+
+void db_gpio_init(const gpio_t *gpio, gpio_mode_t mode);
+void db_gpio_set(const gpio_t *gpio);
+void db_gpio_clear(const gpio_t *gpio);
+void db_gpio_toggle(const gpio_t *gpio);
+uint8_t db_gpio_read(const gpio_t *gpio);
+
+#endif
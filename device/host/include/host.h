@@ -0,0 +1,231 @@
+#ifndef __HOST_H
+#define __HOST_H
+
+/**
+ * @defgroup    host    Host build
+ * @brief       Runs the bootloader and the network core firmware on a computer
+ *
+ * The firmware sources are compiled for the host, against stubs of the nRF5340
+ * registers, of Mari and of the DotBot drivers. Each simulated device runs both
+ * cores as coroutines, switched when a core waits for an event. The radio is
+ * replaced by frame queues, the simulator drives the devices through the swarm
+ * functions below.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//=========================== defines ==========================================
+
+#define HOST_FRAME_SIZE_MAX     (255U)  ///< Max size of a radio frame
+#define HOST_TIMER_CHANNELS     (4U)    ///< Number of timer channels of each core
+#define HOST_NEVER              (UINT64_MAX)
+
+typedef struct host_swarm host_swarm_t;
+typedef struct host_node host_node_t;
+
+typedef void (*host_timer_cb_t)(void);
+
+/// Position of a simulated robot
+typedef struct {
+    int32_t x;          ///< X coordinate in um, like the lighthouse positions
+    int32_t y;          ///< Y coordinate in um
+    int32_t heading;    ///< Heading in Q16 degrees, 0 is along Y
+    int16_t left_speed; ///< Latest motors speed
+    int16_t right_speed;
+    uint64_t moved_at;  ///< Time of the latest position update in us
+} host_robot_t;
+
+//=========================== swarm ============================================
+
+/**
+ * @brief Reserve the flash address ranges used by the firmware
+ *
+ * @param[in] verbose   Print the output of the firmware
+ *
+ * @return false if an address range is already mapped in the process
+ */
+bool host_init(bool verbose);
+
+/**
+ * @brief Create an empty swarm
+ */
+host_swarm_t *host_swarm_create(void);
+
+/**
+ * @brief Destroy a swarm and its devices
+ */
+void host_swarm_destroy(host_swarm_t *swarm);
+
+/**
+ * @brief Run the devices having a timer or a watchdog expiring
+ *
+ * @param[in] swarm     Swarm to run
+ * @param[in] now       Current time in us
+ *
+ * @return time of the next deadline of the swarm in us, HOST_NEVER if none
+ */
+uint64_t host_swarm_run(host_swarm_t *swarm, uint64_t now);
+
+/**
+ * @brief Pop the oldest frame sent by a device of the swarm
+ *
+ * @param[in]  swarm    Swarm of the devices
+ * @param[out] source   Device ID of the sender
+ * @param[out] buffer   Buffer of HOST_FRAME_SIZE_MAX bytes receiving the frame
+ *
+ * @return length of the frame, 0 if no frame was sent
+ */
+size_t host_swarm_transmit(host_swarm_t *swarm, uint64_t *source, uint8_t *buffer);
+
+//=========================== node =============================================
+
+/**
+ * @brief Power on a new device, with an erased flash and no user image
+ *
+ * @param[in] swarm     Swarm of the device
+ * @param[in] device_id Device ID, read from FICR by the firmware
+ * @param[in] now       Current time in us
+ * @param[in] x         Initial X position of the robot in um
+ * @param[in] y         Initial Y position of the robot in um
+ *
+ * @return NULL if the memory of the device can't be mapped
+ */
+host_node_t *host_node_create(host_swarm_t *swarm, uint64_t device_id, uint64_t now, int32_t x, int32_t y);
+
+/**
+ * @brief Power off and free a device
+ */
+void host_node_destroy(host_node_t *node);
+
+/**
+ * @brief Power cycle a device, only the flash content is kept
+ */
+void host_node_reboot(host_node_t *node, uint64_t now);
+
+/**
+ * @brief Deliver a frame received by the radio of a device
+ *
+ * @param[in] node      Device receiving the frame
+ * @param[in] now       Current time in us
+ * @param[in] buffer    Frame content, starting with the packet type
+ * @param[in] length    Length of the frame
+ * @param[in] rssi      RSSI of the frame in dBm
+ */
+void host_node_receive(host_node_t *node, uint64_t now, const uint8_t *buffer, size_t length, int8_t rssi);
+
+/**
+ * @brief Return the experiment status published by the device
+ */
+uint8_t host_node_status(host_node_t *node);
+
+/**
+ * @brief Record data from the user image of a device
+ *
+ * @param[in] node      Device running a user image
+ * @param[in] now       Current time in us
+ * @param[in] data      Data to record
+ * @param[in] length    Length of the data
+ *
+ * @return false if the device doesn't run a user image or too many records are queued
+ */
+bool host_node_record(host_node_t *node, uint64_t now, const uint8_t *data, uint8_t length);
+
+/**
+ * @brief Read the flash of a device
+ *
+ * @param[in]  node     Device to read
+ * @param[in]  address  Flash address, in the application or the network core flash
+ * @param[out] buffer   Buffer receiving the content
+ * @param[in]  length   Number of bytes to read
+ *
+ * @return false if the range is not in the simulated flash
+ */
+bool host_node_flash_read(host_node_t *node, uint32_t address, uint8_t *buffer, size_t length);
+
+//=========================== stubs ============================================
+
+/**
+ * @brief Return the current time of the running device in us
+ */
+uint64_t host_time_us(void);
+
+/**
+ * @brief Arm a timer channel of the running core, the callback is called when the core waits
+ *
+ * @param[in] channel   Channel, below HOST_TIMER_CHANNELS
+ * @param[in] delay_us  Delay before the first call
+ * @param[in] period_us Period of the next calls, 0 for a one shot timer
+ * @param[in] cb        Callback
+ */
+void host_timer_set(uint8_t channel, uint32_t delay_us, uint32_t period_us, host_timer_cb_t cb);
+
+/**
+ * @brief Disarm a timer channel of the running core
+ */
+void host_timer_cancel(uint8_t channel);
+
+/**
+ * @brief Return the robot driven by the running device
+ */
+host_robot_t *host_robot(void);
+
+/**
+ * @brief Send a frame from the running device
+ */
+void host_radio_push(const uint8_t *buffer, size_t length);
+
+/**
+ * @brief Pop the oldest frame received by the running device
+ *
+ * @param[out] buffer   Buffer of HOST_FRAME_SIZE_MAX bytes receiving the frame
+ * @param[out] rssi     RSSI of the frame
+ *
+ * @return length of the frame, 0 if no frame was received
+ */
+size_t host_radio_pop(uint8_t *buffer, int8_t *rssi);
+
+/**
+ * @brief Pop the oldest data to record by the user image of the running device
+ *
+ * @param[out] buffer   Buffer of UINT8_MAX bytes receiving the data
+ * @param[out] length   Length of the data
+ *
+ * @return false if no data is queued
+ */
+bool host_record_pop(uint8_t *buffer, uint8_t *length);
+
+/**
+ * @brief Mark the user image of the running device as started
+ */
+void host_user_image_started(void);
+
+/**
+ * @brief Print the firmware output, each line is prefixed with the device ID and the core
+ */
+int host_printf(const char *format, ...) __attribute__((format(__printf__, 1, 2)));
+
+/**
+ * @brief Print a string of the firmware output and a new line
+ */
+int host_puts(const char *string);
+
+//=========================== cores ============================================
+
+// Entry points of the firmware, renamed by the shims including the sources of each core
+int host_app_main(void);
+void host_app_ipc_irq(void);        ///< Secure IPC handler of the bootloader
+void host_app_user_ipc_irq(void);   ///< Non secure IPC handler of the user image
+int host_net_main(void);
+void host_net_ipc_irq(void);
+void host_net_radio_irq(void);      ///< Hands the oldest received frame to the Mari callback
+uint8_t host_net_status(void);      ///< Status in the shared RAM of the selected device
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __LH2_H
+#define __LH2_H
+
+/**
+ * @ingroup     host
+ * @brief       Lighthouse v2 driver of the DotBot firmware, the sweeps locate the simulated robot
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "gpio.h"
+
+#define LH2_BASESTATION_COUNT   (4U)
+#define LH2_SWEEP_COUNT         (2U)
+
+typedef enum {
+    DB_LH2_NO_NEW_DATA,
+    DB_LH2_RAW_DATA_AVAILABLE,
+    DB_LH2_PROCESSED_DATA_AVAILABLE,
+} db_lh2_data_ready_state_t;
+
+typedef struct {
+    uint32_t lfsr_location;
+    uint32_t selected_polynomial;
+} db_lh2_location_t;
+
+typedef struct {
+    db_lh2_data_ready_state_t   data_ready[LH2_SWEEP_COUNT][LH2_BASESTATION_COUNT];
+    db_lh2_location_t           locations[LH2_SWEEP_COUNT][LH2_BASESTATION_COUNT];
+} db_lh2_t;
+
+extern const gpio_t db_lh2_d;
+extern const gpio_t db_lh2_e;
+
+void db_lh2_init(db_lh2_t *lh2, const gpio_t *gpio_d, const gpio_t *gpio_e);
+void db_lh2_start(void);
+void db_lh2_stop(void);
+void db_lh2_process_location(db_lh2_t *lh2);
+void db_lh2_handle_isr(void);
+void db_lh2_store_homography(db_lh2_t *lh2, uint8_t basestation_index, int32_t homography_matrix[3][3]);
+void db_lh2_calculate_position(uint32_t count1, uint32_t count2, uint32_t basestation_index, double *coordinates);
+
+#endif
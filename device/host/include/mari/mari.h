@@ -0,0 +1,25 @@
+#ifndef __MARI_H
+#define __MARI_H
+
+/**
+ * @ingroup     host
+ * @brief       Mari network stack, nodes are connected at once and frames go through the host queues
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "models.h"
+
+void mari_init(mr_node_type_t node_type, uint16_t net_id, schedule_t *app_schedule, mr_event_cb_t app_event_callback);
+void mari_event_loop(void);
+void mari_node_tx_payload(uint8_t *payload, uint8_t payload_len);
+bool mari_node_is_connected(void);
+uint64_t mari_node_gateway_id(void);
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef __MODELS_H
+#define __MODELS_H
+
+/**
+ * @ingroup     host
+ * @brief       Types of the Mari network stack used by the network core
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+    MARI_GATEWAY,
+    MARI_NODE,
+} mr_node_type_t;
+
+typedef enum {
+    MARI_NEW_PACKET,
+    MARI_CONNECTED,
+    MARI_DISCONNECTED,
+    MARI_NODE_JOINED,
+    MARI_NODE_LEFT,
+    MARI_KEEPALIVE,
+    MARI_ERROR,
+} mr_event_t;
+
+typedef struct {
+    uint8_t *payload;
+    uint8_t payload_len;
+    void    *header;
+} mr_received_packet_t;
+
+typedef struct {
+    uint64_t gateway_id;
+} mr_gateway_info_t;
+
+typedef struct {
+    union {
+        mr_received_packet_t    new_packet;
+        mr_gateway_info_t       gateway_info;
+    } data;
+    uint8_t tag;    ///< Reason of a disconnection
+} mr_event_data_t;
+
+typedef void (*mr_event_cb_t)(mr_event_t event, mr_event_data_t event_data);
+
+typedef struct {
+    uint8_t id;
+    uint8_t max_nodes;
+    uint8_t backoff_n_min;
+    uint8_t backoff_n_max;
+    uint8_t n_cells;
+} schedule_t;
+
+#endif
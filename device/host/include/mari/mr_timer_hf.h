@@ -0,0 +1,25 @@
+#ifndef __MR_TIMER_HF_H
+#define __MR_TIMER_HF_H
+
+/**
+ * @ingroup     host
+ * @brief       High frequency timer of Mari, backed by the host timers
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+typedef void (*timer_hf_cb_t)(void);
+
+void mr_timer_hf_init(uint8_t timer);
+uint32_t mr_timer_hf_now(uint8_t timer);
+void mr_timer_hf_set_periodic_us(uint8_t timer, uint8_t channel, uint32_t us, timer_hf_cb_t cb);
+void mr_timer_hf_set_oneshot_us(uint8_t timer, uint8_t channel, uint32_t us, timer_hf_cb_t cb);
+void mr_timer_hf_cancel(uint8_t timer, uint8_t channel);
+
+#endif
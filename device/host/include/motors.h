@@ -0,0 +1,20 @@
+#ifndef __MOTORS_H
+#define __MOTORS_H
+
+/**
+ * @ingroup     host
+ * @brief       Motors driver of the DotBot firmware, driving the simulated robot
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+void db_motors_init(void);
+void db_motors_set_speed(int16_t left_speed, int16_t right_speed);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef __MOVE_H
+#define __MOVE_H
+
+/**
+ * @ingroup     host
+ * @brief       Movements of the DotBot firmware, applied at once to the simulated robot
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+void db_move_init(void);
+void db_move_straight(uint16_t distance, int8_t speed);  ///< Distance in mm, backwards with a negative speed
+void db_move_rotate(uint16_t angle, int8_t speed);       ///< Angle in degrees, counter clockwise with a negative speed
+
+#endif
@@ -0,0 +1,340 @@
+#ifndef __NRF_H
+#define __NRF_H
+
+/**
+ * @defgroup    host_nrf    Host peripherals
+ * @ingroup     host
+ * @brief       Registers of the nRF5340 used by the firmware, replaced by memory for the host build
+ *
+ * Each core of each simulated device has its own copy of the registers, the
+ * peripheral pointers resolve to the copy of the core currently running. Writes
+ * don't trigger anything by themselves, the host reads the registers it models
+ * (IPC, DPPI, watchdog 1, TIMER2, NVIC) when the core yields or accesses them.
+ * Only the registers used by the firmware are declared.
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+//=========================== registers ========================================
+
+typedef struct {
+    volatile uint32_t TASKS_SEND[16];
+    volatile uint32_t EVENTS_RECEIVE[16];
+    volatile uint32_t PUBLISH_RECEIVE[16];
+    volatile uint32_t INTENSET;     ///< Interrupts enabled, written once at boot
+    volatile uint32_t SEND_CNF[16];
+    volatile uint32_t RECEIVE_CNF[16];
+} NRF_IPC_Type;
+
+typedef struct {
+    volatile uint32_t RESETREAS;    ///< Set to the reason of the latest reset, the bootloader clears it at each boot
+    struct {
+        volatile uint32_t FORCEOFF; ///< Released at power on, the network core boots first
+    } NETWORK;
+} NRF_RESET_Type;
+
+typedef struct {
+    volatile uint32_t TASKS_START;
+    volatile uint32_t SUBSCRIBE_START;
+    volatile uint32_t CONFIG;
+    volatile uint32_t CRV;
+    volatile uint32_t RREN;
+    volatile uint32_t RR[8];
+} NRF_WDT_Type;
+
+typedef struct {
+    volatile uint32_t TASKS_START;
+    volatile uint32_t TASKS_STOP;
+    volatile uint32_t TASKS_CLEAR;
+    volatile uint32_t TASKS_CAPTURE[6];
+    volatile uint32_t SUBSCRIBE_CAPTURE[6];
+    volatile uint32_t EVENTS_COMPARE[6];
+    volatile uint32_t SHORTS;
+    volatile uint32_t INTENSET;
+    volatile uint32_t INTENCLR;
+    volatile uint32_t BITMODE;      ///< Always 32 bits
+    volatile uint32_t PRESCALER;    ///< Always 1MHz
+    volatile uint32_t CC[6];
+} NRF_TIMER_Type;
+
+typedef struct {
+    struct {
+        volatile uint32_t PERM;
+        volatile uint32_t LOCK;
+    } DPPI[1];
+    struct {
+        volatile uint32_t PERM;
+    } GPIOPORT[2];
+    struct {
+        volatile uint32_t REGION;
+        volatile uint32_t SIZE;
+    } FLASHNSC[2];
+} NRF_SPU_Type;
+
+typedef struct {
+    volatile uint32_t CHENSET;      ///< Ignored, the channels are always enabled
+} NRF_DPPIC_Type;
+
+typedef struct {
+    volatile uint32_t CONFIG;
+    volatile uint32_t CONFIGNS;
+    volatile uint32_t READY;        ///< Always ready, flash operations complete right away
+} NRF_NVMC_Type;
+
+typedef struct {
+    union {
+        // The measurement ends as soon as it starts, with the RSSI of the latest received packet
+        volatile uint32_t TASKS_RSSISTART;
+        volatile uint32_t EVENTS_RSSIEND;
+    };
+    volatile uint32_t RSSISAMPLE;
+} NRF_RADIO_Type;
+
+typedef struct {
+    volatile uint32_t EVENTS_END;   ///< Never set, there are no lighthouse sweeps
+} NRF_SPIM_Type;
+
+typedef struct {
+    struct {
+        volatile uint32_t DEVICEID[2];
+    } INFO;
+} NRF_FICR_Type;
+
+typedef struct {
+    volatile uint32_t MUTEX[16];    ///< Never locked, only one core runs at a time
+} NRF_MUTEX_Type;
+
+typedef struct {
+    volatile uint32_t AIRCR;
+    volatile uint32_t CCR;
+    volatile uint32_t NSACR;
+    volatile uint32_t SCR;
+    volatile uint32_t SHCSR;
+    volatile uint32_t VTOR;
+} SCB_Type;
+
+typedef struct {
+    volatile uint32_t CTRL;
+} SAU_Type;
+
+typedef struct {
+    volatile uint32_t DEMCR;
+} CoreDebug_Type;
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;       ///< Counts the host time spent running the core
+} DWT_Type;
+
+typedef struct {
+    volatile uint32_t ISER[2];
+    volatile uint32_t ISPR[2];
+    volatile uint32_t ITNS[2];
+} NVIC_Type;
+
+/// Registers of one core
+typedef struct {
+    NRF_IPC_Type    ipc;
+    NRF_RESET_Type  reset;
+    NRF_WDT_Type    wdt0;
+    NRF_WDT_Type    wdt1;
+    NRF_TIMER_Type  timer2;
+    NRF_SPU_Type    spu;
+    NRF_DPPIC_Type  dppic;
+    NRF_NVMC_Type   nvmc;
+    NRF_RADIO_Type  radio;
+    NRF_SPIM_Type   spim4;
+    NRF_FICR_Type   ficr;
+    NRF_MUTEX_Type  mutex;
+    SCB_Type        scb;
+    SCB_Type        scb_ns;
+    SAU_Type        sau;
+    CoreDebug_Type  core_debug;
+    DWT_Type        dwt;
+    NVIC_Type       nvic;
+} host_peripherals_t;
+
+extern host_peripherals_t *host_peripherals;    ///< Registers of the core currently running
+extern uint32_t SystemCoreClock;
+
+DWT_Type *host_dwt(void);
+NRF_TIMER_Type *host_timer2(void);
+
+#define NRF_IPC_S       (&host_peripherals->ipc)
+#define NRF_IPC_NS      (&host_peripherals->ipc)
+#define NRF_RESET_S     (&host_peripherals->reset)
+#define NRF_WDT0_S      (&host_peripherals->wdt0)
+#define NRF_WDT1_S      (&host_peripherals->wdt1)
+#define NRF_TIMER2_S    (host_timer2())     ///< The counter and the tasks are updated on each access
+#define NRF_SPU_S       (&host_peripherals->spu)
+#define NRF_DPPIC_S     (&host_peripherals->dppic)
+#define NRF_DPPIC_NS    (&host_peripherals->dppic)
+#define NRF_NVMC_S      (&host_peripherals->nvmc)
+#define NRF_NVMC_NS     (&host_peripherals->nvmc)
+#define NRF_RADIO_NS    (&host_peripherals->radio)
+#define NRF_SPIM4_S     (&host_peripherals->spim4)
+#define NRF_FICR_S      (&host_peripherals->ficr)
+#define NRF_FICR_NS     (&host_peripherals->ficr)
+#define NRF_MUTEX_NS    (&host_peripherals->mutex)
+#define NRF_APPMUTEX_NS (&host_peripherals->mutex)
+#define SCB             (&host_peripherals->scb)
+#define SCB_NS          (&host_peripherals->scb_ns)
+#define SAU             (&host_peripherals->sau)
+#define CoreDebug       (&host_peripherals->core_debug)
+#define NVIC            (&host_peripherals->nvic)
+#define DWT             (host_dwt())        ///< The cycle counter is updated on each access
+
+//=========================== fields ===========================================
+
+#define CoreDebug_DEMCR_TRCENA_Msk              (1UL << 24)
+#define DWT_CTRL_CYCCNTENA_Msk                  (1UL << 0)
+
+#define DPPIC_CHENSET_CH0_Pos                   (0UL)
+#define DPPIC_CHENSET_CH0_Enabled               (1UL)
+
+#define IPC_PUBLISH_RECEIVE_CHIDX_Pos           (0UL)
+#define IPC_PUBLISH_RECEIVE_CHIDX_Msk           (0xFFUL << IPC_PUBLISH_RECEIVE_CHIDX_Pos)
+#define IPC_PUBLISH_RECEIVE_EN_Pos              (31UL)
+#define IPC_PUBLISH_RECEIVE_EN_Enabled          (1UL)
+
+#define NVMC_CONFIG_WEN_Pos                     (0UL)
+#define NVMC_CONFIG_WEN_Ren                     (0UL)
+#define NVMC_CONFIG_WEN_Wen                     (1UL)
+#define NVMC_CONFIG_WEN_Een                     (2UL)
+
+#define RESET_NETWORK_FORCEOFF_FORCEOFF_Pos     (0UL)
+#define RESET_NETWORK_FORCEOFF_FORCEOFF_Release (0UL)
+#define RESET_RESETREAS_DOG1_Pos                (2UL)
+#define RESET_RESETREAS_DOG1_Detected           (1UL)
+#define RESET_RESETREAS_SREQ_Pos                (3UL)
+#define RESET_RESETREAS_SREQ_Detected           (1UL)
+
+#define SCB_AIRCR_VECTKEY_Pos                   (16UL)
+#define SCB_AIRCR_VECTKEY_Msk                   (0xFFFFUL << SCB_AIRCR_VECTKEY_Pos)
+#define SCB_AIRCR_PRIS_Msk                      (1UL << 14)
+#define SCB_AIRCR_BFHFNMINS_Msk                 (1UL << 13)
+#define SCB_AIRCR_SYSRESETREQS_Msk              (1UL << 3)
+#define SCB_CCR_DIV_0_TRP_Msk                   (1UL << 4)
+#define SCB_CCR_UNALIGN_TRP_Msk                 (1UL << 3)
+#define SCB_NSACR_CP10_Pos                      (10UL)
+#define SCB_NSACR_CP11_Pos                      (11UL)
+#define SCB_SCR_SEVONPEND_Msk                   (1UL << 4)
+#define SCB_SHCSR_SECUREFAULTENA_Msk            (1UL << 19)
+
+#define SPU_DPPI_LOCK_LOCK_Pos                  (0UL)
+#define SPU_DPPI_LOCK_LOCK_Locked               (1UL)
+#define SPU_DPPI_PERM_CHANNEL0_Msk              (1UL << 0)
+
+#define TIMER_BITMODE_BITMODE_Pos               (0UL)
+#define TIMER_BITMODE_BITMODE_32Bit             (3UL)
+#define TIMER_INTENSET_COMPARE0_Pos             (16UL)
+#define TIMER_INTENSET_COMPARE0_Enabled         (1UL)
+#define TIMER_INTENCLR_COMPARE0_Pos             (16UL)
+#define TIMER_INTENCLR_COMPARE0_Clear           (1UL)
+#define TIMER_SUBSCRIBE_CAPTURE_CHIDX_Pos       (0UL)
+#define TIMER_SUBSCRIBE_CAPTURE_CHIDX_Msk       (0xFFUL << TIMER_SUBSCRIBE_CAPTURE_CHIDX_Pos)
+#define TIMER_SUBSCRIBE_CAPTURE_EN_Pos          (31UL)
+#define TIMER_SUBSCRIBE_CAPTURE_EN_Enabled      (1UL)
+
+#define WDT_CONFIG_SLEEP_Pos                    (0UL)
+#define WDT_CONFIG_SLEEP_Run                    (1UL)
+#define WDT_CONFIG_HALT_Pos                     (3UL)
+#define WDT_CONFIG_HALT_Pause                   (0UL)
+#define WDT_RREN_RR0_Pos                        (0UL)
+#define WDT_RREN_RR0_Enabled                    (1UL)
+#define WDT_RR_RR_Pos                           (0UL)
+#define WDT_RR_RR_Reload                        (0x6E524635UL)
+#define WDT_SUBSCRIBE_START_CHIDX_Pos           (0UL)
+#define WDT_SUBSCRIBE_START_CHIDX_Msk           (0xFFUL << WDT_SUBSCRIBE_START_CHIDX_Pos)
+#define WDT_SUBSCRIBE_START_EN_Pos              (31UL)
+#define WDT_SUBSCRIBE_START_EN_Enabled          (1UL)
+#define WDT_TASKS_START_TASKS_START_Pos         (0UL)
+#define WDT_TASKS_START_TASKS_START_Trigger     (1UL)
+
+//=========================== interrupts =======================================
+
+typedef enum {
+    I2S0_IRQn,
+    PDM0_IRQn,
+    EGU0_IRQn,
+    EGU1_IRQn,
+    EGU2_IRQn,
+    EGU3_IRQn,
+    EGU4_IRQn,
+    EGU5_IRQn,
+    PWM0_IRQn,
+    PWM1_IRQn,
+    PWM2_IRQn,
+    PWM3_IRQn,
+    QDEC0_IRQn,
+    QDEC1_IRQn,
+    QSPI_IRQn,
+    RTC0_IRQn,
+    RTC1_IRQn,
+    SPIM0_SPIS0_TWIM0_TWIS0_UARTE0_IRQn,
+    SPIM1_SPIS1_TWIM1_TWIS1_UARTE1_IRQn,
+    SPIM2_SPIS2_TWIM2_TWIS2_UARTE2_IRQn,
+    SPIM3_SPIS3_TWIM3_TWIS3_UARTE3_IRQn,
+    SPIM4_IRQn,
+    TIMER0_IRQn,
+    TIMER1_IRQn,
+    TIMER2_IRQn,
+    USBD_IRQn,
+    USBREGULATOR_IRQn,
+    GPIOTE1_IRQn,
+    IPC_IRQn,
+} IRQn_Type;
+
+static inline void NVIC_EnableIRQ(IRQn_Type irq) {
+    NVIC->ISER[irq >> 5] |= 1UL << (irq & 0x1F);
+}
+
+static inline void NVIC_DisableIRQ(IRQn_Type irq) {
+    NVIC->ISER[irq >> 5] &= ~(1UL << (irq & 0x1F));
+}
+
+static inline void NVIC_SetTargetState(IRQn_Type irq) {
+    NVIC->ITNS[irq >> 5] |= 1UL << (irq & 0x1F);
+}
+
+static inline void NVIC_SetPendingIRQ(IRQn_Type irq) {
+    NVIC->ISPR[irq >> 5] |= 1UL << (irq & 0x1F);
+}
+
+static inline void NVIC_ClearPendingIRQ(IRQn_Type irq) {
+    NVIC->ISPR[irq >> 5] &= ~(1UL << (irq & 0x1F));
+}
+
+static inline void NVIC_SetPriority(IRQn_Type irq, uint32_t priority) {
+    (void)irq;
+    (void)priority;
+}
+
+/// Stops the core, the host reboots it with a system reset request as reason
+void NVIC_SystemReset(void) __attribute__((noreturn));
+
+//=========================== instructions =====================================
+
+/// Yields to the host until an event or an interrupt wakes up the core, pending interrupts are taken before returning
+void host_wfe(void);
+
+/// Delivers the IPC tasks of the core, the application core also lets the network core catch up
+void host_barrier(void);
+
+#define __WFE()                 host_wfe()
+#define __DMB()                 host_barrier()
+#define __DSB()                 __sync_synchronize()
+#define __ISB()                 __sync_synchronize()
+#define __disable_irq()         do {} while (0)     ///< Interrupts are only taken while the core waits
+#define __enable_irq()          do {} while (0)
+#define __TZ_set_MSP_NS(msp)    ((void)(msp))
+#define __TZ_set_CONTROL_NS(x)  ((void)(x))
+
+#endif
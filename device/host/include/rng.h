@@ -0,0 +1,20 @@
+#ifndef __RNG_H
+#define __RNG_H
+
+/**
+ * @ingroup     host
+ * @brief       Random number generator of the DotBot firmware, seeded with the device ID
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+void db_rng_init(void);
+void db_rng_read(uint8_t *value);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef __SAADC_H
+#define __SAADC_H
+
+/**
+ * @ingroup     host
+ * @brief       SAADC driver of the DotBot firmware, conversions return a constant
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+typedef enum {
+    DB_SAADC_RESOLUTION_8BIT,
+    DB_SAADC_RESOLUTION_10BIT,
+    DB_SAADC_RESOLUTION_12BIT,
+    DB_SAADC_RESOLUTION_14BIT,
+} db_saadc_resolution_t;
+
+typedef enum {
+    DB_SAADC_INPUT_AIN0 = 1,
+    DB_SAADC_INPUT_AIN1,
+    DB_SAADC_INPUT_AIN2,
+    DB_SAADC_INPUT_AIN3,
+    DB_SAADC_INPUT_AIN4,
+    DB_SAADC_INPUT_AIN5,
+    DB_SAADC_INPUT_AIN6,
+    DB_SAADC_INPUT_AIN7,
+    DB_SAADC_INPUT_VDD,
+    DB_SAADC_INPUT_VDDH = 0x0D,
+} db_saadc_input_t;
+
+void db_saadc_init(db_saadc_resolution_t resolution);
+void db_saadc_read(db_saadc_input_t input, uint16_t *value);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef __SHA256_H
+#define __SHA256_H
+
+/**
+ * @ingroup     host
+ * @brief       SHA256 functions of the DotBot firmware, computed in software
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+void crypto_sha256_init(void);
+void crypto_sha256_update(const uint8_t *data, size_t length);
+void crypto_sha256(uint8_t *digest);
+
+#endif
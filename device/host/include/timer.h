@@ -0,0 +1,23 @@
+#ifndef __TIMER_H
+#define __TIMER_H
+
+/**
+ * @ingroup     host
+ * @brief       Low frequency timer driver of the DotBot firmware, backed by the host timers
+ *
+ * @{
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @copyright Inria, 2025
+ * @}
+ */
+
+#include <stdint.h>
+
+typedef void (*timer_cb_t)(void);
+
+void db_timer_init(uint8_t timer);
+void db_timer_set_periodic_ms(uint8_t timer, uint8_t channel, uint32_t ms, timer_cb_t cb);
+void db_timer_set_oneshot_ms(uint8_t timer, uint8_t channel, uint32_t ms, timer_cb_t cb);
+
+#endif
@@ -19,15 +19,20 @@
 #include "protocol.h"
 
 #define IPC_IRQ_PRIORITY (1)
+#define IPC_OTA_CHUNK_SLOTS (4U)    ///< Number of OTA chunk buffers, power of 2
+#define IPC_RADIO_PDU_SLOTS (4U)    ///< Number of queued radio PDUs in each direction, power of 2
+#define IPC_LOG_SLOTS       (8U)    ///< Number of queued log entries, power of 2
+#define IPC_CALIBRATION_SLOTS (4U)  ///< Number of queued LH2 homographies, one per basestation
+#define IPC_TIME_SLEW_RATIO (16)        ///< The network time is corrected by up to 1us every 16us
 
 #define IPC_LOG_SIZE     (128)
 
 typedef enum {
     IPC_REQ_NONE,        ///< Sorry, but nothing
     IPC_MARI_INIT_REQ,
-    IPC_MARI_NODE_TX_REQ,
     IPC_RNG_INIT_REQ,                ///< Request for rng init
     IPC_RNG_READ_REQ,                ///< Request for rng read
+    IPC_TIME_REQ,                    ///< Request for a network time anchor, answered from the interrupt handler
 } ipc_req_t;
 
 typedef enum {
@@ -39,29 +44,74 @@ typedef enum {
     IPC_CHAN_LOG_EVENT          = 5,    ///< Channel used for logging events
     IPC_CHAN_OTA_START          = 6,    ///< Channel used for starting an OTA process
     IPC_CHAN_OTA_CHUNK          = 7,    ///< Channel used for writing a non secure image chunk
+    IPC_CHAN_OTA_CHUNK_BITMAP   = 8,    ///< Channel used for requesting the bitmap of written chunks
+    IPC_CHAN_OTA_PAGE_HASHES    = 9,    ///< Channel used for requesting the hashes of the installed image pages
+    IPC_CHAN_RADIO_TX           = 10,   ///< Channel used for radio TX events
+    IPC_CHAN_REQ_ACK            = 11,   ///< Channel used for acknowledging requests
+    IPC_CHAN_CALIBRATION        = 12,   ///< Channel used for storing a LH2 basestation homography
+    IPC_CHAN_RECORD_READ        = 13,   ///< Channel used for reading back the recorded data
+    IPC_CHAN_TIME_ANCHOR        = 14,   ///< Channel used for capturing the time of a network time anchor
 } ipc_channels_t;
 
 typedef struct {
     uint8_t value;  ///< Byte containing the random value read
 } ipc_rng_data_t;
 
+typedef struct __attribute__((packed)) {
+    uint32_t offset;                            ///< Offset of the first requested chunk
+    uint8_t  count;                             ///< Number of requested chunks
+} ipc_record_read_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t                 cpu_mhz;            ///< Frequency of the application core
+    swrmt_profile_entry_t   entries[SWRMT_PROFILE_APP_ENTRIES]; ///< Statistics of the sections, by profile_id_t
+} ipc_profile_t;
+
 typedef struct __attribute__((packed)) {
     uint8_t length;             ///< Length of the pdu in bytes
     uint8_t buffer[UINT8_MAX];  ///< Buffer containing the pdu data
 } ipc_radio_pdu_t;
 
+typedef struct __attribute__((packed)) {
+    uint8_t         head;                       ///< Incremented by the producer once a pdu is queued
+    uint8_t         tail;                       ///< Incremented by the consumer once a pdu is released
+    ipc_radio_pdu_t pdus[IPC_RADIO_PDU_SLOTS];  ///< Queued pdus
+} ipc_radio_ring_t;
+
 typedef struct __attribute__((packed)) {
     uint8_t length;
     uint8_t data[INT8_MAX];
 } ipc_log_data_t;
 
+typedef struct __attribute__((packed)) {
+    uint8_t         head;                       ///< Incremented by the application core once an entry is queued
+    uint8_t         tail;                       ///< Incremented by the network core once an entry is released
+    ipc_log_data_t  entries[IPC_LOG_SLOTS];     ///< Queued log entries
+} ipc_log_ring_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t index;                             ///< Index of the chunk
+    uint32_t size;                              ///< Size of the chunk
+    uint8_t  data[SWRMT_OTA_CHUNK_SIZE_MAX];    ///< Bytes array of the chunk
+} ipc_ota_chunk_slot_t;
+
 typedef struct __attribute__((packed)) {
     uint32_t image_size;
     uint32_t chunk_count;
-    uint32_t chunk_index;
-    uint32_t chunk_size;
+    uint32_t nominal_chunk_size;    ///< Size of all chunks but the last one, negotiated at OTA start
     int32_t  last_chunk_acked;
-    uint8_t chunk[INT8_MAX + 1];
+    uint32_t bitmap_base;       ///< Index of the first chunk of the requested bitmap
+    uint8_t  mode;              ///< OTA transfer mode (see swrmt_ota_mode_t)
+    uint8_t  compression;       ///< Compression of the chunks content (see swrmt_ota_compression_t)
+    uint8_t  image_hash[SWRMT_OTA_SHA256_LENGTH];   ///< Expected SHA256 hash of the whole image
+    bool     delta;             ///< Only the pages set in pages_bitmap are rewritten
+    uint8_t  pages_bitmap[SWRMT_OTA_PAGES_BITMAP_SIZE];    ///< Bitmap of the pages differing from the installed image
+    uint32_t session_id;        ///< OTA started with another ID are not resumed
+    uint32_t page_hashes_start; ///< Index of the first requested page hash
+    uint8_t  page_hashes_count; ///< Number of requested page hashes
+    uint8_t  chunk_head;        ///< Incremented by the network core when a chunk slot is filled
+    uint8_t  chunk_tail;        ///< Incremented by the application core when a chunk slot is released
+    ipc_ota_chunk_slot_t chunks[IPC_OTA_CHUNK_SLOTS];   ///< Ring of chunks waiting to be written
 } ipc_ota_data_t;
 
 /// DotBot protocol LH2 computed location
@@ -70,20 +120,44 @@ typedef struct __attribute__((packed)) {
     uint32_t y;  ///< Y coordinate, multiplied by 1e6
 } position_2d_t;
 
+/// LH2 homography of a basestation
+typedef struct __attribute__((packed)) {
+    uint8_t basestation_index;        ///< which LH basestation is this homography for?
+    int32_t homography_matrix[3][3];  ///< homography matrix, each element multiplied by 1e6
+} localization_homography_t;
+
+/// Network time at the last anchor event, the application core interpolates it from its timebase
+typedef struct __attribute__((packed)) {
+    uint32_t seq;           ///< Incremented by the network core before and after writing the anchor, odd meanwhile
+    uint64_t network_us;    ///< Network time when the anchor event was sent
+    int64_t  correction;    ///< Error to the controller time still to be slewed at the anchor
+} ipc_time_anchor_t;
+
 typedef struct __attribute__((packed)) {
     bool                    net_ready;          ///< Network core is ready
     bool                    net_ack;            ///< Network core acked the latest request
+    bool                    net_connected;      ///< Network core is connected to a gateway
     ipc_req_t               req;                ///< IPC network request
     uint8_t                 status;             ///< Experiment status
     swrmt_device_type_t     device_type;        ///< Device type
     uint8_t                 battery_level;      ///< Battery level in %
-    ipc_log_data_t          log;                ///< Log data
+    ipc_log_ring_t          log_ring;           ///< Log entries waiting to be sent
     ipc_rng_data_t          rng;                ///< Rng shared data
     ipc_ota_data_t          ota;                ///< OTA data
     position_2d_t           target_position;    ///< LH2 target location
     position_2d_t           current_position;   ///< Current 2D position
-    ipc_radio_pdu_t         tx_pdu;             ///< TX pdu
-    ipc_radio_pdu_t         rx_pdu;             ///< RX pdu
+    ipc_radio_ring_t        tx_ring;            ///< TX pdus, produced by the application core
+    ipc_radio_ring_t        rx_ring;            ///< RX pdus, produced by the network core
+    uint32_t                tx_sent;            ///< Number of queued TX pdus handed to Mari by the network core
+    position_2d_t           reset_waypoints[SWRMT_RESET_WAYPOINTS_MAX]; ///< Positions to reach in order while resetting, the last one is the target
+    uint8_t                 reset_waypoints_count;  ///< Number of reset waypoints, at least 1 while resetting
+    localization_homography_t calibrations[IPC_CALIBRATION_SLOTS];  ///< LH2 homographies to store, indexed by basestation
+    uint8_t                 calibration_pending;    ///< Bitmap of the homographies waiting to be stored
+    uint16_t                duty_cycle;         ///< Active time of the application core in 1/100 %
+    uint32_t                boot_time_us;       ///< Time from reset to the start of the user image in us
+    ipc_time_anchor_t       time_anchor;        ///< Network time anchor, published periodically
+    ipc_record_read_t       record_read;        ///< Window of recorded data to send
+    ipc_profile_t           profile;            ///< Cycles spent in the profiled sections of the application core
 } ipc_shared_data_t;
 
 /**
@@ -28,36 +28,112 @@
 // Important: select a Network ID according to the specific deployment you are making,
 // see the registry at https://crystalfree.atlassian.net/wiki/spaces/Mari/pages/3324903426/Registry+of+Mari+Network+IDs
 #define SWARMIT_MARI_NET_ID                 (0x12AA)
+#define SWARMIT_MARI_SCHEDULE               (SWRMT_SCHEDULE_TINY)
+
+#define NETCORE_CONFIG_ADDRESS              (0x0103F800UL)  ///< Last flash page, excluded from the image in MemoryMap.xml
+#define NETCORE_CONFIG_MAGIC                (0x4746434EUL)  ///< Marks a written configuration page
+#define NETCORE_TIME_STEP_US                (1000000)       ///< Network time errors above which the time jumps forward
+#define NETCORE_RSSI_WAIT_LOOPS             (128)           ///< Polls of the end of an RSSI measurement, it takes ~0.25us
 
 //=========================== variables =========================================
 
+typedef struct {
+    uint32_t                magic;
+    swrmt_network_config_t  network;
+    uint8_t                 padding;    ///< Keeps the size a multiple of 4 bytes
+} netcore_config_t;
+
 typedef struct {
     bool        req_received;
+    uint32_t    req_received_at;            ///< Reception time of the request, to schedule from it
     bool        data_received;
-    bool        send_status;
+    bool        status_check;
     uint8_t     req_buffer[255];
+    uint8_t     req_length;
     uint8_t     notification_buffer[255];
     ipc_req_t   ipc_req;
     bool        ipc_log_received;
+    bool        ipc_tx_received;
+    uint8_t     log_batch[SWRMT_LOG_BATCH_SIZE_MAX];
+    size_t      log_batch_length;
+    bool        log_batch_armed;
+    bool        log_batch_flush;
     uint8_t     gpio_event_idx;
     uint8_t     expected_hash[SWRMT_OTA_SHA256_LENGTH];
     uint8_t     computed_hash[SWRMT_OTA_SHA256_LENGTH];
     uint64_t    device_id;
     int32_t     last_chunk_acked;
+    swrmt_status_policy_t status_policy;
+    uint32_t    groups;
+    swrmt_network_config_t network;
+    bool        mari_restart;
+    swrmt_link_stats_t link_stats;
+    int32_t     rssi_avg_x8;                ///< Smoothed RSSI, scaled by 8
+    bool        rssi_measured;              ///< The RSSI was measured at least once
+    uint32_t    link_stats_sent_at;
+    bool        tx_deferred;
+    uint32_t    status_sent_at;
+    uint8_t     status_sent;
+    uint8_t     device_type_sent;
+    position_2d_t position_sent;
+    bool        start_armed;                ///< A scheduled start is pending
+    uint8_t     start_id;                   ///< ID of the pending scheduled start
+    uint64_t    time_anchor_network;        ///< Network time at time_anchor_local
+    uint32_t    time_anchor_local;          ///< Local timer value the network time is counted from
+    int64_t     time_correction;            ///< Network time error still to be slewed
+    bool        time_synced;                ///< The network time was synchronized at least once
+    swrmt_profile_entry_t profile[SWRMT_PROFILE_NET_ENTRIES];  ///< Cycles spent in the request handlers, by request type
 } swrmt_app_data_t;
 
-static swrmt_app_data_t _app_vars = { 0 };
+static swrmt_app_data_t _app_vars = {
+    .status_policy = {
+        .heartbeat_ms       = SWRMT_STATUS_HEARTBEAT_MS,
+        .position_threshold = 0,
+        .on_change          = true,
+    },
+};
 extern schedule_t schedule_minuscule, schedule_tiny, schedule_small, schedule_huge, schedule_only_beacons, schedule_only_beacons_optimized_scan;
 
+static schedule_t *const _schedules[SWRMT_SCHEDULE_COUNT] = {
+    [SWRMT_SCHEDULE_MINUSCULE]                      = &schedule_minuscule,
+    [SWRMT_SCHEDULE_TINY]                           = &schedule_tiny,
+    [SWRMT_SCHEDULE_SMALL]                          = &schedule_small,
+    [SWRMT_SCHEDULE_HUGE]                           = &schedule_huge,
+    [SWRMT_SCHEDULE_ONLY_BEACONS]                   = &schedule_only_beacons,
+    [SWRMT_SCHEDULE_ONLY_BEACONS_OPTIMIZED_SCAN]    = &schedule_only_beacons_optimized_scan,
+};
+
 volatile __attribute__((section(".shared_data"))) ipc_shared_data_t ipc_shared_data;
 
 //=========================== functions =========================================
 
 static void _handle_packet(uint8_t *packet, uint8_t length) {
-    memcpy(_app_vars.req_buffer, packet, length);
-    uint8_t *ptr = _app_vars.req_buffer;
-    uint8_t packet_type = (uint8_t)*ptr++;
-    if ((packet_type >= SWRMT_REQUEST_STATUS) && (packet_type <= SWRMT_REQUEST_OTA_CHUNK)) {
+    if (length == 0) {
+        return;
+    }
+
+    // Unwrap multicast packets addressed to one of the groups of the device
+    if (packet[0] == SWRMT_REQUEST_MULTICAST) {
+        if (length < 3) {
+            // Ensure the multicast header is received before reading it
+            return;
+        }
+        const swrmt_multicast_pkt_t *multicast = (const swrmt_multicast_pkt_t *)&packet[1];
+        if ((multicast->length > length - 3) || (multicast->group >= SWRMT_GROUPS_MAX)) {
+            return;
+        }
+        if (_app_vars.groups & (1UL << multicast->group)) {
+            _handle_packet((uint8_t *)multicast->packet, multicast->length);
+        }
+        return;
+    }
+
+    // Classify in place, only requests are copied since they're processed from the main loop
+    uint8_t packet_type = packet[0];
+    if ((packet_type >= SWRMT_REQUEST_STATUS) && (packet_type <= SWRMT_REQUEST_PROFILE)) {
+        memcpy(_app_vars.req_buffer, packet, length);
+        _app_vars.req_length = length;
+        _app_vars.req_received_at = mr_timer_hf_now(NETCORE_MAIN_TIMER);
         _app_vars.req_received = true;
         return;
     }
@@ -67,26 +143,69 @@ static void _handle_packet(uint8_t *packet, uint8_t length) {
         return;
     }
 
-    ipc_shared_data.rx_pdu.length = length;
-    memcpy((uint8_t *)ipc_shared_data.rx_pdu.buffer, packet, length);
+    // Drop the packet if the application doesn't consume them fast enough
+    uint8_t head = ipc_shared_data.rx_ring.head;
+    if ((uint8_t)(head - ipc_shared_data.rx_ring.tail) >= IPC_RADIO_PDU_SLOTS) {
+        _app_vars.link_stats.rx_dropped++;
+        return;
+    }
+
+    volatile ipc_radio_pdu_t *pdu = &ipc_shared_data.rx_ring.pdus[head % IPC_RADIO_PDU_SLOTS];
+    pdu->length = length;
+    memcpy((uint8_t *)pdu->buffer, packet, length);
+
+    // Publish the slot once its content is complete
+    __DMB();
+    ipc_shared_data.rx_ring.head = head + 1;
     _app_vars.data_received = true;
 }
 
+static bool _measure_rssi(int8_t *rssi) {
+    // The sample register holds the previous measurement, measure again while the receiver is on.
+    // The measurement doesn't end if the radio already left the receive state.
+    NRF_RADIO_NS->EVENTS_RSSIEND = 0;
+    NRF_RADIO_NS->TASKS_RSSISTART = 1;
+    for (uint32_t loop = 0; !NRF_RADIO_NS->EVENTS_RSSIEND; loop++) {
+        if (loop >= NETCORE_RSSI_WAIT_LOOPS) {
+            return false;
+        }
+    }
+    NRF_RADIO_NS->EVENTS_RSSIEND = 0;
+    *rssi = -(int8_t)NRF_RADIO_NS->RSSISAMPLE;
+    return true;
+}
+
 static void mari_event_callback(mr_event_t event, mr_event_data_t event_data) {
     switch (event) {
         case MARI_NEW_PACKET:
         {
+            int8_t rssi;
+            if (_measure_rssi(&rssi)) {
+                if (!_app_vars.rssi_measured) {
+                    _app_vars.rssi_measured = true;
+                    _app_vars.rssi_avg_x8 = rssi * 8;
+                }
+                _app_vars.rssi_avg_x8 += rssi - _app_vars.rssi_avg_x8 / 8;
+                _app_vars.link_stats.rssi = rssi;
+                _app_vars.link_stats.rssi_avg = (int8_t)(_app_vars.rssi_avg_x8 / 8);
+            }
+            _app_vars.link_stats.rx_packets++;
             _handle_packet(event_data.data.new_packet.payload, event_data.data.new_packet.payload_len);
             break;
         }
         case MARI_CONNECTED: {
             uint64_t gateway_id = event_data.data.gateway_info.gateway_id;
             printf("Connected to gateway %016llX\n", gateway_id);
+            ipc_shared_data.net_connected = true;
+            _app_vars.link_stats.connections++;
             break;
         }
         case MARI_DISCONNECTED: {
             uint64_t gateway_id = event_data.data.gateway_info.gateway_id;
             printf("Disconnected from gateway %016llX, reason: %u\n", gateway_id, event_data.tag);
+            ipc_shared_data.net_connected = false;
+            _app_vars.link_stats.disconnections++;
+            _app_vars.link_stats.disconnect_reason = event_data.tag;
             break;
         }
         case MARI_ERROR:
@@ -101,25 +220,279 @@ uint64_t _deviceid(void) {
     return ((uint64_t)NRF_FICR_NS->INFO.DEVICEID[1]) << 32 | (uint64_t)NRF_FICR_NS->INFO.DEVICEID[0];
 }
 
-static void _send_status(void) {
-    _app_vars.send_status = true;
+static void _check_status(void) {
+    _app_vars.status_check = true;
+}
+
+static int32_t _time_slew(uint32_t elapsed) {
+    // The correction is spread over time, the network time never goes backward
+    int32_t slew_max = (int32_t)(elapsed / IPC_TIME_SLEW_RATIO);
+    if (_app_vars.time_correction > slew_max) {
+        return slew_max;
+    }
+    if (_app_vars.time_correction < -slew_max) {
+        return -slew_max;
+    }
+    return (int32_t)_app_vars.time_correction;
+}
+
+static uint64_t _network_time(uint32_t local) {
+    uint32_t elapsed = local - _app_vars.time_anchor_local;
+    return _app_vars.time_anchor_network + elapsed + _time_slew(elapsed);
+}
+
+static void _move_time_anchor(uint32_t local) {
+    // The anchor is moved forward regularly, the local timer wraps after ~71 minutes
+    uint32_t elapsed = local - _app_vars.time_anchor_local;
+    int32_t slew = _time_slew(elapsed);
+    // The anchor is also published from the IPC interrupt
+    __disable_irq();
+    _app_vars.time_anchor_network += elapsed + slew;
+    _app_vars.time_anchor_local = local;
+    _app_vars.time_correction -= slew;
+    __enable_irq();
+}
+
+static void _sync_time(uint32_t received_at, uint64_t time_us) {
+    uint32_t now = mr_timer_hf_now(NETCORE_MAIN_TIMER);
+    _move_time_anchor(now);
+    // Compare at the same instant, the anchor may have moved since the reception
+    int64_t error = (int64_t)(time_us + (uint32_t)(now - received_at) - _app_vars.time_anchor_network);
+    __disable_irq();
+    if (!_app_vars.time_synced || error > NETCORE_TIME_STEP_US) {
+        // The first sync replaces the time counted from the start, later ones only jump forward
+        _app_vars.time_anchor_network += error;
+        _app_vars.time_correction = 0;
+        _app_vars.time_synced = true;
+    } else {
+        _app_vars.time_correction = error;
+    }
+    __enable_irq();
+}
+
+static void _publish_time_anchor(void) {
+    // The application core captures its timebase on the anchor event and interpolates the network
+    // time from it. The event is sent while the sequence number is odd, so the application core
+    // never pairs a captured time with the anchor of another event.
+    volatile ipc_time_anchor_t *anchor = &ipc_shared_data.time_anchor;
+    __disable_irq();
+    anchor->seq++;
+    __DMB();
+    uint32_t now = mr_timer_hf_now(NETCORE_MAIN_TIMER);
+    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_TIME_ANCHOR] = 1;
+    uint32_t elapsed = now - _app_vars.time_anchor_local;
+    int32_t slew = _time_slew(elapsed);
+    anchor->network_us = _app_vars.time_anchor_network + elapsed + slew;
+    anchor->correction = _app_vars.time_correction - slew;
+    __DMB();
+    anchor->seq++;
+    __enable_irq();
+}
+
+static uint32_t _distance(uint32_t a, uint32_t b) {
+    return (a > b) ? a - b : b - a;
+}
+
+static bool _status_notification_required(uint32_t now) {
+    const swrmt_status_policy_t *policy = &_app_vars.status_policy;
+    if (policy->heartbeat_ms && (now - _app_vars.status_sent_at) / 1000 >= policy->heartbeat_ms) {
+        return true;
+    }
+
+    if (policy->on_change && (ipc_shared_data.status != _app_vars.status_sent || ipc_shared_data.device_type != _app_vars.device_type_sent)) {
+        return true;
+    }
+
+    if (policy->position_threshold) {
+        position_2d_t position = ipc_shared_data.current_position;
+        return _distance(position.x, _app_vars.position_sent.x) > policy->position_threshold ||
+               _distance(position.y, _app_vars.position_sent.y) > policy->position_threshold;
+    }
+
+    return false;
+}
+
+static void _radio_tx(uint8_t *payload, uint8_t length) {
+    _app_vars.link_stats.tx_packets++;
+    mari_node_tx_payload(payload, length);
+}
+
+static void _send_link_stats(uint32_t now) {
+    _app_vars.link_stats_sent_at = now;
+
+    size_t length = 0;
+    _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_LINK_STATS;
+    memcpy(&_app_vars.notification_buffer[length], &_app_vars.link_stats, sizeof(swrmt_link_stats_t));
+    length += sizeof(swrmt_link_stats_t);
+    _radio_tx(_app_vars.notification_buffer, length);
+}
+
+static void _send_status(uint32_t now) {
+    _app_vars.status_sent_at = now;
+    _app_vars.status_sent = ipc_shared_data.status;
+    _app_vars.device_type_sent = ipc_shared_data.device_type;
+    _app_vars.position_sent = ipc_shared_data.current_position;
+
+    size_t length = 0;
+    _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_STATUS;
+    _app_vars.notification_buffer[length++] = _app_vars.device_type_sent;
+    _app_vars.notification_buffer[length++] = _app_vars.status_sent;
+    _app_vars.notification_buffer[length++] = ipc_shared_data.battery_level;
+    memcpy(&_app_vars.notification_buffer[length], &_app_vars.position_sent, sizeof(position_2d_t));
+    length += sizeof(position_2d_t);
+    uint16_t duty_cycle = ipc_shared_data.duty_cycle;
+    memcpy(&_app_vars.notification_buffer[length], &duty_cycle, sizeof(uint16_t));
+    length += sizeof(uint16_t);
+    uint32_t boot_time_us = ipc_shared_data.boot_time_us;
+    memcpy(&_app_vars.notification_buffer[length], &boot_time_us, sizeof(uint32_t));
+    length += sizeof(uint32_t);
+    _radio_tx(_app_vars.notification_buffer, length);
+}
+
+static void _profile_add(uint8_t type, uint32_t cycles) {
+    swrmt_profile_entry_t *entry = &_app_vars.profile[type - SWRMT_REQUEST_STATUS];
+    if (entry->count == 0 || cycles < entry->min) {
+        entry->min = cycles;
+    }
+    if (cycles > entry->max) {
+        entry->max = cycles;
+    }
+    entry->total += cycles;
+    entry->count++;
+}
+
+static void _send_profile(uint8_t core, uint8_t cpu_mhz, const volatile swrmt_profile_entry_t *entries, uint8_t count) {
+    // The entries are split in batches of consecutive entries fitting in a notification
+    for (uint8_t index = 0; index < count; index += SWRMT_PROFILE_BATCH_MAX) {
+        uint8_t batch = count - index;
+        if (batch > SWRMT_PROFILE_BATCH_MAX) {
+            batch = SWRMT_PROFILE_BATCH_MAX;
+        }
+        swrmt_profile_header_t header = {
+            .core    = core,
+            .cpu_mhz = cpu_mhz,
+            .index   = index,
+            .count   = batch,
+            .size    = batch * sizeof(swrmt_profile_entry_t),
+        };
+
+        size_t length = 0;
+        _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_PROFILE;
+        memcpy(&_app_vars.notification_buffer[length], &header, sizeof(swrmt_profile_header_t));
+        length += sizeof(swrmt_profile_header_t);
+        memcpy(&_app_vars.notification_buffer[length], (const void *)&entries[index], header.size);
+        length += header.size;
+        _radio_tx(_app_vars.notification_buffer, length);
+    }
+}
+
+static void _config_load(void) {
+    const netcore_config_t *config = (const netcore_config_t *)NETCORE_CONFIG_ADDRESS;
+    _app_vars.network.net_id = SWARMIT_MARI_NET_ID;
+    _app_vars.network.schedule = SWARMIT_MARI_SCHEDULE;
+    if ((config->magic == NETCORE_CONFIG_MAGIC) && (config->network.schedule < SWRMT_SCHEDULE_COUNT)) {
+        _app_vars.network = config->network;
+    }
+}
+
+static void _config_store(void) {
+    const netcore_config_t config = {
+        .magic      = NETCORE_CONFIG_MAGIC,
+        .network    = _app_vars.network,
+        .padding    = 0xFF,
+    };
+    const uint32_t *src = (const uint32_t *)&config;
+    volatile uint32_t *dst = (volatile uint32_t *)NETCORE_CONFIG_ADDRESS;
+
+    NRF_NVMC_NS->CONFIG = NVMC_CONFIG_WEN_Een << NVMC_CONFIG_WEN_Pos;
+    *dst = 0xFFFFFFFF;
+    while (!NRF_NVMC_NS->READY) {}
+
+    NRF_NVMC_NS->CONFIG = NVMC_CONFIG_WEN_Wen << NVMC_CONFIG_WEN_Pos;
+    for (size_t i = 0; i < sizeof(netcore_config_t) / sizeof(uint32_t); i++) {
+        dst[i] = src[i];
+        while (!NRF_NVMC_NS->READY) {}
+    }
+    NRF_NVMC_NS->CONFIG = NVMC_CONFIG_WEN_Ren << NVMC_CONFIG_WEN_Pos;
+}
+
+static void _mari_start(void) {
+    mari_init(MARI_NODE, _app_vars.network.net_id, _schedules[_app_vars.network.schedule], &mari_event_callback);
+}
+
+static void _start_application(void) {
+    // Started from the timer interrupt, the main loop latency would add jitter between devices
+    if (!_app_vars.start_armed) {
+        // Cancelled by a stop request
+        return;
+    }
+    _app_vars.start_armed = false;
+    if (ipc_shared_data.status == SWRMT_APPLICATION_READY) {
+        NRF_IPC_NS->TASKS_SEND[IPC_CHAN_APPLICATION_START] = 1;
+    }
+}
+
+static void _log_batch_deadline(void) {
+    _app_vars.log_batch_flush = true;
+}
+
+static void _log_batch_send(void) {
+    if (_app_vars.log_batch_length == 0) {
+        return;
+    }
+
+    size_t length = 0;
+    _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_LOG_BATCH;
+    _app_vars.notification_buffer[length++] = _app_vars.log_batch_length;
+    memcpy(_app_vars.notification_buffer + length, _app_vars.log_batch, _app_vars.log_batch_length);
+    length += _app_vars.log_batch_length;
+    _radio_tx(_app_vars.notification_buffer, length);
+    _app_vars.log_batch_length = 0;
+}
+
+static void _log_batch_append(uint32_t timestamp, const uint8_t *data, uint8_t length) {
+    // Send the pending entries first if the new one doesn't fit, the format flag is kept in the length
+    size_t entry_length = sizeof(uint32_t) + sizeof(uint8_t) + (length & ~SWRMT_LOG_FORMAT_FLAG);
+    if (_app_vars.log_batch_length + entry_length > SWRMT_LOG_BATCH_SIZE_MAX) {
+        _log_batch_send();
+    }
+
+    uint8_t *ptr = _app_vars.log_batch + _app_vars.log_batch_length;
+    memcpy(ptr, &timestamp, sizeof(uint32_t));
+    ptr += sizeof(uint32_t);
+    *ptr++ = length;
+    memcpy(ptr, data, length & ~SWRMT_LOG_FORMAT_FLAG);
+    _app_vars.log_batch_length += entry_length;
 }
 
 //=========================== main ==============================================
 
 int main(void) {
 
+    // Active cycles are counted to profile the request handlers
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
     _app_vars.device_id = _deviceid();
+    _config_load();
 
-    NRF_IPC_NS->INTENSET                             = (1 << IPC_CHAN_REQ) | (1 << IPC_CHAN_LOG_EVENT);
+    NRF_IPC_NS->INTENSET                             = (1 << IPC_CHAN_REQ) | (1 << IPC_CHAN_LOG_EVENT) | (1 << IPC_CHAN_RADIO_TX);
     NRF_IPC_NS->SEND_CNF[IPC_CHAN_RADIO_RX]          = 1 << IPC_CHAN_RADIO_RX;
     NRF_IPC_NS->SEND_CNF[IPC_CHAN_APPLICATION_START] = 1 << IPC_CHAN_APPLICATION_START;
     NRF_IPC_NS->SEND_CNF[IPC_CHAN_APPLICATION_STOP]  = 1 << IPC_CHAN_APPLICATION_STOP;
-    //NRF_IPC_NS->SEND_CNF[IPC_CHAN_APPLICATION_RESET] = 1 << IPC_CHAN_APPLICATION_RESET;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_APPLICATION_RESET] = 1 << IPC_CHAN_APPLICATION_RESET;
     NRF_IPC_NS->SEND_CNF[IPC_CHAN_OTA_START]         = 1 << IPC_CHAN_OTA_START;
     NRF_IPC_NS->SEND_CNF[IPC_CHAN_OTA_CHUNK]         = 1 << IPC_CHAN_OTA_CHUNK;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_OTA_CHUNK_BITMAP]  = 1 << IPC_CHAN_OTA_CHUNK_BITMAP;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_OTA_PAGE_HASHES]   = 1 << IPC_CHAN_OTA_PAGE_HASHES;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_REQ_ACK]           = 1 << IPC_CHAN_REQ_ACK;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_CALIBRATION]       = 1 << IPC_CHAN_CALIBRATION;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_RECORD_READ]       = 1 << IPC_CHAN_RECORD_READ;
+    NRF_IPC_NS->SEND_CNF[IPC_CHAN_TIME_ANCHOR]       = 1 << IPC_CHAN_TIME_ANCHOR;
     NRF_IPC_NS->RECEIVE_CNF[IPC_CHAN_REQ]            = 1 << IPC_CHAN_REQ;
     NRF_IPC_NS->RECEIVE_CNF[IPC_CHAN_LOG_EVENT]      = 1 << IPC_CHAN_LOG_EVENT;
+    NRF_IPC_NS->RECEIVE_CNF[IPC_CHAN_RADIO_TX]       = 1 << IPC_CHAN_RADIO_TX;
 
     NVIC_EnableIRQ(IPC_IRQn);
     NVIC_ClearPendingIRQ(IPC_IRQn);
@@ -127,7 +500,7 @@ int main(void) {
 
     // Configure timer used for timestamping events
     mr_timer_hf_init(NETCORE_MAIN_TIMER);
-    mr_timer_hf_set_periodic_us(NETCORE_MAIN_TIMER, 0, 1000000UL, _send_status);
+    mr_timer_hf_set_periodic_us(NETCORE_MAIN_TIMER, 0, SWRMT_STATUS_CHECK_PERIOD_US, _check_status);
 
     // Network core must remain on
     ipc_shared_data.net_ready = true;
@@ -135,22 +508,31 @@ int main(void) {
     while (1) {
         __WFE();
 
-        if (_app_vars.send_status) {
-            _app_vars.send_status = false;
-            size_t length = 0;
-            _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_STATUS;
-            _app_vars.notification_buffer[length++] = ipc_shared_data.device_type;
-            _app_vars.notification_buffer[length++] = ipc_shared_data.status;
-            _app_vars.notification_buffer[length++] = ipc_shared_data.battery_level;
-            memcpy(&_app_vars.notification_buffer[length], (void *)&ipc_shared_data.current_position, sizeof(position_2d_t));
-            length += sizeof(position_2d_t);
-            mari_node_tx_payload(_app_vars.notification_buffer, length);
+        if (_app_vars.status_check) {
+            _app_vars.status_check = false;
+            uint32_t now = mr_timer_hf_now(NETCORE_MAIN_TIMER);
+            _move_time_anchor(now);
+            _publish_time_anchor();
+            if (_status_notification_required(now)) {
+                _send_status(now);
+                if ((now - _app_vars.link_stats_sent_at) / 1000 >= SWRMT_LINK_STATS_PERIOD_MS) {
+                    _send_link_stats(now);
+                }
+            }
         }
 
         if (_app_vars.req_received) {
             _app_vars.req_received = false;
             swrmt_request_t *req = (swrmt_request_t *)_app_vars.req_buffer;
+            uint32_t handler_start = DWT->CYCCNT;
             switch (req->type) {
+                case SWRMT_REQUEST_STATUS:
+                {
+                    // Reply immediately, the heartbeat restarts from now
+                    uint32_t now = mr_timer_hf_now(NETCORE_MAIN_TIMER);
+                    _send_status(now);
+                    _send_link_stats(now);
+                } break;
                 case SWRMT_REQUEST_START:
                     if (ipc_shared_data.status != SWRMT_APPLICATION_READY) {
                         break;
@@ -158,7 +540,37 @@ int main(void) {
                     puts("Start request received");
                     NRF_IPC_NS->TASKS_SEND[IPC_CHAN_APPLICATION_START] = 1;
                     break;
+                case SWRMT_REQUEST_START_AT:
+                {
+                    const swrmt_start_at_pkt_t *pkt = (const swrmt_start_at_pkt_t *)req->data;
+                    // Retries are less accurate than the first request received, they are ignored once armed
+                    if ((ipc_shared_data.status != SWRMT_APPLICATION_READY) || (_app_vars.start_armed && pkt->id == _app_vars.start_id)) {
+                        break;
+                    }
+                    uint32_t elapsed = mr_timer_hf_now(NETCORE_MAIN_TIMER) - _app_vars.req_received_at;
+                    _app_vars.start_armed = true;
+                    _app_vars.start_id = pkt->id;
+                    if (pkt->delay_us <= elapsed) {
+                        _start_application();
+                        break;
+                    }
+                    mr_timer_hf_set_oneshot_us(NETCORE_MAIN_TIMER, 2, pkt->delay_us - elapsed, _start_application);
+                } break;
+                case SWRMT_REQUEST_TIME_SYNC:
+                {
+                    // The devices receive the same broadcast at the same time, the latency to the controller
+                    // only offsets all of them by the same amount
+                    const swrmt_time_sync_pkt_t *pkt = (const swrmt_time_sync_pkt_t *)req->data;
+                    _sync_time(_app_vars.req_received_at, pkt->time_us);
+                    _publish_time_anchor();
+                } break;
                 case SWRMT_REQUEST_STOP:
+                    if ((ipc_shared_data.status == SWRMT_APPLICATION_READY) && _app_vars.start_armed) {
+                        // The timer may still fire, the start is dropped once disarmed
+                        puts("Scheduled start cancelled");
+                        _app_vars.start_armed = false;
+                        break;
+                    }
                     if ((ipc_shared_data.status != SWRMT_APPLICATION_RUNNING) && (ipc_shared_data.status != SWRMT_APPLICATION_RESETTING) && (ipc_shared_data.status != SWRMT_APPLICATION_PROGRAMMING)) {
                         break;
                     }
@@ -171,10 +583,29 @@ int main(void) {
                         break;
                     }
                     memcpy((uint8_t *)&ipc_shared_data.target_position, req->data, sizeof(position_2d_t));
+                    memcpy((uint8_t *)&ipc_shared_data.reset_waypoints[0], req->data, sizeof(position_2d_t));
+                    ipc_shared_data.reset_waypoints_count = 1;
                     puts("Reset request received");
                     ipc_shared_data.status = SWRMT_APPLICATION_RESETTING;
-                    //NRF_IPC_NS->TASKS_SEND[IPC_CHAN_APPLICATION_RESET] = 1;
+                    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_APPLICATION_RESET] = 1;
                     break;
+                case SWRMT_REQUEST_RESET_WAYPOINTS:
+                {
+                    const swrmt_reset_waypoints_pkt_t *pkt = (const swrmt_reset_waypoints_pkt_t *)req->data;
+                    if (ipc_shared_data.status != SWRMT_APPLICATION_READY || pkt->count == 0 || pkt->count > SWRMT_RESET_WAYPOINTS_MAX) {
+                        break;
+                    }
+                    // Drop truncated requests, the coordinates must all be in the packet
+                    if ((pkt->length != pkt->count * sizeof(position_2d_t)) || (_app_vars.req_length < 3 + pkt->length)) {
+                        break;
+                    }
+                    memcpy((uint8_t *)ipc_shared_data.reset_waypoints, pkt->coordinates, pkt->count * sizeof(position_2d_t));
+                    ipc_shared_data.reset_waypoints_count = pkt->count;
+                    memcpy((uint8_t *)&ipc_shared_data.target_position, pkt->coordinates[0], sizeof(position_2d_t));
+                    puts("Reset waypoints request received");
+                    ipc_shared_data.status = SWRMT_APPLICATION_RESETTING;
+                    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_APPLICATION_RESET] = 1;
+                } break;
                 case SWRMT_REQUEST_OTA_START:
                 {
                     if (ipc_shared_data.status != SWRMT_APPLICATION_READY && ipc_shared_data.status != SWRMT_APPLICATION_PROGRAMMING) {
@@ -187,55 +618,206 @@ int main(void) {
                     mutex_lock();
                     ipc_shared_data.ota.image_size = pkt->image_size;
                     ipc_shared_data.ota.chunk_count = pkt->chunk_count;
+                    ipc_shared_data.ota.mode = pkt->mode;
+                    ipc_shared_data.ota.nominal_chunk_size = pkt->chunk_size;
+                    ipc_shared_data.ota.compression = pkt->compression;
+                    memcpy((uint8_t *)ipc_shared_data.ota.image_hash, pkt->hash, SWRMT_OTA_SHA256_LENGTH);
+                    ipc_shared_data.ota.delta = pkt->delta;
+                    memcpy((uint8_t *)ipc_shared_data.ota.pages_bitmap, pkt->pages_bitmap, SWRMT_OTA_PAGES_BITMAP_SIZE);
+                    ipc_shared_data.ota.session_id = pkt->session_id;
                     mutex_unlock();
-                    printf("OTA Start request received (size: %u, chunks: %u)\n", ipc_shared_data.ota.image_size, ipc_shared_data.ota.chunk_count);
+                    printf("OTA Start request received (size: %u, chunks: %u, chunk size: %u, mode: %u, compression: %u)\n", ipc_shared_data.ota.image_size, ipc_shared_data.ota.chunk_count, ipc_shared_data.ota.nominal_chunk_size, ipc_shared_data.ota.mode, ipc_shared_data.ota.compression);
                     NRF_IPC_NS->TASKS_SEND[IPC_CHAN_OTA_START] = 1;
                 } break;
                 case SWRMT_REQUEST_OTA_CHUNK:
+                case SWRMT_REQUEST_OTA_RAW_CHUNK:
                 {
                     if (ipc_shared_data.status != SWRMT_APPLICATION_PROGRAMMING) {
                         break;
                     }
 
-                    const swrmt_ota_chunk_pkt_t *pkt = (const swrmt_ota_chunk_pkt_t *)req->data;
-                    ipc_shared_data.ota.chunk_index = pkt->index;
+                    // Drop the chunk if all slots are still used by the application core,
+                    // it will be sent again by the controller
+                    uint8_t head = ipc_shared_data.ota.chunk_head;
+                    if ((uint8_t)(head - ipc_shared_data.ota.chunk_tail) >= IPC_OTA_CHUNK_SLOTS) {
+                        break;
+                    }
+                    volatile ipc_ota_chunk_slot_t *slot = &ipc_shared_data.ota.chunks[head % IPC_OTA_CHUNK_SLOTS];
+
+                    // Raw chunks have no hash, the whole image hash is verified by the application core
+                    uint32_t index;
+                    uint8_t chunk_size;
+                    const uint8_t *chunk;
+                    const uint8_t *sha = NULL;
+                    if (req->type == SWRMT_REQUEST_OTA_CHUNK) {
+                        const swrmt_ota_chunk_pkt_t *pkt = (const swrmt_ota_chunk_pkt_t *)req->data;
+                        index = pkt->index;
+                        chunk_size = pkt->chunk_size;
+                        chunk = pkt->chunk;
+                        sha = pkt->sha;
+                    } else {
+                        const swrmt_ota_raw_chunk_pkt_t *pkt = (const swrmt_ota_raw_chunk_pkt_t *)req->data;
+                        index = pkt->index;
+                        chunk_size = pkt->chunk_size;
+                        chunk = pkt->chunk;
+                    }
 
                     // Check chunk index is valid
-                    if (ipc_shared_data.ota.chunk_index >= ipc_shared_data.ota.chunk_count) {
-                        printf("Invalid chunk index %u\n", ipc_shared_data.ota.chunk_index);
+                    if (index >= ipc_shared_data.ota.chunk_count) {
+                        printf("Invalid chunk index %u\n", index);
+                        break;
+                    }
+
+                    // Check chunk fits in the shared buffer and matches the size negotiated at OTA start
+                    if (chunk_size > SWRMT_OTA_CHUNK_SIZE_MAX || chunk_size > ipc_shared_data.ota.nominal_chunk_size) {
+                        printf("Invalid chunk size %u\n", chunk_size);
                         break;
                     }
 
-                    // Only check for matching sha if chunk was not already acked
-                    if (ipc_shared_data.ota.last_chunk_acked != (int32_t)ipc_shared_data.ota.chunk_index) {
-                        printf("Verify SHA for chunk %u: ", ipc_shared_data.ota.chunk_index);
-                        ipc_shared_data.ota.chunk_size = pkt->chunk_size;
-                        mutex_lock();
-                        memcpy((uint8_t *)ipc_shared_data.ota.chunk, pkt->chunk, pkt->chunk_size);
-                        mutex_unlock();
+                    // The slot is owned by the network core until the head is moved, no need to lock
+                    slot->index = index;
+                    slot->size = chunk_size;
+                    memcpy((uint8_t *)slot->data, chunk, chunk_size);
+
+                    // Only check for matching sha if chunk was not already acked, the application
+                    // core can write the previous chunks meanwhile
+                    if (sha != NULL && ipc_shared_data.ota.last_chunk_acked != (int32_t)index) {
+                        printf("Verify SHA for chunk %u: ", index);
 
                         // Copy expected hash
-                        memcpy(_app_vars.expected_hash, pkt->sha, SWRMT_OTA_SHA256_LENGTH);
+                        memcpy(_app_vars.expected_hash, sha, SWRMT_OTA_CHUNK_SHA_LENGTH);
 
                         // Compute and compare the chunk hash with the received one
                         crypto_sha256_init();
-                        mutex_lock();
-                        crypto_sha256_update((const uint8_t *)ipc_shared_data.ota.chunk, ipc_shared_data.ota.chunk_size);
-                        mutex_unlock();
+                        crypto_sha256_update((const uint8_t *)slot->data, chunk_size);
                         crypto_sha256(_app_vars.computed_hash);
 
-                        if (memcmp(_app_vars.computed_hash, _app_vars.expected_hash, 8) != 0) {
+                        if (memcmp(_app_vars.computed_hash, _app_vars.expected_hash, SWRMT_OTA_CHUNK_SHA_LENGTH) != 0) {
                             puts("Failed");
                             break;
                         }
                         puts("OK");
                     }
-                    printf("Process OTA chunk request (index: %u, size: %u)\n", ipc_shared_data.ota.chunk_index, ipc_shared_data.ota.chunk_size);
+                    printf("Process OTA chunk request (index: %u, size: %u)\n", index, chunk_size);
+
+                    // Publish the slot once its content is complete
+                    __DMB();
+                    ipc_shared_data.ota.chunk_head = head + 1;
                     NRF_IPC_NS->TASKS_SEND[IPC_CHAN_OTA_CHUNK] = 1;
                 } break;
+                case SWRMT_REQUEST_OTA_CHUNK_BITMAP:
+                {
+                    // The bitmap can still be requested once all chunks are written and the device is back to ready
+                    if (ipc_shared_data.status != SWRMT_APPLICATION_READY && ipc_shared_data.status != SWRMT_APPLICATION_PROGRAMMING) {
+                        break;
+                    }
+                    const swrmt_ota_chunk_bitmap_pkt_t *pkt = (const swrmt_ota_chunk_bitmap_pkt_t *)req->data;
+                    ipc_shared_data.ota.bitmap_base = pkt->base_index;
+                    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_OTA_CHUNK_BITMAP] = 1;
+                } break;
+                case SWRMT_REQUEST_OTA_PAGE_HASHES:
+                {
+                    // Pages of the installed image are only hashed before starting a new OTA
+                    if (ipc_shared_data.status != SWRMT_APPLICATION_READY) {
+                        break;
+                    }
+                    const swrmt_ota_page_hashes_pkt_t *pkt = (const swrmt_ota_page_hashes_pkt_t *)req->data;
+                    mutex_lock();
+                    ipc_shared_data.ota.page_hashes_start = pkt->page_start;
+                    ipc_shared_data.ota.page_hashes_count = pkt->page_count;
+                    mutex_unlock();
+                    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_OTA_PAGE_HASHES] = 1;
+                } break;
+                case SWRMT_REQUEST_RECORD_READ:
+                {
+                    // The records are read from flash by the bootloader, once the user image is stopped
+                    if (ipc_shared_data.status != SWRMT_APPLICATION_READY) {
+                        break;
+                    }
+                    const swrmt_record_read_pkt_t *pkt = (const swrmt_record_read_pkt_t *)req->data;
+                    mutex_lock();
+                    ipc_shared_data.record_read.offset = pkt->offset;
+                    ipc_shared_data.record_read.count = pkt->count;
+                    mutex_unlock();
+                    NRF_IPC_NS->TASKS_SEND[IPC_CHAN_RECORD_READ] = 1;
+                } break;
+                case SWRMT_REQUEST_PROFILE:
+                {
+                    // The statistics of the application core are kept in shared RAM, it may run the user image
+                    const swrmt_profile_pkt_t *pkt = (const swrmt_profile_pkt_t *)req->data;
+                    _send_profile(SWRMT_PROFILE_CORE_APP, ipc_shared_data.profile.cpu_mhz, ipc_shared_data.profile.entries, SWRMT_PROFILE_APP_ENTRIES);
+                    _send_profile(SWRMT_PROFILE_CORE_NET, SystemCoreClock / 1000000, _app_vars.profile, SWRMT_PROFILE_NET_ENTRIES);
+                    if (pkt->clear) {
+                        // A measure of the application core ending meanwhile may survive the clear
+                        memset((void *)ipc_shared_data.profile.entries, 0, sizeof(ipc_shared_data.profile.entries));
+                        memset(_app_vars.profile, 0, sizeof(_app_vars.profile));
+                    }
+                } break;
+                case SWRMT_REQUEST_CONFIG:
+                {
+                    const swrmt_config_pkt_t *pkt = (const swrmt_config_pkt_t *)req->data;
+                    switch (pkt->key) {
+                        case SWRMT_CONFIG_STATUS_POLICY:
+                            if (pkt->length != sizeof(swrmt_status_policy_t)) {
+                                break;
+                            }
+                            memcpy(&_app_vars.status_policy, pkt->value, sizeof(swrmt_status_policy_t));
+                            printf("Status policy updated (heartbeat: %ums, position threshold: %u, on change: %u)\n",
+                                   _app_vars.status_policy.heartbeat_ms, _app_vars.status_policy.position_threshold, _app_vars.status_policy.on_change);
+                            break;
+                        case SWRMT_CONFIG_GROUPS:
+                            if (pkt->length != sizeof(uint32_t)) {
+                                break;
+                            }
+                            memcpy(&_app_vars.groups, pkt->value, sizeof(uint32_t));
+                            printf("Groups updated: %08X\n", _app_vars.groups);
+                            break;
+                        case SWRMT_CONFIG_NETWORK:
+                        {
+                            swrmt_network_config_t network;
+                            if (pkt->length != sizeof(swrmt_network_config_t)) {
+                                break;
+                            }
+                            memcpy(&network, pkt->value, sizeof(swrmt_network_config_t));
+                            // Config requests are repeated, only store and apply changes once
+                            if ((network.schedule >= SWRMT_SCHEDULE_COUNT) || !memcmp(&network, &_app_vars.network, sizeof(swrmt_network_config_t))) {
+                                break;
+                            }
+                            _app_vars.network = network;
+                            _config_store();
+                            printf("Network updated (net ID: %04X, schedule: %u)\n", network.net_id, network.schedule);
+                            // Join again right away if idle, otherwise when the application core restarts
+                            _app_vars.mari_restart = (ipc_shared_data.status == SWRMT_APPLICATION_READY);
+                        } break;
+                        case SWRMT_CONFIG_CALIBRATION:
+                            // The bootloader stores the homography, it doesn't run with the application
+                            if ((pkt->length != sizeof(localization_homography_t)) || (ipc_shared_data.status != SWRMT_APPLICATION_READY)) {
+                                break;
+                            }
+                            if (pkt->value[0] >= IPC_CALIBRATION_SLOTS) {
+                                break;
+                            }
+                            // Homographies sent back to back are queued until the bootloader stores them
+                            mutex_lock();
+                            memcpy((uint8_t *)&ipc_shared_data.calibrations[pkt->value[0]], pkt->value, sizeof(localization_homography_t));
+                            ipc_shared_data.calibration_pending |= 1 << pkt->value[0];
+                            mutex_unlock();
+                            NRF_IPC_NS->TASKS_SEND[IPC_CHAN_CALIBRATION] = 1;
+                            break;
+                        default:
+                            break;
+                    }
+                } break;
                 default:
                     break;
             }
+            _profile_add(req->type, DWT->CYCCNT - handler_start);
+        }
+
+        if (_app_vars.mari_restart) {
+            _app_vars.mari_restart = false;
+            ipc_shared_data.net_connected = false;
+            _mari_start();
         }
 
         if (_app_vars.ipc_req != IPC_REQ_NONE) {
@@ -243,11 +825,7 @@ int main(void) {
             switch (_app_vars.ipc_req) {
                 // Mira node functions
                 case IPC_MARI_INIT_REQ:
-                    mari_init(MARI_NODE, SWARMIT_MARI_NET_ID, &schedule_tiny, &mari_event_callback);
-                    break;
-                case IPC_MARI_NODE_TX_REQ:
-                    while (!mari_node_is_connected()) {}
-                    mari_node_tx_payload((uint8_t *)ipc_shared_data.tx_pdu.buffer, ipc_shared_data.tx_pdu.length);
+                    _mari_start();
                     break;
                 case IPC_RNG_INIT_REQ:
                     db_rng_init();
@@ -259,9 +837,33 @@ int main(void) {
                     break;
             }
             ipc_shared_data.net_ack = true;
+            NRF_IPC_NS->TASKS_SEND[IPC_CHAN_REQ_ACK] = 1;
             _app_vars.ipc_req      = IPC_REQ_NONE;
         }
 
+        // Packets queued by the application core are kept until the node is connected
+        if (_app_vars.ipc_tx_received && !mari_node_is_connected() && !_app_vars.tx_deferred) {
+            _app_vars.tx_deferred = true;
+            _app_vars.link_stats.tx_deferred++;
+        }
+        if (_app_vars.ipc_tx_received && mari_node_is_connected()) {
+            _app_vars.ipc_tx_received = false;
+            _app_vars.tx_deferred = false;
+            uint8_t pending = ipc_shared_data.tx_ring.head - ipc_shared_data.tx_ring.tail;
+            if (pending > _app_vars.link_stats.tx_ring_max) {
+                _app_vars.link_stats.tx_ring_max = pending;
+            }
+            while (ipc_shared_data.tx_ring.tail != ipc_shared_data.tx_ring.head) {
+                volatile ipc_radio_pdu_t *pdu = &ipc_shared_data.tx_ring.pdus[ipc_shared_data.tx_ring.tail % IPC_RADIO_PDU_SLOTS];
+                _radio_tx((uint8_t *)pdu->buffer, pdu->length);
+                ipc_shared_data.tx_sent++;
+
+                // Release the slot once the packet was handed to Mari
+                __DMB();
+                ipc_shared_data.tx_ring.tail++;
+            }
+        }
+
         if (_app_vars.data_received) {
             _app_vars.data_received = false;
             NRF_IPC_NS->TASKS_SEND[IPC_CHAN_RADIO_RX] = 1;
@@ -269,15 +871,27 @@ int main(void) {
 
         if (_app_vars.ipc_log_received) {
             _app_vars.ipc_log_received = false;
-            // Notify log data
-            size_t length = 0;
-            _app_vars.notification_buffer[length++] = SWRMT_NOTIFICATION_LOG_EVENT;
-            uint32_t timestamp = mr_timer_hf_now(NETCORE_MAIN_TIMER);
-            memcpy(_app_vars.notification_buffer + length, &timestamp, sizeof(uint32_t));
-            length += sizeof(uint32_t);
-            memcpy(_app_vars.notification_buffer + length, (void *)&ipc_shared_data.log, ipc_shared_data.log.length + 1);
-            length += ipc_shared_data.log.length + 1;
-            mari_node_tx_payload(_app_vars.notification_buffer, length);
+            // Timestamp the queued log entries and pack them in a batch, full batches are sent right away
+            while (ipc_shared_data.log_ring.tail != ipc_shared_data.log_ring.head) {
+                volatile ipc_log_data_t *entry = &ipc_shared_data.log_ring.entries[ipc_shared_data.log_ring.tail % IPC_LOG_SLOTS];
+                _log_batch_append((uint32_t)_network_time(mr_timer_hf_now(NETCORE_MAIN_TIMER)), (const uint8_t *)entry->data, entry->length);
+
+                // Release the entry once it is copied in the batch
+                __DMB();
+                ipc_shared_data.log_ring.tail++;
+            }
+
+            // Remaining entries are sent at the latest when the deadline expires
+            if (_app_vars.log_batch_length && !_app_vars.log_batch_armed) {
+                _app_vars.log_batch_armed = true;
+                mr_timer_hf_set_oneshot_us(NETCORE_MAIN_TIMER, 1, SWRMT_LOG_BATCH_DEADLINE_US, _log_batch_deadline);
+            }
+        }
+
+        if (_app_vars.log_batch_flush) {
+            _app_vars.log_batch_flush = false;
+            _app_vars.log_batch_armed = false;
+            _log_batch_send();
         }
     };
 }
@@ -285,11 +899,23 @@ int main(void) {
 void IPC_IRQHandler(void) {
     if (NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_REQ]) {
         NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_REQ] = 0;
-        _app_vars.ipc_req                        = ipc_shared_data.req;
+        if (ipc_shared_data.req == IPC_TIME_REQ) {
+            // Answered right away, the application core waits for the anchor when it boots
+            _publish_time_anchor();
+            ipc_shared_data.net_ack = true;
+            NRF_IPC_NS->TASKS_SEND[IPC_CHAN_REQ_ACK] = 1;
+        } else {
+            _app_vars.ipc_req = ipc_shared_data.req;
+        }
     }
 
     if (NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_LOG_EVENT]) {
         NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_LOG_EVENT] = 0;
         _app_vars.ipc_log_received                     = true;
     }
+
+    if (NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_RADIO_TX]) {
+        NRF_IPC_NS->EVENTS_RECEIVE[IPC_CHAN_RADIO_TX] = 0;
+        _app_vars.ipc_tx_received                     = true;
+    }
 }
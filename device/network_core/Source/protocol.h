@@ -9,8 +9,28 @@
 #define BROADCAST_ADDRESS 0xffffffffffffffffUL  ///< Broadcast address
 #define GATEWAY_ADDRESS   0x0000000000000000UL  ///< Gateway address
 
-#define SWRMT_OTA_CHUNK_SIZE        (64U)
+#define SWRMT_OTA_CHUNK_SIZE        (64U)    ///< Default size of OTA chunks
+#define SWRMT_OTA_CHUNK_SIZE_MAX    (192U)   ///< Largest OTA chunk size supported by the device, multiple of 4
 #define SWRMT_OTA_SHA256_LENGTH     (32U)
+#define SWRMT_OTA_CHUNK_SHA_LENGTH  (8U)    ///< Length of the truncated SHA256 hash of a chunk
+#define SWRMT_OTA_CHUNK_BITMAP_SIZE (32U)   ///< Size in bytes of a chunk bitmap, covers 256 chunks
+#define SWRMT_OTA_PAGES_BITMAP_SIZE (32U)   ///< Size in bytes of a flash pages bitmap, covers 256 pages (1MiB)
+#define SWRMT_OTA_PAGE_HASH_LENGTH  (8U)    ///< Length of the truncated SHA256 hash of a flash page
+#define SWRMT_OTA_PAGE_HASHES_MAX   (16U)   ///< Max number of page hashes in a notification
+#define SWRMT_LOG_FORMAT_FLAG       (0x80U) ///< Set in the length of log entries holding a format ID and its arguments
+#define SWRMT_LOG_BATCH_SIZE_MAX    (220U)  ///< Max size of the log entries packed in a notification
+#define SWRMT_LOG_BATCH_DEADLINE_US (50000U)    ///< Max delay before a batch of log entries is sent
+#define SWRMT_STATUS_CHECK_PERIOD_US    (100000U)   ///< Period at which the status policy is evaluated
+#define SWRMT_STATUS_HEARTBEAT_MS       (1000U)     ///< Default max delay between 2 status notifications
+#define SWRMT_GROUPS_MAX                (32U)       ///< Number of multicast groups
+#define SWRMT_LINK_STATS_PERIOD_MS      (10000U)    ///< Min delay between 2 link statistics sent with the heartbeat
+#define SWRMT_RESET_WAYPOINTS_MAX       (8U)        ///< Max number of waypoints of a reset request
+#define SWRMT_GPIO_EVENT_BATCH_MAX      (31U)       ///< Max number of GPIO events in a notification
+#define SWRMT_RECORD_CHUNK_SIZE         (192U)      ///< Size of the recorded data chunks read back in a notification
+#define SWRMT_RECORD_WINDOW_MAX         (32U)       ///< Max number of chunks sent in answer to a read request
+#define SWRMT_PROFILE_APP_ENTRIES       (32U)       ///< Number of profiled sections of the application core
+#define SWRMT_PROFILE_NET_ENTRIES       (16U)       ///< Number of profiled request handlers, one per request type
+#define SWRMT_PROFILE_BATCH_MAX         (8U)        ///< Max number of profile entries in a notification
 
 typedef enum {
     SWRMT_DEVICE_TYPE_UNKNOWN = 0,
@@ -34,6 +54,16 @@ typedef enum {
     SWRMT_REQUEST_RESET = 0x83,
     SWRMT_REQUEST_OTA_START = 0x84,
     SWRMT_REQUEST_OTA_CHUNK = 0x85,
+    SWRMT_REQUEST_OTA_CHUNK_BITMAP = 0x86,
+    SWRMT_REQUEST_OTA_PAGE_HASHES = 0x87,
+    SWRMT_REQUEST_OTA_RAW_CHUNK = 0x88,
+    SWRMT_REQUEST_CONFIG = 0x89,
+    SWRMT_REQUEST_MULTICAST = 0x8A,
+    SWRMT_REQUEST_RESET_WAYPOINTS = 0x8B,
+    SWRMT_REQUEST_START_AT = 0x8C,
+    SWRMT_REQUEST_TIME_SYNC = 0x8D,
+    SWRMT_REQUEST_RECORD_READ = 0x8E,
+    SWRMT_REQUEST_PROFILE = 0x8F,
 } swrmt_request_type_t;
 
 typedef enum {
@@ -42,8 +72,42 @@ typedef enum {
     SWRMT_NOTIFICATION_OTA_CHUNK_ACK = 0x94,
     SWRMT_NOTIFICATION_GPIO_EVENT = 0x95,
     SWRMT_NOTIFICATION_LOG_EVENT = 0x96,
+    SWRMT_NOTIFICATION_OTA_CHUNK_BITMAP = 0x97,
+    SWRMT_NOTIFICATION_OTA_PAGE_HASHES = 0x98,
+    SWRMT_NOTIFICATION_OTA_VERIFY = 0x99,
+    SWRMT_NOTIFICATION_LOG_BATCH = 0x9A,
+    SWRMT_NOTIFICATION_LINK_STATS = 0x9B,
+    SWRMT_NOTIFICATION_RECORD_DATA = 0x9C,
+    SWRMT_NOTIFICATION_PROFILE = 0x9D,
 } swrmt_notification_type_t;
 
+typedef enum {
+    SWRMT_OTA_MODE_STOP_AND_WAIT = 0,   ///< Each chunk is acknowledged individually
+    SWRMT_OTA_MODE_WINDOWED = 1,        ///< Chunks are streamed and acknowledged with bitmaps on demand
+} swrmt_ota_mode_t;
+
+typedef enum {
+    SWRMT_OTA_COMPRESSION_NONE = 0,     ///< Chunks contain the raw image
+    SWRMT_OTA_COMPRESSION_LZSS = 1,     ///< Chunks contain the LZSS compressed image, decompressed in order
+} swrmt_ota_compression_t;
+
+typedef enum {
+    SWRMT_CONFIG_STATUS_POLICY = 0,     ///< When status notifications are sent (see swrmt_status_policy_t)
+    SWRMT_CONFIG_GROUPS = 1,            ///< Bitmap (uint32_t) of the multicast groups of the device
+    SWRMT_CONFIG_NETWORK = 2,           ///< Mari network ID and schedule, stored in flash (see swrmt_network_config_t)
+    SWRMT_CONFIG_CALIBRATION = 3,       ///< LH2 homography of a basestation, stored in flash by the application core (see localization_homography_t)
+} swrmt_config_key_t;
+
+typedef enum {
+    SWRMT_SCHEDULE_MINUSCULE = 0,
+    SWRMT_SCHEDULE_TINY,
+    SWRMT_SCHEDULE_SMALL,
+    SWRMT_SCHEDULE_HUGE,
+    SWRMT_SCHEDULE_ONLY_BEACONS,
+    SWRMT_SCHEDULE_ONLY_BEACONS_OPTIMIZED_SCAN,
+    SWRMT_SCHEDULE_COUNT,
+} swrmt_schedule_t;
+
 /// Protocol packet type
 typedef enum {
     PACKET_BEACON = 1,
@@ -77,26 +141,134 @@ typedef struct __attribute__((packed)) {
 typedef struct __attribute__((packed)) {
     uint32_t image_size;                        ///< User image size in bytes
     uint32_t chunk_count;
+    uint8_t  mode;                              ///< OTA transfer mode (see swrmt_ota_mode_t)
+    uint8_t  chunk_size;                        ///< Size of all chunks but the last one
+    uint8_t  compression;                       ///< Compression of the chunks content (see swrmt_ota_compression_t)
+    uint8_t  hash[SWRMT_OTA_SHA256_LENGTH];     ///< SHA256 hash of the whole (uncompressed) image
+    uint8_t  delta;                             ///< Only the pages set in pages_bitmap are rewritten
+    uint8_t  pages_bitmap[SWRMT_OTA_PAGES_BITMAP_SIZE]; ///< Bitmap of the pages differing from the installed image
+    uint32_t session_id;                        ///< OTA started with another ID are not resumed, 0 by default
 } swrmt_ota_start_pkt_t;
 
 typedef struct __attribute__((packed)) {
     uint32_t index;                             ///< Index of the chunk
     uint8_t  chunk_size;                        ///< Size of the chunk
-    uint8_t  sha[8];
-    uint8_t  chunk[SWRMT_OTA_CHUNK_SIZE];       ///< Bytes array of the firmware chunk
+    uint8_t  sha[SWRMT_OTA_CHUNK_SHA_LENGTH];   ///< Truncated SHA256 hash of the chunk
+    uint8_t  chunk[SWRMT_OTA_CHUNK_SIZE_MAX];   ///< Bytes array of the firmware chunk
 } swrmt_ota_chunk_pkt_t;
 
+typedef struct __attribute__((packed)) {
+    uint32_t index;                             ///< Index of the chunk
+    uint8_t  chunk_size;                        ///< Size of the chunk
+    uint8_t  chunk[SWRMT_OTA_CHUNK_SIZE_MAX];   ///< Bytes array of the firmware chunk
+} swrmt_ota_raw_chunk_pkt_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t base_index;                        ///< Index of the first chunk covered by the bitmap
+} swrmt_ota_chunk_bitmap_pkt_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t page_start;                        ///< Index of the first page to hash, relative to the image start
+    uint8_t  page_count;                        ///< Number of pages to hash
+} swrmt_ota_page_hashes_pkt_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  key;                               ///< Configured setting (see swrmt_config_key_t)
+    uint8_t  length;                            ///< Length of the value
+    uint8_t  value[UINT8_MAX - 2];              ///< Value of the setting
+} swrmt_config_pkt_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t heartbeat_ms;                      ///< Max delay between 2 notifications, 0 to only send on events
+    uint32_t position_threshold;                ///< Position change triggering a notification (1e-6 units), 0 to disable
+    uint8_t  on_change;                         ///< Send a notification as soon as the device type or status changes
+} swrmt_status_policy_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t rx_packets;                        ///< Packets received from the gateway
+    uint32_t rx_dropped;                        ///< Received packets dropped because the application core RX ring was full
+    uint32_t tx_packets;                        ///< Packets handed to Mari
+    uint32_t tx_deferred;                       ///< Times queued packets waited for the node to be connected
+    uint16_t connections;                       ///< Number of times the node joined a gateway
+    uint16_t disconnections;                    ///< Number of times the node left its gateway
+    uint8_t  disconnect_reason;                 ///< Reason of the latest disconnection (Mari event tag)
+    int8_t   rssi;                              ///< RSSI of the latest received packet in dBm
+    int8_t   rssi_avg;                          ///< Smoothed RSSI in dBm
+    uint8_t  tx_ring_max;                       ///< Max number of PDUs found waiting in the TX ring
+} swrmt_link_stats_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  count;                                         ///< Number of waypoints
+    uint8_t  length;                                        ///< Length of the coordinates in bytes
+    uint32_t coordinates[SWRMT_RESET_WAYPOINTS_MAX][2];     ///< X and Y coordinates of the waypoints, multiplied by 1e6
+} swrmt_reset_waypoints_pkt_t;
+
+/// Start request scheduled a delay after its reception, all the devices receiving the same broadcast start together
+typedef struct __attribute__((packed)) {
+    uint8_t  id;                                ///< Identifies the start, retries carry the same ID with the remaining delay
+    uint32_t delay_us;                          ///< Delay between the reception and the start
+} swrmt_start_at_pkt_t;
+
+/// Time broadcast by the controller, all the devices receiving the same broadcast are synchronized together
+typedef struct __attribute__((packed)) {
+    uint64_t time_us;                           ///< Controller time in us at the transmission
+} swrmt_time_sync_pkt_t;
+
+/// Read back a window of the data recorded by the user image, answered with consecutive chunks
+typedef struct __attribute__((packed)) {
+    uint32_t offset;                            ///< Offset of the first chunk in the recorded data
+    uint8_t  count;                             ///< Number of chunks, up to SWRMT_RECORD_WINDOW_MAX
+} swrmt_record_read_pkt_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t net_id;                            ///< Mari network ID
+    uint8_t  schedule;                          ///< Mari schedule (see swrmt_schedule_t)
+} swrmt_network_config_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  group;                             ///< Group the packet is addressed to
+    uint8_t  length;                            ///< Length of the wrapped packet
+    uint8_t  packet[UINT8_MAX - 3];             ///< Wrapped packet, starting with its type
+} swrmt_multicast_pkt_t;
+
 typedef struct __attribute__((packed)) {
     uint8_t port;  ///< Port number of the GPIO
     uint8_t pin;   ///< Pin number of the GPIO
-    uint8_t value;
+    uint8_t value; ///< Level of the GPIO
 } gpio_data_t;
 
 typedef struct __attribute__((packed)) {
-    uint32_t timestamp;
+    uint32_t timestamp;     ///< Network time of the event in us, truncated to 32 bits
     gpio_data_t data;
 } swrmt_gpio_event_t;
 
+/// Statistics of a profiled section, in cycles of the core running it
+typedef struct __attribute__((packed)) {
+    uint32_t count;                             ///< Number of measures
+    uint32_t min;                               ///< Shortest measure
+    uint32_t max;                               ///< Longest measure
+    uint64_t total;                             ///< Sum of the measures
+} swrmt_profile_entry_t;
+
+typedef enum {
+    SWRMT_PROFILE_CORE_APP = 0,                 ///< Sections of the application core, ordered as profile_id_t
+    SWRMT_PROFILE_CORE_NET = 1,                 ///< Request handlers of the network core, by request type
+} swrmt_profile_core_t;
+
+/// Send the profile statistics of both cores
+typedef struct __attribute__((packed)) {
+    uint8_t  clear;                             ///< Clear the statistics once sent
+} swrmt_profile_pkt_t;
+
+/// Header of a notification holding consecutive profile entries
+typedef struct __attribute__((packed)) {
+    uint8_t  core;                              ///< Core of the entries (see swrmt_profile_core_t)
+    uint8_t  cpu_mhz;                           ///< Frequency of the core, to convert the cycles
+    uint8_t  index;                             ///< Index of the first entry
+    uint8_t  count;                             ///< Number of entries, up to SWRMT_PROFILE_BATCH_MAX
+    uint8_t  size;                              ///< Size of the entries in bytes
+} swrmt_profile_header_t;
+
 ///< DotBot protocol TDMA table update [all units are in microseconds]
 typedef struct __attribute__((packed)) {
     uint32_t frame_period;       ///< duration of a full TDMA frame
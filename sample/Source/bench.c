@@ -0,0 +1,213 @@
+/**
+ * @file
+ * @author Alexandre Abadie <alexandre.abadie@inria.fr>
+ * @brief Benchmark non secure application, answers the `swarmit bench` scenarios
+ *
+ * Requests are received as messages and answered with messages, whose content
+ * starts with an opcode:
+ * - ping requests are echoed with the IPC round trip time measured on the device,
+ * - uplink requests are answered with a burst of packets sent back to back,
+ * - flood packets are counted to measure the rate of received packets.
+ *
+ * @copyright Inria, 2025
+ *
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <nrf.h>
+
+#define SWARMIT_MESSAGE         (0xA0)
+#define BENCH_PING              (0x01)  ///< [seq u32], answered with a pong
+#define BENCH_PONG              (0x02)  ///< [seq u32][ipc_rtt_us u32][flood_count u32][flood_duration_us u32]
+#define BENCH_UPLINK            (0x03)  ///< [count u16][size u8], answered with count uplink data packets
+#define BENCH_UPLINK_DATA       (0x04)  ///< [seq u16][previous send duration in us u32][padding]
+#define BENCH_FLOOD             (0x05)  ///< [seq u32], counted, seq 0 restarts the count
+#define BENCH_PING_SIZE         (1 + sizeof(uint32_t))
+#define BENCH_UPLINK_SIZE       (1 + sizeof(uint16_t) + sizeof(uint8_t))
+#define BENCH_FLOOD_SIZE        (1 + sizeof(uint32_t))
+#define BENCH_PAYLOAD_MAX_SIZE  (200)
+#define BENCH_KEEP_ALIVE_US     (500000)
+#define BENCH_KEEP_ALIVE_BURST  (16)    ///< Uplink packets sent between 2 watchdog reloads
+
+typedef void (*ipc_isr_cb_t)(const uint8_t *, size_t);
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint8_t length;
+    uint8_t content[UINT8_MAX];
+} msg_packet_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  opcode;
+    uint32_t seq;
+    uint32_t ipc_rtt_us;
+    uint32_t flood_count;
+    uint32_t flood_duration_us;
+} bench_pong_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t  opcode;
+    uint16_t seq;
+    uint32_t send_us;
+} bench_uplink_data_t;
+
+typedef struct {
+    bool     ping_pending;
+    uint32_t ping_seq;
+    bool     uplink_pending;
+    uint16_t uplink_count;
+    uint8_t  uplink_size;
+    uint32_t flood_count;
+    uint32_t flood_first_us;
+    uint32_t flood_last_us;
+    uint32_t keep_alive_us;
+} bench_vars_t;
+
+void swarmit_keep_alive(void);
+void swarmit_send_raw_data(const uint8_t *packet, uint8_t length);
+void swarmit_ipc_isr_drain(ipc_isr_cb_t cb);
+void swarmit_init_rng(void);
+void swarmit_read_rng(uint8_t *value);
+
+static volatile bench_vars_t _bench_vars = { 0 };
+
+static uint32_t _now_us(void) {
+    NRF_TIMER0_NS->TASKS_CAPTURE[1] = 1;
+    return NRF_TIMER0_NS->CC[1];
+}
+
+static void _send_message(const void *content, uint8_t length) {
+    uint8_t packet[BENCH_PAYLOAD_MAX_SIZE + 2];
+    packet[0] = SWARMIT_MESSAGE;
+    packet[1] = length;
+    memcpy(&packet[2], content, length);
+    swarmit_send_raw_data(packet, length + 2);
+}
+
+static void _keep_alive(void) {
+    swarmit_keep_alive();
+    _bench_vars.keep_alive_us = _now_us();
+}
+
+static void _send_pong(uint32_t seq) {
+    // The RNG read is a round trip with the network core, the network time is read locally
+    uint8_t value;
+    uint32_t start = _now_us();
+    swarmit_read_rng(&value);
+    bench_pong_t pong = {
+        .opcode            = BENCH_PONG,
+        .seq               = seq,
+        .ipc_rtt_us        = _now_us() - start,
+        .flood_count       = _bench_vars.flood_count,
+        .flood_duration_us = _bench_vars.flood_last_us - _bench_vars.flood_first_us,
+    };
+    _send_message(&pong, sizeof(pong));
+}
+
+static void _send_uplink(uint16_t count, uint8_t size) {
+    uint8_t content[BENCH_PAYLOAD_MAX_SIZE] = { 0 };
+    bench_uplink_data_t *data = (bench_uplink_data_t *)content;
+    data->opcode = BENCH_UPLINK_DATA;
+    data->send_us = 0;
+    for (uint16_t seq = 0; seq < count; seq++) {
+        data->seq = seq;
+        uint32_t start = _now_us();
+        // Blocks until a TX slot is free, so the uplink stays saturated
+        _send_message(content, size);
+        data->send_us = _now_us() - start;
+        if (seq % BENCH_KEEP_ALIVE_BURST == 0) {
+            _keep_alive();
+        }
+    }
+}
+
+static void _rx_data_callback(const uint8_t *data, size_t length) {
+    const msg_packet_t *msg = (const msg_packet_t *)data;
+    if (length < 3 || msg->type != SWARMIT_MESSAGE || msg->length == 0 || length < 2U + msg->length) {
+        return;
+    }
+    switch (msg->content[0]) {
+        case BENCH_PING:
+            if (msg->length < BENCH_PING_SIZE) {
+                break;
+            }
+            memcpy((void *)&_bench_vars.ping_seq, &msg->content[1], sizeof(uint32_t));
+            _bench_vars.ping_pending = true;
+            break;
+        case BENCH_UPLINK:
+        {
+            if (msg->length < BENCH_UPLINK_SIZE) {
+                break;
+            }
+            uint16_t count;
+            memcpy(&count, &msg->content[1], sizeof(uint16_t));
+            uint8_t size = msg->content[3];
+            if (size < sizeof(bench_uplink_data_t)) {
+                size = sizeof(bench_uplink_data_t);
+            } else if (size > BENCH_PAYLOAD_MAX_SIZE) {
+                size = BENCH_PAYLOAD_MAX_SIZE;
+            }
+            _bench_vars.uplink_count = count;
+            _bench_vars.uplink_size = size;
+            _bench_vars.uplink_pending = true;
+        } break;
+        case BENCH_FLOOD:
+        {
+            if (msg->length < BENCH_FLOOD_SIZE) {
+                break;
+            }
+            uint32_t seq;
+            memcpy(&seq, &msg->content[1], sizeof(uint32_t));
+            uint32_t now = _now_us();
+            if (seq == 0) {
+                _bench_vars.flood_count = 0;
+                _bench_vars.flood_first_us = now;
+            }
+            _bench_vars.flood_count++;
+            _bench_vars.flood_last_us = now;
+        } break;
+        default:
+            break;
+    }
+}
+
+int main(void) {
+    NRF_TIMER0_NS->TASKS_CLEAR = 1;
+    NRF_TIMER0_NS->PRESCALER   = 4;  // Run TIMER at 1MHz
+    NRF_TIMER0_NS->BITMODE     = (TIMER_BITMODE_BITMODE_32Bit << TIMER_BITMODE_BITMODE_Pos);
+    NRF_TIMER0_NS->CC[0]       = BENCH_KEEP_ALIVE_US;
+    NRF_TIMER0_NS->INTEN       = (TIMER_INTENSET_COMPARE0_Enabled << TIMER_INTENSET_COMPARE0_Pos);
+    NVIC_EnableIRQ(TIMER0_IRQn);
+    NRF_TIMER0_NS->TASKS_START = 1;
+    swarmit_init_rng();
+
+    while (1) {
+        __WFE();
+        if (_bench_vars.ping_pending) {
+            _bench_vars.ping_pending = false;
+            _send_pong(_bench_vars.ping_seq);
+        }
+        if (_bench_vars.uplink_pending) {
+            _bench_vars.uplink_pending = false;
+            _send_uplink(_bench_vars.uplink_count, _bench_vars.uplink_size);
+        }
+        if (_now_us() - _bench_vars.keep_alive_us >= BENCH_KEEP_ALIVE_US) {
+            _keep_alive();
+        }
+    };
+}
+
+void TIMER0_IRQHandler(void) {
+
+    if (NRF_TIMER0_NS->EVENTS_COMPARE[0] == 1) {
+        NRF_TIMER0_NS->EVENTS_COMPARE[0] = 0;
+        // Wake up the main loop regularly to reload the watchdog
+        NRF_TIMER0_NS->CC[0] += BENCH_KEEP_ALIVE_US;
+    }
+}
+
+void IPC_IRQHandler(void) {
+    swarmit_ipc_isr_drain(_rx_data_callback);
+}
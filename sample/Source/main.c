@@ -25,7 +25,7 @@ typedef struct __attribute__((packed)) {
 
 void swarmit_keep_alive(void);
 void swarmit_send_data_packet(const uint8_t *packet, uint8_t length);
-void swarmit_ipc_isr(ipc_isr_cb_t cb);
+void swarmit_ipc_isr_drain(ipc_isr_cb_t cb);
 void swarmit_log_data(uint8_t *data, size_t length);
 static bool _timer_running = false;
 
@@ -77,5 +77,5 @@ void TIMER0_IRQHandler(void) {
 }
 
 void IPC_IRQHandler(void) {
-    swarmit_ipc_isr(_rx_data_callback);
+    swarmit_ipc_isr_drain(_rx_data_callback);
 }
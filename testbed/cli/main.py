@@ -1,6 +1,9 @@
 #!/usr/bin/env python
 
+import dataclasses
+import json
 import logging
+import os
 import time
 
 import click
@@ -12,15 +15,36 @@ from rich.console import Console
 from rich.pretty import pprint
 
 from testbed.swarmit import __version__
+from testbed.swarmit.bench import (
+    BENCH_UPLINK_SIZE_MAX,
+    BENCH_UPLINK_SIZE_MIN,
+    Bench,
+    bench_ota,
+    merge_metrics,
+    print_bench_report,
+)
 from testbed.swarmit.controller import (
-    CHUNK_SIZE,
+    LH2_BASESTATIONS_MAX,
+    MULTICAST_GROUPS_MAX,
     OTA_ACK_TIMEOUT_DEFAULT,
+    OTA_MANIFEST_CHUNK_SIZES,
     OTA_MAX_RETRIES_DEFAULT,
+    OTA_WINDOW_DEFAULT,
     Controller,
     ControllerSettings,
     ResetLocation,
+    print_profile,
     print_transfer_status,
 )
+from testbed.swarmit.logfmt import (
+    formats_from_elf,
+    load_formats,
+    save_formats,
+)
+from testbed.swarmit.manifest import MANIFEST_MAGIC, OtaManifest
+from testbed.swarmit.multi import MultiController
+from testbed.swarmit.planner import plan_reset
+from testbed.swarmit.protocol import MariSchedule, parse_records
 
 SERIAL_PORT_DEFAULT = get_default_port()
 BAUDRATE_DEFAULT = 1000000
@@ -29,6 +53,7 @@ MQTT_PORT_DEFAULT = 1883
 # Default network ID for SwarmIT tests is 0x12**
 # See https://crystalfree.atlassian.net/wiki/spaces/Mari/pages/3324903426/Registry+of+Mari+Network+IDs
 SWARMIT_NETWORK_ID_DEFAULT = "1200"
+SIM_DEVICES_DEFAULT = 100
 
 
 @click.group(context_settings=dict(help_option_names=["-h", "--help"]))
@@ -37,7 +62,7 @@ SWARMIT_NETWORK_ID_DEFAULT = "1200"
     "--port",
     type=str,
     default=SERIAL_PORT_DEFAULT,
-    help=f"Serial port to use to send the bitstream to the gateway. Default: {SERIAL_PORT_DEFAULT}.",
+    help=f"Serial port to use to send the bitstream to the gateway, several gateways can be separated with ,. Default: {SERIAL_PORT_DEFAULT}.",
 )
 @click.option(
     "-b",
@@ -71,15 +96,29 @@ SWARMIT_NETWORK_ID_DEFAULT = "1200"
     "--network-id",
     type=str,
     default=SWARMIT_NETWORK_ID_DEFAULT,
-    help=f"Marilib network ID to use. Default: 0x{SWARMIT_NETWORK_ID_DEFAULT}",
+    help=f"Marilib network ID to use, several networks can be separated with ,. Default: 0x{SWARMIT_NETWORK_ID_DEFAULT}",
 )
 @click.option(
     "-a",
     "--adapter",
-    type=click.Choice(["edge", "cloud"], case_sensitive=True),
+    type=click.Choice(["edge", "cloud", "sim"], case_sensitive=True),
     default="edge",
     show_default=True,
-    help="Choose the adapter to communicate with the gateway.",
+    help="Choose the adapter to communicate with the gateway, sim simulates the devices of each network ID.",
+)
+@click.option(
+    "--sim-devices",
+    type=click.IntRange(1, 0xFFFF),
+    default=SIM_DEVICES_DEFAULT,
+    show_default=True,
+    help="Number of devices simulated by the sim adapter, for each network ID.",
+)
+@click.option(
+    "--sim-loss",
+    type=click.FloatRange(0, 1),
+    default=0.0,
+    show_default=True,
+    help="Probability that a frame is lost by the sim adapter.",
 )
 @click.option(
     "-d",
@@ -88,6 +127,13 @@ SWARMIT_NETWORK_ID_DEFAULT = "1200"
     default="",
     help="Subset list of device addresses to interact with, separated with ,",
 )
+@click.option(
+    "-g",
+    "--group",
+    type=click.IntRange(0, MULTICAST_GROUPS_MAX - 1),
+    default=None,
+    help="Multicast group of the selected devices, commands are sent once to the group. Requires --devices.",
+)
 @click.option(
     "-v",
     "--verbose",
@@ -105,7 +151,10 @@ def main(
     mqtt_use_tls,
     network_id,
     adapter,
+    sim_devices,
+    sim_loss,
     devices,
+    group,
     verbose,
 ):
     if ctx.invoked_subcommand != "monitor":
@@ -115,26 +164,61 @@ def main(
                 logging.CRITICAL
             ),
         )
+    if group is not None and not devices:
+        # The members of the group are needed to track their answers
+        Console().print(
+            "[bold red]Error:[/] --group requires the devices of the group "
+            "(--devices). Exiting."
+        )
+        ctx.exit()
     ctx.ensure_object(dict)
+    ports = [p for p in port.split(",") if p]
+    network_ids = [int(n, 16) for n in network_id.split(",") if n]
     ctx.obj["settings"] = ControllerSettings(
-        serial_port=port,
+        serial_port=ports[0],
         serial_baudrate=baudrate,
         mqtt_host=mqtt_host,
         mqtt_port=mqtt_port,
         mqtt_use_tls=mqtt_use_tls,
-        network_id=int(network_id, 16),
+        network_id=network_ids[0],
         adapter=adapter,
+        sim_devices=sim_devices,
+        sim_loss=sim_loss,
         devices=[d for d in devices.split(",") if d],
+        group=group,
         verbose=verbose,
     )
+    # Each gateway is reached with its own serial port or network ID
+    if adapter in ("cloud", "sim"):
+        ctx.obj["gateways"] = [{"network_id": n} for n in network_ids]
+    else:
+        ctx.obj["gateways"] = [{"serial_port": p} for p in ports]
+
+
+def _controller(ctx) -> Controller | MultiController:
+    """Return a controller driving all the gateways in parallel."""
+    settings = ctx.obj["settings"]
+    gateways = ctx.obj["gateways"]
+    if len(gateways) == 1:
+        return Controller(settings)
+    return MultiController(
+        [dataclasses.replace(settings, **gateway) for gateway in gateways]
+    )
 
 
 @main.command()
+@click.option(
+    "--delay",
+    type=click.FloatRange(0, 0xFFFFFFFF / 1e6),
+    default=0,
+    show_default=True,
+    help="Start all the devices together after this delay in seconds.",
+)
 @click.pass_context
-def start(ctx):
+def start(ctx, delay):
     """Start the user application."""
     try:
-        controller = Controller(ctx.obj["settings"])
+        controller = _controller(ctx)
     except (
         SerialInterfaceException,
         serial.serialutil.SerialException,
@@ -143,7 +227,7 @@ def start(ctx):
         console.print(f"[bold red]Error:[/] {exc}")
         return
     if controller.ready_devices:
-        controller.start()
+        controller.start(time.time() + delay if delay > 0 else None)
     else:
         print("No device to start")
     controller.terminate()
@@ -154,7 +238,7 @@ def start(ctx):
 def stop(ctx):
     """Stop the user application."""
     try:
-        controller = Controller(ctx.obj["settings"])
+        controller = _controller(ctx)
     except (
         SerialInterfaceException,
         serial.serialutil.SerialException,
@@ -162,26 +246,52 @@ def stop(ctx):
         console = Console()
         console.print(f"[bold red]Error:[/] {exc}")
         return
-    if controller.running_devices or controller.resetting_devices:
+    if (
+        controller.running_devices
+        or controller.resetting_devices
+        or controller.ready_devices
+    ):
         controller.stop()
     else:
         print("[bold]No device to stop[/]")
     controller.terminate()
 
 
+def _load_firmware(firmware) -> OtaManifest:
+    """Return the OTA manifest of a firmware file, or the manifest file."""
+    header = firmware.read(len(MANIFEST_MAGIC))
+    if OtaManifest.is_manifest(header):
+        return OtaManifest.load(firmware.name)
+    return OtaManifest.from_image(header + firmware.read())
+
+
+def _parse_location(location: str) -> ResetLocation:
+    pos_x, pos_y = location.split(",")
+    return ResetLocation(
+        pos_x=int(float(pos_x) * 1e6), pos_y=int(float(pos_y) * 1e6)
+    )
+
+
 @main.command()
+@click.option(
+    "-a",
+    "--assign",
+    is_flag=True,
+    help="Assign the locations to the ready devices, minimizing the total distance and avoiding collisions.",
+)
 @click.argument(
     "locations",
     type=str,
 )
 @click.pass_context
-def reset(ctx, locations):
+def reset(ctx, assign, locations):
     """Reset robots locations.
 
-    Locations are provided as '<device_addr>:<x>,<y>-<device_addr>:<x>,<y>|...'
+    Locations are provided as '<device_addr>:<x>,<y>-<device_addr>:<x>,<y>|...',
+    or as '<x>,<y>-<x>,<y>|...' with --assign.
     """
     try:
-        controller = Controller(ctx.obj["settings"])
+        controller = _controller(ctx)
     except (
         SerialInterfaceException,
         serial.serialutil.SerialException,
@@ -190,15 +300,30 @@ def reset(ctx, locations):
         console.print(f"[bold red]Error:[/] {exc}")
         return
 
+    if assign:
+        # Devices are discovered when listing the ready ones
+        ready_devices = controller.ready_devices
+        status_data = controller.status_data
+        positions = {
+            addr: (status_data[addr].pos_x, status_data[addr].pos_y)
+            for addr in ready_devices
+        }
+        if not positions:
+            print("No device to reset.")
+            return
+        targets = [
+            _parse_location(location) for location in locations.split("-")
+        ]
+        controller.reset_waypoints(plan_reset(positions, targets))
+        controller.terminate()
+        return
+
     devices = controller.settings.devices
     if not devices:
         print("No devices selected.")
         return
     locations = {
-        int(location.split(":")[0], 16): ResetLocation(
-            pos_x=int(float(location.split(":")[1].split(",")[0]) * 1e6),
-            pos_y=int(float(location.split(":")[1].split(",")[1]) * 1e6),
-        )
+        location.split(":")[0]: _parse_location(location.split(":")[1])
         for location in locations.split("-")
     }
     if sorted(devices) and sorted(locations.keys()) != sorted(devices):
@@ -230,7 +355,7 @@ def reset(ctx, locations):
     type=float,
     default=OTA_ACK_TIMEOUT_DEFAULT,
     show_default=True,
-    help="Timeout in seconds for each OTA ACK message.",
+    help="Initial timeout in seconds for each OTA ACK message, then adapted to the measured round trip time.",
 )
 @click.option(
     "-r",
@@ -240,26 +365,80 @@ def reset(ctx, locations):
     show_default=True,
     help="Number of retries for each OTA message (start or chunk) transfer.",
 )
+@click.option(
+    "-w",
+    "--ota-window",
+    type=int,
+    default=OTA_WINDOW_DEFAULT,
+    show_default=True,
+    help="Number of chunks sent before requesting an ACK bitmap (0 to ACK each chunk).",
+)
+@click.option(
+    "-z",
+    "--compress",
+    is_flag=True,
+    help="Compress the firmware, devices decompress it while flashing.",
+)
+@click.option(
+    "--delta",
+    is_flag=True,
+    help="Only rewrite the flash pages differing from the installed image.",
+)
+@click.option(
+    "--chunk-hash",
+    is_flag=True,
+    help="Also verify the hash of each chunk, the image hash is always verified.",
+)
+@click.option(
+    "--ota-session",
+    type=click.Path(dir_okay=False),
+    help="File saving the progress of the transfer, read to resume it when flashing the same image again.",
+)
 @click.argument("firmware", type=click.File(mode="rb"), required=False)
 @click.pass_context
-def flash(ctx, yes, start, ota_timeout, ota_max_retries, firmware):
-    """Flash a firmware to the robots."""
+def flash(
+    ctx,
+    yes,
+    start,
+    ota_timeout,
+    ota_max_retries,
+    ota_window,
+    compress,
+    delta,
+    chunk_hash,
+    ota_session,
+    firmware,
+):
+    """Flash a firmware, or its OTA manifest, to the robots."""
     console = Console()
     if firmware is None:
         console.print("[bold red]Error:[/] Missing firmware file. Exiting.")
         ctx.exit()
+    if compress and delta:
+        console.print(
+            "[bold red]Error:[/] Compressed images cannot be flashed in "
+            "delta mode. Exiting."
+        )
+        ctx.exit()
     ctx.obj["settings"].ota_timeout = ota_timeout
     ctx.obj["settings"].ota_max_retries = ota_max_retries
-    fw = bytearray(firmware.read())
-    controller = Controller(ctx.obj["settings"])
-    if not controller.ready_devices:
+    ctx.obj["settings"].ota_window = ota_window
+    ctx.obj["settings"].ota_compress = compress
+    ctx.obj["settings"].ota_delta = delta
+    ctx.obj["settings"].ota_chunk_hash = chunk_hash
+    ctx.obj["settings"].ota_session = ota_session
+    try:
+        fw = _load_firmware(firmware)
+    except ValueError as exc:
+        console.print(f"[bold red]Error:[/] {exc}. Exiting.")
+        ctx.exit()
+    controller = _controller(ctx)
+    if not controller.ota_devices:
         console.print("[bold red]Error:[/] No ready device found. Exiting.")
         controller.terminate()
         return
-    print(
-        f"Devices to flash ([bold white]{len(controller.ready_devices)}):[/]"
-    )
-    pprint(controller.ready_devices, expand_all=True)
+    print(f"Devices to flash ([bold white]{len(controller.ota_devices)}):[/]")
+    pprint(controller.ota_devices, expand_all=True)
     if yes is False:
         click.confirm("Do you want to continue?", default=True, abort=True)
 
@@ -278,15 +457,29 @@ def flash(ctx, yes, start, ota_timeout, ota_max_retries, firmware):
         controller.terminate()
         raise click.Abort()
     print()
-    print(f"Image size: [bold cyan]{len(fw)}B[/]")
+    print(f"Image size: [bold cyan]{fw.fw_length}B[/]")
+    if controller.settings.ota_compress:
+        print(
+            "Compressed size: "
+            f"[bold cyan]{start_data['ota'].compressed_size}B[/]"
+        )
+    if controller.settings.ota_delta:
+        print(
+            "Unchanged chunks: "
+            f"{len(start_data['ota'].unchanged_chunks)}"
+            f"/{start_data['ota'].chunks}"
+        )
+    if start_data["ota"].resumed:
+        print(f"Resumed devices: {len(start_data['ota'].resumed)}")
     print(
         f"Image hash: [bold cyan]{start_data['ota'].fw_hash.hex().upper()}[/]"
     )
     print(
-        f"Radio chunks ([bold]{CHUNK_SIZE}B[/bold]): {start_data['ota'].chunks}"
+        f"Radio chunks ([bold]{start_data['ota'].chunk_size}B[/bold]): "
+        f"{start_data['ota'].chunks}"
     )
     start_time = time.time()
-    data = controller.transfer(fw, start_data["acked"])
+    data = controller.transfer(start_data["acked"])
     print(f"Elapsed: [bold cyan]{time.time() - start_time:.3f}s[/bold cyan]")
     print_transfer_status(data, start_data["ota"])
     if controller.settings.verbose:
@@ -305,11 +498,19 @@ def flash(ctx, yes, start, ota_timeout, ota_max_retries, firmware):
 
 
 @main.command()
+@click.option(
+    "-f",
+    "--log-formats",
+    type=click.Path(exists=True, dir_okay=False),
+    help="ELF file of the user image or dictionary used to render formatted logs.",
+)
 @click.pass_context
-def monitor(ctx):
+def monitor(ctx, log_formats):
     """Monitor running applications."""
+    if log_formats is not None:
+        ctx.obj["settings"].log_formats = load_formats(log_formats)
     try:
-        controller = Controller(ctx.obj["settings"])
+        controller = _controller(ctx)
     except (
         SerialInterfaceException,
         serial.serialutil.SerialException,
@@ -325,11 +526,388 @@ def monitor(ctx):
         controller.terminate()
 
 
+@main.command("log-formats")
+@click.argument("elf", type=click.File(mode="rb"))
+@click.argument("output", type=click.Path(dir_okay=False, writable=True))
+def log_formats(elf, output):
+    """Extract the log format strings of a user image to a dictionary."""
+    formats = formats_from_elf(elf.read())
+    save_formats(formats, output)
+    print(f"Saved [bold cyan]{len(formats)}[/] log formats to {output}")
+
+
+@main.command()
+@click.option(
+    "-z",
+    "--compress",
+    is_flag=True,
+    help="Also precompute the compressed image, flashed with --compress.",
+)
+@click.argument("firmware", type=click.File(mode="rb"))
+@click.argument("output", type=click.Path(dir_okay=False, writable=True))
+def manifest(compress, firmware, output):
+    """Precompute the OTA data of a firmware, flashed instead of it."""
+    ota_manifest = OtaManifest.from_image(firmware.read())
+    ota_manifest.save(output, OTA_MANIFEST_CHUNK_SIZES, compress)
+    print(
+        f"Saved the OTA manifest of the [bold cyan]{ota_manifest.fw_length}B"
+        f"[/] image to {output}"
+    )
+
+
+@main.group()
+def config():
+    """Configure the robots."""
+
+
+@config.command("status")
+@click.option(
+    "-b",
+    "--heartbeat",
+    type=click.IntRange(0, 0xFFFFFFFF),
+    default=1000,
+    show_default=True,
+    help="Max delay in ms between 2 status notifications (0 to disable).",
+)
+@click.option(
+    "-t",
+    "--position-threshold",
+    type=click.FloatRange(0, 0xFFFFFFFF / 1e6),
+    default=0,
+    show_default=True,
+    help="Position change triggering a status notification (0 to disable).",
+)
+@click.option(
+    "--on-change/--no-on-change",
+    default=True,
+    show_default=True,
+    help="Send a status notification as soon as the status changes.",
+)
+@click.pass_context
+def config_status(ctx, heartbeat, position_threshold, on_change):
+    """Configure when the robots send their status."""
+    controller = _controller(ctx)
+    controller.configure_status_policy(
+        heartbeat, int(position_threshold * 1e6), on_change
+    )
+    controller.terminate()
+
+
+@config.command("groups")
+@click.argument(
+    "groups",
+    type=click.IntRange(0, MULTICAST_GROUPS_MAX - 1),
+    nargs=-1,
+)
+@click.pass_context
+def config_groups(ctx, groups):
+    """Set the multicast groups of the robots, none to leave all groups."""
+    controller = _controller(ctx)
+    controller.configure_groups(list(groups))
+    controller.terminate()
+
+
+@config.command("network")
+@click.option(
+    "-i",
+    "--net-id",
+    type=str,
+    required=True,
+    help="Mari network ID to join, the gateway must use the same one.",
+)
+@click.option(
+    "-s",
+    "--schedule",
+    type=click.Choice(MariSchedule.__members__, case_sensitive=False),
+    default=MariSchedule.Tiny.name,
+    show_default=True,
+    help="Mari schedule, larger schedules have more slots and more latency.",
+)
+@click.pass_context
+def config_network(ctx, net_id, schedule):
+    """Set the Mari network ID and schedule of the robots."""
+    controller = _controller(ctx)
+    controller.configure_network(int(net_id, 16), MariSchedule[schedule])
+    controller.terminate()
+
+
+@config.command("calibration")
+@click.argument("calibration", type=click.File(mode="r"))
+@click.pass_context
+def config_calibration(ctx, calibration):
+    """Upload the LH2 calibration of the arena to the ready robots.
+
+    The calibration is a JSON object mapping basestation indexes to their
+    3x3 homography matrix, e.g. '{"0": [[1, 0, 0], [0, 1, 0], [0, 0, 1]]}'.
+    """
+    homographies = {}
+    for basestation, matrix in json.load(calibration).items():
+        basestation = int(basestation)
+        if not 0 <= basestation < LH2_BASESTATIONS_MAX:
+            print(f"[bold red]Error:[/] invalid basestation {basestation}")
+            return
+        if len(matrix) != 3 or any(len(row) != 3 for row in matrix):
+            print(f"[bold red]Error:[/] invalid homography {matrix}")
+            return
+        homographies[basestation] = [
+            [int(element * 1e6) for element in row] for row in matrix
+        ]
+    controller = _controller(ctx)
+    controller.configure_calibration(homographies)
+    controller.terminate()
+
+
+@main.command()
+@click.option(
+    "-o",
+    "--output",
+    type=click.Path(file_okay=False, writable=True),
+    default=".",
+    show_default=True,
+    help="Directory where the records of each robot are written.",
+)
+@click.pass_context
+def dump(ctx, output):
+    """Download the data recorded by the stopped robots."""
+    try:
+        controller = _controller(ctx)
+    except (
+        SerialInterfaceException,
+        serial.serialutil.SerialException,
+    ) as exc:
+        console = Console()
+        console.print(f"[bold red]Error:[/] {exc}")
+        return
+    if not controller.ready_devices:
+        print("[bold]No device to read[/]")
+        controller.terminate()
+        return
+    downloads = controller.download_records()
+    controller.terminate()
+    os.makedirs(output, exist_ok=True)
+    for addr, download in sorted(downloads.items()):
+        data = download.data
+        path = os.path.join(output, f"{addr}.records")
+        with open(path, "wb") as records_file:
+            records_file.write(data)
+        state = "" if download.complete else " [bold red](incomplete)[/]"
+        print(
+            f"{addr}: {len(parse_records(data))} records, {len(data)}B "
+            f"written to {path}{state}"
+        )
+
+
+@main.command()
+@click.option(
+    "-c",
+    "--clear",
+    is_flag=True,
+    help="Clear the statistics once read.",
+)
+@click.pass_context
+def profile(ctx, clear):
+    """Print the time spent in the secure code and the network core."""
+    try:
+        controller = _controller(ctx)
+    except (
+        SerialInterfaceException,
+        serial.serialutil.SerialException,
+    ) as exc:
+        console = Console()
+        console.print(f"[bold red]Error:[/] {exc}")
+        return
+    if not controller.ready_devices and not controller.running_devices:
+        print("[bold]No device to profile[/]")
+        controller.terminate()
+        return
+    profiles = controller.profile(clear)
+    controller.terminate()
+    print_profile(profiles)
+
+
+@main.group()
+@click.option(
+    "--per-device",
+    is_flag=True,
+    help="Also report the percentiles measured on each device.",
+)
+@click.pass_context
+def bench(ctx, per_device):
+    """Benchmark the testbed.
+
+    The radio scenarios need the robots to run the bench image.
+    """
+    ctx.obj["per_device"] = per_device
+
+
+def _run_bench(ctx, scenario: callable):
+    """Run a radio scenario on the running devices of each gateway."""
+    try:
+        controller = _controller(ctx)
+    except (
+        SerialInterfaceException,
+        serial.serialutil.SerialException,
+    ) as exc:
+        console = Console()
+        console.print(f"[bold red]Error:[/] {exc}")
+        return
+    shards = (
+        controller.controllers
+        if isinstance(controller, MultiController)
+        else [controller]
+    )
+    # Gateways are measured one after the other
+    benches = [Bench(shard) for shard in shards if shard.running_devices]
+    if not benches:
+        print("[bold]No running device to benchmark[/]")
+        controller.terminate()
+        return
+    results = []
+    for bench in benches:
+        results.append(scenario(bench))
+        # Messages are only recorded while a scenario runs
+        bench.controller.clear_messages()
+    metrics = merge_metrics(results)
+    controller.terminate()
+    print_bench_report(metrics, ctx.obj["per_device"])
+
+
+@bench.command("rtt")
+@click.option(
+    "-c",
+    "--count",
+    type=click.IntRange(1),
+    default=100,
+    show_default=True,
+    help="Number of pings sent to the robots.",
+)
+@click.option(
+    "-i",
+    "--interval",
+    type=float,
+    default=0.1,
+    show_default=True,
+    help="Min delay in seconds between 2 pings.",
+)
+@click.pass_context
+def bench_rtt(ctx, count, interval):
+    """Measure the ping-pong and IPC round trip times."""
+    _run_bench(ctx, lambda bench: bench.rtt(count, interval))
+
+
+@bench.command("uplink")
+@click.option(
+    "-c",
+    "--count",
+    type=click.IntRange(1, 0xFFFF),
+    default=500,
+    show_default=True,
+    help="Number of packets sent back to back by each robot.",
+)
+@click.option(
+    "-s",
+    "--size",
+    type=click.IntRange(BENCH_UPLINK_SIZE_MIN, BENCH_UPLINK_SIZE_MAX),
+    default=BENCH_UPLINK_SIZE_MAX,
+    show_default=True,
+    help="Size in bytes of the packets.",
+)
+@click.pass_context
+def bench_uplink(ctx, count, size):
+    """Measure the rate of a saturated uplink."""
+    _run_bench(ctx, lambda bench: bench.uplink(count, size))
+
+
+@bench.command("downlink")
+@click.option(
+    "-c",
+    "--count",
+    type=click.IntRange(1),
+    default=500,
+    show_default=True,
+    help="Number of packets sent to the robots.",
+)
+@click.option(
+    "-i",
+    "--interval",
+    type=float,
+    default=0,
+    show_default=True,
+    help="Min delay in seconds between 2 packets.",
+)
+@click.pass_context
+def bench_downlink(ctx, count, interval):
+    """Measure the rate of packets received by the robots."""
+    _run_bench(ctx, lambda bench: bench.downlink(count, interval))
+
+
+@bench.command("ota")
+@click.option(
+    "-y",
+    "--yes",
+    is_flag=True,
+    help="Flash the firmware without prompt.",
+)
+@click.option(
+    "-n",
+    "--runs",
+    type=click.IntRange(1),
+    default=3,
+    show_default=True,
+    help="Number of times the firmware is flashed.",
+)
+@click.option(
+    "-s",
+    "--size",
+    type=click.IntRange(0),
+    default=0,
+    show_default=True,
+    help="Pad the firmware with erased flash to this size in kB.",
+)
+@click.option(
+    "-w",
+    "--ota-window",
+    type=int,
+    default=OTA_WINDOW_DEFAULT,
+    show_default=True,
+    help="Number of chunks sent before requesting an ACK bitmap (0 to ACK each chunk).",
+)
+@click.argument("firmware", type=click.File(mode="rb"))
+@click.pass_context
+def bench_ota_command(ctx, yes, runs, size, ota_window, firmware):
+    """Measure the duration of flashing a firmware to the ready robots."""
+    ctx.obj["settings"].ota_window = ota_window
+    try:
+        fw = _load_firmware(firmware)
+    except ValueError as exc:
+        print(f"[bold red]Error:[/] {exc}. Exiting.")
+        return
+    if size * 1024 > fw.fw_length:
+        fw = OtaManifest.from_image(
+            bytes(fw.image).ljust(size * 1024, b"\xff")
+        )
+    controller = _controller(ctx)
+    if not controller.ready_devices:
+        print("[bold red]Error:[/] No ready device found. Exiting.")
+        controller.terminate()
+        return
+    print(
+        f"Devices to flash ([bold white]{len(controller.ready_devices)}):[/]"
+    )
+    pprint(controller.ready_devices, expand_all=True)
+    if yes is False:
+        click.confirm("Do you want to continue?", default=True, abort=True)
+    metrics = bench_ota(controller, fw, runs)
+    controller.terminate()
+    print(f"Image size: [bold cyan]{fw.fw_length}B[/]")
+    print_bench_report(metrics, ctx.obj["per_device"])
+
+
 @main.command()
 @click.pass_context
 def status(ctx):
     """Print current status of the robots."""
-    controller = Controller(ctx.obj["settings"])
+    controller = _controller(ctx)
     controller.status()
     controller.terminate()
 
@@ -339,7 +917,7 @@ def status(ctx):
 @click.pass_context
 def message(ctx, message):
     """Send a custom text message to the robots."""
-    controller = Controller(ctx.obj["settings"])
+    controller = _controller(ctx)
     controller.send_message(message)
     controller.terminate()
 
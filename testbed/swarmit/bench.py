@@ -0,0 +1,323 @@
+"""Benchmark scenarios measuring the testbed.
+
+The radio scenarios are run against devices running the bench image
+(sample/Source/bench.c), which answers messages starting with an opcode. The
+OTA scenario flashes any image to the ready devices. Each scenario returns
+metrics whose samples are summarized with percentiles, so regressions of the
+firmware or of the controller show up as numbers.
+"""
+
+import math
+import struct
+import time
+from dataclasses import dataclass, field
+
+from rich import print
+from rich.table import Table
+
+from testbed.swarmit.controller import Controller
+from testbed.swarmit.manifest import OtaManifest
+
+BENCH_PING = 0x01
+BENCH_PONG = 0x02
+BENCH_UPLINK = 0x03
+BENCH_UPLINK_DATA = 0x04
+BENCH_FLOOD = 0x05
+BENCH_PING_FORMAT = "<BI"  # Opcode, sequence number
+BENCH_PONG_FORMAT = "<BIIII"  # Opcode, seq, IPC RTT, flood count and duration
+BENCH_UPLINK_FORMAT = "<BHB"  # Opcode, packets count, packets size
+BENCH_UPLINK_DATA_FORMAT = "<BHI"  # Opcode, seq, previous send duration
+BENCH_FLOOD_FORMAT = "<BI"  # Opcode, sequence number
+BENCH_UPLINK_SIZE_MIN = struct.calcsize(BENCH_UPLINK_DATA_FORMAT)
+BENCH_UPLINK_SIZE_MAX = 200  # Max message content accepted by the bench image
+BENCH_PERCENTILES = (50, 90, 99)
+BENCH_PING_TIMEOUT = 1  # Max time in seconds to wait for the pongs
+BENCH_QUIET_TIME = 2  # Time in seconds without packet ending a burst
+BENCH_FLOOD_SETTLE_TIME = 1  # Time in seconds before reading flood counts
+
+
+def percentile(samples: list[float], point: float) -> float:
+    """Return the nearest rank percentile of the samples."""
+    if not samples:
+        return math.nan
+    ordered = sorted(samples)
+    rank = math.ceil(point / 100 * len(ordered))
+    return ordered[min(max(rank, 1), len(ordered)) - 1]
+
+
+@dataclass
+class BenchMetric:
+    """Samples of a measured quantity, by device."""
+
+    name: str
+    unit: str
+    samples: dict[str, list[float]] = field(default_factory=lambda: {})
+    lost: dict[str, int] = field(default_factory=lambda: {})
+
+    def add(self, device_addr: str, value: float):
+        self.samples.setdefault(device_addr, []).append(value)
+
+    def all_samples(self) -> list[float]:
+        return [value for values in self.samples.values() for value in values]
+
+    def merge(self, other: "BenchMetric"):
+        self.samples.update(other.samples)
+        self.lost.update(other.lost)
+
+
+def merge_metrics(results: list[list[BenchMetric]]) -> list[BenchMetric]:
+    """Merge the metrics measured on several shards, by metric name."""
+    merged: dict[str, BenchMetric] = {}
+    for metrics in results:
+        for metric in metrics:
+            if metric.name not in merged:
+                merged[metric.name] = BenchMetric(metric.name, metric.unit)
+            merged[metric.name].merge(metric)
+    return list(merged.values())
+
+
+def print_bench_report(
+    metrics: list[BenchMetric], per_device: bool = False
+) -> None:
+    """Print the percentiles of the metrics, of each device if requested."""
+    print()
+    print("[bold]Benchmark results:[/]")
+    table = Table()
+    table.add_column("Metric", style="magenta", no_wrap=True)
+    table.add_column("Device Addr", style="magenta", no_wrap=True)
+    table.add_column("Samples", style="green", justify="right")
+    table.add_column("Lost", style="red", justify="right")
+    table.add_column("Min", style="cyan", justify="right")
+    for point in BENCH_PERCENTILES:
+        table.add_column(f"p{point}", style="cyan", justify="right")
+    table.add_column("Max", style="cyan", justify="right")
+
+    def add_row(metric: BenchMetric, device: str, values, lost: int):
+        table.add_row(
+            f"{metric.name} ({metric.unit})",
+            device,
+            f"{len(values)}",
+            f"{lost}",
+            f"{min(values):.2f}" if values else "-",
+            *[
+                f"{percentile(values, point):.2f}" if values else "-"
+                for point in BENCH_PERCENTILES
+            ],
+            f"{max(values):.2f}" if values else "-",
+        )
+
+    for metric in metrics:
+        add_row(metric, "all", metric.all_samples(), sum(metric.lost.values()))
+        if not per_device:
+            continue
+        devices = sorted(set(metric.samples) | set(metric.lost))
+        for device_addr in devices:
+            add_row(
+                metric,
+                device_addr,
+                metric.samples.get(device_addr, []),
+                metric.lost.get(device_addr, 0),
+            )
+    print(table)
+
+
+class Bench:
+    """Run the radio scenarios against the running bench images."""
+
+    def __init__(self, controller: Controller):
+        self.controller = controller
+        self.devices = controller.running_devices
+
+    def _messages(self, opcode: int, fmt: str) -> dict[str, list[tuple]]:
+        """Return the received messages with the given opcode, decoded.
+
+        Each entry is the reception time followed by the decoded fields.
+        """
+        size = struct.calcsize(fmt)
+        messages = {}
+        for device_addr, received in list(
+            self.controller.message_data.items()
+        ):
+            if device_addr not in self.devices:
+                continue
+            for received_at, content in list(received):
+                if len(content) < size or content[0] != opcode:
+                    continue
+                messages.setdefault(device_addr, []).append(
+                    (received_at, *struct.unpack(fmt, content[:size])[1:])
+                )
+        return messages
+
+    def _ping(self, seq: int, timeout: float) -> dict[str, tuple]:
+        """Send a ping and return the pong of each device, by device."""
+
+        def pongs():
+            return {
+                device_addr: pong
+                for device_addr, received in self._messages(
+                    BENCH_PONG, BENCH_PONG_FORMAT
+                ).items()
+                for pong in received
+                if pong[1] == seq
+            }
+
+        self.controller.record_messages()
+        self.controller.send_message(
+            struct.pack(BENCH_PING_FORMAT, BENCH_PING, seq)
+        )
+        self.controller.wait_for_done(
+            timeout, lambda: set(pongs()) >= set(self.devices)
+        )
+        return pongs()
+
+    def _wait_burst(self, complete) -> None:
+        """Wait for a burst of packets, until complete or quiet."""
+        received = None
+        while not complete():
+            self.controller.wait_for_done(BENCH_QUIET_TIME, complete)
+            count = sum(
+                len(messages)
+                for messages in self.controller.message_data.values()
+            )
+            if count == received:
+                return
+            received = count
+
+    def rtt(self, count: int, interval: float) -> list[BenchMetric]:
+        """Measure the ping-pong round trip time.
+
+        The round trip time covers the downlink, the handling of the request
+        by the user image and the uplink, so it is also the command to effect
+        latency. The devices measure the IPC round trip time with the network
+        core before answering.
+        """
+        rtt = BenchMetric("Ping RTT", "ms")
+        ipc_rtt = BenchMetric("IPC RTT", "us")
+        for seq in range(count):
+            sent_at = time.time()
+            pongs = self._ping(seq, BENCH_PING_TIMEOUT)
+            for device_addr in self.devices:
+                if device_addr not in pongs:
+                    rtt.lost[device_addr] = rtt.lost.get(device_addr, 0) + 1
+                    continue
+                received_at, _, ipc_rtt_us, _, _ = pongs[device_addr]
+                rtt.add(device_addr, (received_at - sent_at) * 1000)
+                ipc_rtt.add(device_addr, ipc_rtt_us)
+            time.sleep(max(0.0, interval - (time.time() - sent_at)))
+        return [rtt, ipc_rtt]
+
+    def uplink(self, count: int, size: int) -> list[BenchMetric]:
+        """Measure the rate of packets sent back to back by the devices."""
+        size = min(max(size, BENCH_UPLINK_SIZE_MIN), BENCH_UPLINK_SIZE_MAX)
+        rate = BenchMetric("Uplink rate", "pkt/s")
+        throughput = BenchMetric("Uplink throughput", "kB/s")
+        gap = BenchMetric("Uplink inter-arrival", "ms")
+        send = BenchMetric("Uplink send call", "us")
+
+        def packets():
+            return self._messages(BENCH_UPLINK_DATA, BENCH_UPLINK_DATA_FORMAT)
+
+        def complete():
+            received = packets()
+            return all(
+                len(received.get(device_addr, [])) >= count
+                for device_addr in self.devices
+            )
+
+        self.controller.record_messages()
+        self.controller.send_message(
+            struct.pack(BENCH_UPLINK_FORMAT, BENCH_UPLINK, count, size)
+        )
+        self._wait_burst(complete)
+        received = packets()
+        for device_addr in self.devices:
+            device_packets = sorted(received.get(device_addr, []))
+            seqs = {seq for _, seq, _ in device_packets}
+            rate.lost[device_addr] = count - len(seqs)
+            for previous, current in zip(device_packets, device_packets[1:]):
+                gap.add(device_addr, (current[0] - previous[0]) * 1000)
+            for _, seq, send_us in device_packets:
+                # Packets carry the duration of the previous send call
+                if seq > 0:
+                    send.add(device_addr, send_us)
+            if len(device_packets) < 2:
+                continue
+            duration = device_packets[-1][0] - device_packets[0][0]
+            if duration > 0:
+                packets_rate = (len(device_packets) - 1) / duration
+                rate.add(device_addr, packets_rate)
+                throughput.add(device_addr, packets_rate * size / 1024)
+        return [rate, throughput, gap, send]
+
+    def downlink(self, count: int, interval: float) -> list[BenchMetric]:
+        """Measure the rate of packets received by the user images.
+
+        The devices count the flood packets going through swarmit_ipc_isr,
+        the counts are read back with a ping.
+        """
+        delivery = BenchMetric("Downlink delivery", "%")
+        rate = BenchMetric("Downlink rate", "pkt/s")
+        started_at = time.time()
+        for seq in range(count):
+            sent_at = time.time()
+            self.controller.send_message(
+                struct.pack(BENCH_FLOOD_FORMAT, BENCH_FLOOD, seq)
+            )
+            time.sleep(max(0.0, interval - (time.time() - sent_at)))
+        sent_rate = count / max(time.time() - started_at, 1e-6)
+        time.sleep(BENCH_FLOOD_SETTLE_TIME)
+        pongs = self._ping(count, BENCH_PING_TIMEOUT)
+        for device_addr in self.devices:
+            if device_addr not in pongs:
+                delivery.lost[device_addr] = 1
+                continue
+            _, _, _, flood_count, flood_duration_us = pongs[device_addr]
+            delivery.add(device_addr, flood_count * 100 / count)
+            if flood_count > 1 and flood_duration_us > 0:
+                rate.add(
+                    device_addr, (flood_count - 1) * 1e6 / flood_duration_us
+                )
+        sent = BenchMetric("Downlink sent rate", "pkt/s")
+        sent.add("gateway", sent_rate)
+        return [delivery, rate, sent]
+
+
+def bench_ota(
+    controller, firmware: bytes | OtaManifest, runs: int
+) -> list[BenchMetric]:
+    """Measure the duration and throughput of flashing the ready devices.
+
+    The controller can also be a MultiController, each run flashes all the
+    ready devices at once. Each run starts a new OTA session, so the devices
+    flash the whole image again instead of keeping the image of the previous
+    run.
+    """
+    duration = BenchMetric("OTA duration", "s")
+    throughput = BenchMetric("OTA throughput", "kB/s")
+    # The OTA data of the image is computed once for all the runs
+    if not isinstance(firmware, OtaManifest):
+        firmware = OtaManifest.from_image(firmware)
+    for _ in range(runs):
+        started_at = time.time()
+        start_data = controller.start_ota(firmware, new_session=True)
+        for device_addr in start_data["missed"]:
+            duration.lost[device_addr] = duration.lost.get(device_addr, 0) + 1
+        if not start_data["acked"]:
+            continue
+        if controller.transfer_size() == 0:
+            # A run flashing nothing would only measure the verification,
+            # e.g. with delta updates of the installed image
+            raise RuntimeError("The OTA run has no chunk to send")
+        data = controller.transfer(start_data["acked"])
+        elapsed = time.time() - started_at
+        for device_addr, status in data.items():
+            if not status.success:
+                duration.lost[device_addr] = (
+                    duration.lost.get(device_addr, 0) + 1
+                )
+                continue
+            duration.add(device_addr, elapsed)
+            throughput.add(
+                device_addr, firmware.fw_length / 1024 / elapsed
+            )
+    return [duration, throughput]
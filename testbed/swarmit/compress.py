@@ -0,0 +1,88 @@
+"""LZSS compression of firmware images, decompressed on the fly by devices.
+
+The encoded stream is a sequence of groups of 8 tokens, each group being
+preceded by a flags byte. A set flag bit (LSB first) marks a literal byte, a
+cleared bit marks a 2 bytes back reference: distance - 1 and
+length - MATCH_LENGTH_MIN. The decoder is implemented in
+device/bootloader/Source/lzss.c.
+"""
+
+WINDOW_SIZE = 256
+MATCH_LENGTH_MIN = 3
+MATCH_LENGTH_MAX = MATCH_LENGTH_MIN + 255
+
+
+def _longest_match(
+    data: bytes, pos: int, candidates: dict[bytes, list[int]]
+) -> tuple[int, int]:
+    """Return the length and distance of the longest match found at pos."""
+    best_length = 0
+    best_distance = 0
+    length_max = min(MATCH_LENGTH_MAX, len(data) - pos)
+    if length_max < MATCH_LENGTH_MIN:
+        return best_length, best_distance
+    for start in reversed(candidates.get(data[pos : pos + 3], [])):
+        distance = pos - start
+        if distance > WINDOW_SIZE:
+            break
+        length = 0
+        while (
+            length < length_max
+            and data[start + length] == data[pos + length]
+        ):
+            length += 1
+        if length > best_length:
+            best_length = length
+            best_distance = distance
+            if length == length_max:
+                break
+    return best_length, best_distance
+
+
+def compress(data: bytes) -> bytes:
+    """Compress data, back references can overlap the bytes being encoded."""
+    output = bytearray()
+    candidates: dict[bytes, list[int]] = {}
+    flags_pos = 0
+    tokens = 8
+    pos = 0
+    while pos < len(data):
+        if tokens == 8:
+            flags_pos = len(output)
+            output.append(0)
+            tokens = 0
+        length, distance = _longest_match(data, pos, candidates)
+        if length >= MATCH_LENGTH_MIN:
+            output += bytes([distance - 1, length - MATCH_LENGTH_MIN])
+        else:
+            output[flags_pos] |= 1 << tokens
+            output.append(data[pos])
+            length = 1
+        tokens += 1
+        for idx in range(pos, pos + length):
+            candidates.setdefault(data[idx : idx + 3], []).append(idx)
+        pos += length
+    return bytes(output)
+
+
+def decompress(data: bytes) -> bytes:
+    """Decompress data, reference implementation of the device decoder."""
+    output = bytearray()
+    pos = 0
+    while pos < len(data):
+        flags = data[pos]
+        pos += 1
+        for _ in range(8):
+            if pos >= len(data):
+                break
+            if flags & 0x01:
+                output.append(data[pos])
+                pos += 1
+            else:
+                distance = data[pos] + 1
+                length = data[pos + 1] + MATCH_LENGTH_MIN
+                pos += 2
+                for _ in range(length):
+                    output.append(output[-distance])
+            flags >>= 1
+    return bytes(output)
@@ -1,19 +1,20 @@
 """Module containing the swarmit controller class."""
 
 import dataclasses
+import json
+import os
+import random
+import threading
 import time
 from binascii import hexlify
 from dataclasses import dataclass
 
-from cryptography.hazmat.primitives import hashes
 from dotbot.logger import LOGGER
 from dotbot.protocol import Packet, Payload
 from dotbot.serial_interface import get_default_port
 from rich import print
-from rich.console import Group
 from rich.live import Live
 from rich.table import Table
-from rich.text import Text
 from tqdm import tqdm
 
 from testbed.swarmit.adapter import (
@@ -21,49 +22,173 @@ from testbed.swarmit.adapter import (
     MarilibCloudAdapter,
     MarilibEdgeAdapter,
 )
+from testbed.swarmit.logfmt import render
+from testbed.swarmit.manifest import ChunkTable, OtaManifest
 from testbed.swarmit.protocol import (
+    LOG_FORMAT_FLAG,
+    OTA_CHUNK_BITMAP_SIZE,
+    OTA_PAGE_HASHES_MAX,
+    OTA_PAGE_SIZE,
+    OTA_PAGES_BITMAP_SIZE,
+    PROFILE_APP_ENTRIES,
+    PROFILE_NET_ENTRIES,
+    RECORD_CHUNK_SIZE,
+    RECORD_WINDOW_MAX,
+    ConfigKey,
     DeviceType,
+    MariSchedule,
+    OTACompression,
+    OTAMode,
+    PayloadConfigRequest,
+    PayloadEventNotification,
     PayloadMessage,
+    PayloadMulticastRequest,
+    PayloadOTAChunkBitmapRequest,
     PayloadOTAChunkRequest,
+    PayloadOTAPageHashesRequest,
+    PayloadOTARawChunkRequest,
     PayloadOTAStartRequest,
+    PayloadProfileRequest,
+    PayloadRecordReadRequest,
     PayloadResetRequest,
+    PayloadResetWaypointsRequest,
+    PayloadStartAtRequest,
     PayloadStartRequest,
+    PayloadStatusRequest,
     PayloadStopRequest,
+    PayloadTimeSyncRequest,
+    ProfileCore,
+    ProfileEntry,
     StatusType,
     SwarmitPayloadType,
+    profile_section_name,
     register_parsers,
 )
+from testbed.swarmit.simulator import SimulatorAdapter, SimulatorSettings
+from testbed.swarmit.status import (
+    NodeStatus,
+    StatusStore,
+    StatusView,
+    status_rows,
+)
 
-CHUNK_SIZE = 64
+RADIO_PAYLOAD_MAX_SIZE = 235  # Mari frame without its 20 bytes header
+OTA_CHUNK_HEADER_SIZE = 14  # Payload type, index, size and sha
+OTA_CHUNK_SIZE_MAX = (RADIO_PAYLOAD_MAX_SIZE - OTA_CHUNK_HEADER_SIZE) & ~0x03
+OTA_DEVICE_CHUNK_SIZE_MAX = 192  # Largest chunk size accepted by devices
+MULTICAST_HEADER_SIZE = 3  # Payload type, group and size
+MULTICAST_GROUPS_MAX = 32
+LH2_BASESTATIONS_MAX = 4  # Basestations with a homography stored by devices
+OTA_MULTICAST_CHUNK_SIZE_MAX = (
+    OTA_CHUNK_SIZE_MAX - MULTICAST_HEADER_SIZE
+) & ~0x03
+# Chunk sizes precomputed in the OTA manifests, the OTA starts with the
+# largest one accepted by the devices and smaller ones are negotiated
+OTA_MANIFEST_CHUNK_SIZES = (OTA_DEVICE_CHUNK_SIZE_MAX,)
 COMMAND_TIMEOUT = 6
 COMMAND_MAX_ATTEMPTS = 5
 COMMAND_ATTEMPT_DELAY = 1
+TIME_SYNC_PERIOD = 1  # Max delay in seconds between 2 time synchronizations
+RECORD_WINDOW_TIMEOUT = 5  # Max time in seconds to receive a window of chunks
+PROFILE_TIMEOUT = 3  # Max time in seconds to receive the profile statistics
+CONFIG_ATTEMPTS = 3  # Config requests are not acknowledged
 STATUS_TIMEOUT = 5
+STATUS_REFRESH_PERIOD = 0.25
+STATUS_POLL_PERIOD = 0.5
+STATUS_POLL_QUIET_TIME = 0.5  # Without expected devices, stop once quiet
 OTA_MAX_RETRIES_DEFAULT = 10
-OTA_ACK_TIMEOUT_DEFAULT = 2
+OTA_ACK_TIMEOUT_DEFAULT = 2  # Until the round trip time is measured
+OTA_RTO_MIN = 0.1
+OTA_RTO_MAX = 10
+RTT_ALPHA = 1 / 8
+RTT_BETA = 1 / 4
+OTA_WINDOW_DEFAULT = 0
+OTA_WINDOW_MAX = OTA_CHUNK_BITMAP_SIZE * 8
+OTA_SESSION_SAVE_PERIOD = 5  # Seconds between two saves of an OTA session
+# Shards of a multi controller save their devices to the same session file
+OTA_SESSION_LOCK = threading.Lock()
 SERIAL_PORT_DEFAULT = get_default_port()
 BROADCAST_ADDRESS = 0xFFFFFFFFFFFFFFFF
 
 
-@dataclass
-class NodeStatus:
-    """Class that holds node status."""
+class ChunkSet:
+    """Class that holds a set of chunk indexes, one bit per chunk."""
 
-    device: DeviceType = DeviceType.Unknown
-    status: StatusType = StatusType.Bootloader
-    battery: int = 0
-    pos_x: int = 0
-    pos_y: int = 0
+    def __init__(self, size: int = 0):
+        self.size = size
+        self._bits = bytearray(size // 8 + int(size % 8 != 0))
+        self._count = 0
 
+    def add(self, index: int) -> bool:
+        """Add a chunk, return whether it was not in the set yet."""
+        mask = 1 << (index & 0x07)
+        if self._bits[index >> 3] & mask:
+            return False
+        self._bits[index >> 3] |= mask
+        self._count += 1
+        return True
 
-@dataclass
-class DataChunk:
-    """Class that holds data chunks."""
+    def __contains__(self, index: int) -> bool:
+        return bool(self._bits[index >> 3] & (1 << (index & 0x07)))
 
-    index: int
-    size: int
-    sha: bytes
-    data: bytes
+    def __len__(self) -> int:
+        return self._count
+
+    @property
+    def complete(self) -> bool:
+        return self._count == self.size
+
+    def missing(self) -> list[int]:
+        """Return the indexes of the chunks not in the set."""
+        missing = []
+        for base, bits in enumerate(self._bits):
+            if bits == 0xFF:
+                continue
+            for bit in range(8):
+                index = (base << 3) + bit
+                if index < self.size and not bits & (1 << bit):
+                    missing.append(index)
+        return missing
+
+    @classmethod
+    def intersection(cls, sets: list["ChunkSet"]) -> "ChunkSet":
+        """Return the set of the chunks found in all the sets."""
+        result = cls(sets[0].size if sets else 0)
+        if not sets:
+            return result
+        bits = int.from_bytes(sets[0]._bits, "little")
+        for chunk_set in sets[1:]:
+            bits &= int.from_bytes(chunk_set._bits, "little")
+        result._bits = bytearray(bits.to_bytes(len(result._bits), "little"))
+        result._count = bin(bits).count("1")
+        return result
+
+    @classmethod
+    def union(cls, sets: list["ChunkSet"]) -> "ChunkSet":
+        """Return the set of the chunks found in at least one of the sets."""
+        result = cls(sets[0].size if sets else 0)
+        bits = 0
+        for chunk_set in sets:
+            bits |= int.from_bytes(chunk_set._bits, "little")
+        result._bits = bytearray(bits.to_bytes(len(result._bits), "little"))
+        result._count = bin(bits).count("1")
+        return result
+
+    @classmethod
+    def from_bytes(cls, size: int, data: bytes) -> "ChunkSet":
+        """Return the set of the chunks whose bit is set in the data."""
+        result = cls(size)
+        bits = int.from_bytes(data[: len(result._bits)], "little")
+        bits &= (1 << size) - 1
+        result._bits = bytearray(bits.to_bytes(len(result._bits), "little"))
+        result._count = bin(bits).count("1")
+        return result
+
+    def to_bytes(self) -> bytes:
+        return bytes(self._bits)
+
+    def __repr__(self):
+        return f"ChunkSet({self._count}/{self.size})"
 
 
 @dataclass
@@ -71,30 +196,154 @@ class StartOtaData:
     """Class that holds start ota data."""
 
     chunks: int = 0
+    chunk_size: int = OTA_CHUNK_SIZE_MAX
+    compressed_size: int = 0
+    pages_bitmap: bytes = b""  # empty when delta is disabled
+    unchanged_chunks: list[int] = dataclasses.field(
+        default_factory=lambda: []
+    )
     fw_hash: bytes = b""
+    session_id: int = 0  # not zero to flash the image again from scratch
     addrs: list[str] = dataclasses.field(default_factory=lambda: [])
     retries: int = 0
+    device_chunk_size: int = OTA_CHUNK_SIZE_MAX
+    # Chunks already written by the devices resuming a previous transfer
+    written: dict[str, int] = dataclasses.field(default_factory=lambda: {})
+    resumed: dict[str, ChunkSet] = dataclasses.field(
+        default_factory=lambda: {}
+    )
 
 
 @dataclass
-class Chunk:
-    """Class that holds chunk status."""
+class OtaSession:
+    """Class that holds the progress of a transfer, saved to resume it.
+
+    The chunks acked by each device not flashed yet are saved, they are only
+    restored for the same image, chunk size and compression.
+    """
+
+    fw_hash: str = ""
+    chunk_size: int = 0
+    compressed: bool = False
+    acked: dict[str, str] = dataclasses.field(
+        default_factory=lambda: {}
+    )  # bitmap of the acked chunks in hex, by device
+
+    @classmethod
+    def load(cls, path: str) -> "OtaSession":
+        """Return the session saved in a file, an empty one if unreadable."""
+        try:
+            with open(path) as session_file:
+                return cls(**json.load(session_file))
+        except (OSError, TypeError, ValueError):
+            return cls()
+
+    def save(self, path: str):
+        # An interrupted save leaves the previous session untouched
+        with open(f"{path}.tmp", "w") as session_file:
+            json.dump(dataclasses.asdict(self), session_file)
+        os.replace(f"{path}.tmp", path)
 
-    index: str = "0"
-    size: str = "0B"
-    acked: int = 0
-    retries: int = 0
 
-    def __repr__(self):
-        return f"{dataclasses.asdict(self)}"
+@dataclass
+class RttEstimator:
+    """Class that holds the round trip time estimation of a device.
+
+    The retransmission timeout is computed as in TCP (RFC 6298).
+    """
+
+    srtt: float = 0.0
+    rttvar: float = 0.0
+    rto: float = OTA_ACK_TIMEOUT_DEFAULT
+    rtt_min: float = 0.0
+    rtt_max: float = 0.0
+    samples: int = 0
+
+    def update(self, rtt: float):
+        """Update the estimation with a new round trip time sample."""
+        if self.samples == 0:
+            self.srtt = rtt
+            self.rttvar = rtt / 2
+            self.rtt_min = rtt
+            self.rtt_max = rtt
+        else:
+            self.rttvar = (1 - RTT_BETA) * self.rttvar + RTT_BETA * abs(
+                self.srtt - rtt
+            )
+            self.srtt = (1 - RTT_ALPHA) * self.srtt + RTT_ALPHA * rtt
+            self.rtt_min = min(self.rtt_min, rtt)
+            self.rtt_max = max(self.rtt_max, rtt)
+        self.samples += 1
+        self.rto = min(
+            max(self.srtt + 4 * self.rttvar, OTA_RTO_MIN), OTA_RTO_MAX
+        )
+
+    def backoff(self):
+        """Double the timeout after a timeout expired."""
+        self.rto = min(self.rto * 2, OTA_RTO_MAX)
 
 
 @dataclass
 class TransferDataStatus:
     """Class that holds transfer data status for a single device."""
 
-    chunks: list[Chunk] = dataclasses.field(default_factory=lambda: [])
+    acked: ChunkSet = dataclasses.field(default_factory=ChunkSet)
+    retries: int = 0  # chunks sent again to the device
+    verified: bool = False
     success: bool = False
+    rtt: RttEstimator = dataclasses.field(default_factory=RttEstimator)
+
+
+@dataclass
+class RecordDownload:
+    """Class that holds the data recorded by a device, as it is read back."""
+
+    total: int | None = None  # unknown until a first chunk is received
+    chunks: dict[int, bytes] = dataclasses.field(default_factory=lambda: {})
+    retries: int = 0  # consecutive windows without any new chunk
+
+    def missing(self) -> list[int]:
+        """Return the offsets of the chunks not received yet."""
+        if self.total is None:
+            return [0]
+        return [
+            offset
+            for offset in range(0, self.total, RECORD_CHUNK_SIZE)
+            if offset not in self.chunks
+        ]
+
+    @property
+    def complete(self) -> bool:
+        """Return whether all the recorded data was received."""
+        return not self.missing()
+
+    @property
+    def data(self) -> bytes:
+        """Return the received data, up to the first missing chunk."""
+        data = bytearray()
+        while len(data) in self.chunks:
+            data += self.chunks[len(data)]
+        return bytes(data)
+
+
+@dataclass
+class DeviceProfile:
+    """Class that holds the profile statistics of both cores of a device."""
+
+    cpu_mhz: dict[ProfileCore, int] = dataclasses.field(
+        default_factory=lambda: {}
+    )
+    entries: dict[ProfileCore, dict[int, ProfileEntry]] = dataclasses.field(
+        default_factory=lambda: {ProfileCore.App: {}, ProfileCore.Net: {}}
+    )
+
+    @property
+    def complete(self) -> bool:
+        """Return whether the entries of both cores were received."""
+        return (
+            len(self.entries[ProfileCore.App]) >= PROFILE_APP_ENTRIES
+            and len(self.entries[ProfileCore.Net]) >= PROFILE_NET_ENTRIES
+        )
 
 
 @dataclass
@@ -113,63 +362,6 @@ def addr_to_hex(addr: int) -> str:
     return hexlify(addr.to_bytes(8, "big")).decode().upper()
 
 
-def battery_level_color(level: int):
-    if level > 85:
-        return "green"
-    elif level > 65:
-        return "dark_orange"
-    else:
-        return "red"
-
-
-def generate_status(status_data, devices=[], status_message="found"):
-    data = {
-        addr: device_data
-        for addr, device_data in status_data.items()
-        if (devices and addr in devices) or (not devices)
-    }
-    if not data:
-        return Group(Text(f"\nNo device {status_message}\n"))
-
-    header = Text(
-        f"\n{len(data)} device{'s' if len(data) > 1 else ''} {status_message}\n"
-    )
-
-    table = Table()
-    table.add_column("Device Addr", style="magenta", no_wrap=True)
-    table.add_column(
-        "Type",
-        style="cyan",
-        justify="center",
-    )
-    table.add_column(
-        "Battery",
-        style="cyan",
-        justify="right",
-    )
-    table.add_column(
-        "Position",
-        style="cyan",
-        justify="right",
-    )
-    table.add_column(
-        "Status",
-        style="green",
-        justify="center",
-        width=max([len(m) for m in StatusType.__members__]),
-    )
-    for device_addr, device_data in sorted(data.items()):
-
-        table.add_row(
-            f"{device_addr}",
-            f"{device_data.device.name}",
-            f"[{battery_level_color(device_data.battery)}]{device_data.battery:>3}%",
-            f"({(device_data.pos_x / 1e6):.2f}, {(device_data.pos_y / 1e6):.2f})",
-            f"{'[bold cyan]' if device_data.status == StatusType.Running else '[bold green]'}{device_data.status.name}",
-        )
-    return Group(header, table)
-
-
 def print_transfer_status(
     status: dict[str, TransferDataStatus], start_data: int
 ) -> None:
@@ -183,6 +375,14 @@ def print_transfer_status(
     transfer_status_table.add_column(
         "Chunks acked", style="green", justify="center"
     )
+    transfer_status_table.add_column(
+        "Image verified", style="green", justify="center"
+    )
+    transfer_status_table.add_column("RTT", style="cyan", justify="right")
+    transfer_status_table.add_column(
+        "RTT min/max", style="cyan", justify="right"
+    )
+    transfer_status_table.add_column("RTO", style="cyan", justify="right")
 
     with Live(transfer_status_table, refresh_per_second=4) as live:
         live.update(transfer_status_table)
@@ -190,18 +390,56 @@ def print_transfer_status(
             chunks_col_color = "[green]" if status.success else "[bold red]"
             transfer_status_table.add_row(
                 f"{device_addr}",
-                f"{chunks_col_color}{len([chunk for chunk in status.chunks if bool(chunk.acked)])}/{start_data.chunks}",
+                f"{chunks_col_color}{len(status.acked)}/{status.acked.size}",
+                "[green]yes" if status.verified else "[bold red]no",
+                (
+                    f"{status.rtt.srtt * 1000:.0f}"
+                    f" ± {status.rtt.rttvar * 1000:.0f}ms"
+                    if status.rtt.samples
+                    else "-"
+                ),
+                (
+                    f"{status.rtt.rtt_min * 1000:.0f}"
+                    f"/{status.rtt.rtt_max * 1000:.0f}ms"
+                    if status.rtt.samples
+                    else "-"
+                ),
+                f"{status.rtt.rto * 1000:.0f}ms",
             )
 
 
-def wait_for_done(timeout, condition_func):
-    """Wait for the condition to be met."""
-    while timeout > 0:
-        if condition_func():
-            return True
-        timeout -= 0.01
-        time.sleep(0.01)
-    return False
+def print_profile(profiles: dict[str, DeviceProfile]) -> None:
+    """Print the profiled sections that ran at least once, by device."""
+    print()
+    print("[bold]Profile statistics:[/]")
+    table = Table()
+    table.add_column("Device Addr", style="magenta", no_wrap=True)
+    table.add_column("Core", style="magenta")
+    table.add_column("Section", style="magenta", no_wrap=True)
+    table.add_column("Count", style="green", justify="right")
+    table.add_column("Min (us)", style="cyan", justify="right")
+    table.add_column("Avg (us)", style="cyan", justify="right")
+    table.add_column("Max (us)", style="cyan", justify="right")
+    table.add_column("Total (ms)", style="cyan", justify="right")
+    for device_addr, profile in sorted(profiles.items()):
+        if not profile.complete:
+            table.add_row(f"{device_addr}", "", "[bold red]incomplete")
+        for core, entries in profile.entries.items():
+            cpu_mhz = profile.cpu_mhz.get(core) or 1
+            for index, entry in sorted(entries.items()):
+                if not entry.count:
+                    continue
+                table.add_row(
+                    f"{device_addr}",
+                    core.name,
+                    profile_section_name(core, index),
+                    f"{entry.count}",
+                    f"{entry.min / cpu_mhz:.1f}",
+                    f"{entry.total / entry.count / cpu_mhz:.1f}",
+                    f"{entry.max / cpu_mhz:.1f}",
+                    f"{entry.total / cpu_mhz / 1000:.2f}",
+                )
+    print(table)
 
 
 @dataclass
@@ -215,9 +453,21 @@ class ControllerSettings:
     mqtt_use_tls: bool = False
     network_id: int = 1
     adapter: str = "serial"  # or "mqtt", "marilib-edge", "marilib-cloud"
+    sim_devices: int = 100  # devices simulated by the "sim" adapter
+    sim_loss: float = 0.0  # probability that a simulated frame is lost
     devices: list[str] = dataclasses.field(default_factory=lambda: [])
+    group: int | None = None  # multicast group gathering all the devices
+    live_status: bool = True  # disabled when the caller displays the status
     ota_max_retries: int = OTA_MAX_RETRIES_DEFAULT
     ota_timeout: float = OTA_ACK_TIMEOUT_DEFAULT
+    ota_window: int = OTA_WINDOW_DEFAULT  # 0 means stop-and-wait
+    ota_compress: bool = False
+    ota_delta: bool = False
+    ota_chunk_hash: bool = False  # the whole image hash is always verified
+    ota_session: str | None = None  # file saving the progress of transfers
+    log_formats: dict[int, str] = dataclasses.field(
+        default_factory=lambda: {}
+    )  # format strings of the formatted log entries
     verbose: bool = False
 
 
@@ -228,15 +478,44 @@ class Controller:
         self.logger = LOGGER.bind(context=__name__)
         self.settings = settings
         self._interface: GatewayAdapterBase = None
-        self.status_data: dict[str, NodeStatus] = {}
+        self.status_data = StatusStore()
         self.started_data: list[str] = []
         self.stopped_data: list[str] = []
-        self.chunks: list[DataChunk] = []
+        self.manifest: OtaManifest | None = None
+        self.chunk_table: ChunkTable | None = None
         self.start_ota_data: StartOtaData = StartOtaData()
         self.transfer_data: dict[str, TransferDataStatus] = {}
-        self._known_devices: dict[str, StatusType] = {}
+        self.bitmap_data: dict[int, set[str]] = {}
+        self.page_hashes: dict[str, dict[int, bytes]] = {}
+        self.verify_data: dict[str, bool] = {}
+        self.record_data: dict[str, RecordDownload] = {}
+        self.profile_data: dict[str, DeviceProfile] = {}
+        # Messages sent by the user images, with their reception time, only
+        # kept while recording
+        self.message_data: dict[str, list[tuple[float, bytes]]] = {}
+        self.messages_recorded = False
+        self._known_devices = StatusStore()
+        # Notified each time a frame was handled, guards the received data
+        self._condition = threading.Condition()
+        self._status_answers: set[str] = set()
+        self._pending_start_acks: set[str] = set()
+        # Devices expected to ack the chunk sent in stop-and-wait mode
+        self._pending_chunk_acks: dict[int, set[str]] = {}
+        # Send time of the requests whose answer gives an RTT sample, by
+        # destination and chunk index or ("bitmap", base index)
+        self._sent_at: dict[tuple[str, object], float] = {}
+        self._session_saved_at = 0.0
         register_parsers()
-        if self.settings.adapter == "cloud":
+        if self.settings.adapter == "sim":
+            self._interface = SimulatorAdapter(
+                SimulatorSettings(
+                    devices=self.settings.sim_devices,
+                    network_id=self.settings.network_id,
+                    loss=self.settings.sim_loss,
+                ),
+                verbose=self.settings.verbose,
+            )
+        elif self.settings.adapter == "cloud":
             self._interface = MarilibCloudAdapter(
                 self.settings.mqtt_host,
                 self.settings.mqtt_port,
@@ -253,59 +532,39 @@ class Controller:
         self._interface.init(self.on_frame_received)
 
     @property
-    def known_devices(self) -> dict[str, StatusType]:
+    def known_devices(self) -> StatusStore:
         """Return the known devices."""
         if not self._known_devices:
-            wait_for_done(COMMAND_TIMEOUT, lambda: False)
+            self.poll_status()
             self._known_devices = self.status_data
         return self._known_devices
 
+    def _devices_in(self, *statuses: StatusType) -> list[str]:
+        """Return the selected devices in one of the states."""
+        devices = self.known_devices.devices(*statuses)
+        if self.settings.devices:
+            devices.intersection_update(self.settings.devices)
+        return sorted(devices)
+
     @property
     def running_devices(self) -> list[str]:
         """Return the running devices."""
-        return [
-            addr
-            for addr, node in self.known_devices.items()
-            if (
-                (
-                    node.status == StatusType.Running
-                    or node.status == StatusType.Programming
-                )
-                and (
-                    not self.settings.devices or addr in self.settings.devices
-                )
-            )
-        ]
+        return self._devices_in(StatusType.Running, StatusType.Programming)
 
     @property
     def resetting_devices(self) -> list[str]:
         """Return the resetting devices."""
-        return [
-            device_addr
-            for device_addr, node in self.known_devices.items()
-            if (
-                node.status == StatusType.Resetting
-                and (
-                    not self.settings.devices
-                    or device_addr in self.settings.devices
-                )
-            )
-        ]
+        return self._devices_in(StatusType.Resetting)
 
     @property
     def ready_devices(self) -> list[str]:
         """Return the ready devices."""
-        return [
-            device_addr
-            for device_addr, node in self.known_devices.items()
-            if (
-                node.status == StatusType.Bootloader
-                and (
-                    not self.settings.devices
-                    or device_addr in self.settings.devices
-                )
-            )
-        ]
+        return self._devices_in(StatusType.Bootloader)
+
+    @property
+    def ota_devices(self) -> list[str]:
+        """Return the devices to flash, including those left programming."""
+        return self._devices_in(StatusType.Bootloader, StatusType.Programming)
 
     @property
     def interface(self) -> GatewayAdapterBase:
@@ -316,12 +575,50 @@ class Controller:
         """Terminate the controller."""
         self.interface.close()
 
-    def send_payload(self, destination: int, payload: Payload):
-        """Send a frame to the devices."""
+    @property
+    def broadcast(self) -> bool:
+        """Return whether commands are sent once to all the devices.
+
+        This is the case when no device is selected, or when the selected
+        devices are the members of a multicast group.
+        """
+        return not self.settings.devices or self.settings.group is not None
+
+    def send_payload(
+        self, destination: int, payload: Payload, multicast: bool = True
+    ):
+        """Send a frame to the devices.
+
+        Broadcast frames are wrapped in a multicast request when a group is
+        set, unless multicast is disabled.
+        """
+        if (
+            destination == BROADCAST_ADDRESS
+            and multicast
+            and self.settings.group is not None
+        ):
+            packet = Packet.from_payload(payload).to_bytes()
+            payload = PayloadMulticastRequest(
+                group=self.settings.group, count=len(packet), packet=packet
+            )
         self.interface.send_payload(destination, payload)
 
+    def wait_for_done(self, timeout: float, condition_func) -> bool:
+        """Wait for the condition to be met.
+
+        The condition is only evaluated when a frame was received, with the
+        received data locked.
+        """
+        with self._condition:
+            return self._condition.wait_for(condition_func, timeout)
+
     def on_frame_received(self, header, packet: Packet):
-        """Handle the received frame."""
+        """Handle the received frame and wake up the waiting commands."""
+        with self._condition:
+            self._handle_frame(header, packet)
+            self._condition.notify_all()
+
+    def _handle_frame(self, header, packet: Packet):
         # if self.settings.verbose:
         #     print()
         #     print(Frame(header, packet))
@@ -338,8 +635,21 @@ class Controller:
                 battery=packet.payload.battery,
                 pos_x=packet.payload.pos_x,
                 pos_y=packet.payload.pos_y,
+                duty_cycle=packet.payload.duty_cycle,
+                boot_time=packet.payload.boot_time,
+                last_seen=time.time(),
             )
-            self.status_data.update({device_addr: status})
+            if device_addr in self.status_data:
+                status.link = self.status_data[device_addr].link
+            self.status_data[device_addr] = status
+            self._status_answers.add(device_addr)
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_LINK_STATS
+        ):
+            # Link statistics always follow a status notification
+            if device_addr in self.status_data:
+                self.status_data.set_link(device_addr, packet.payload)
         elif (
             packet.payload_type
             == SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_START_ACK
@@ -347,120 +657,386 @@ class Controller:
             if device_addr in self.start_ota_data.addrs:
                 return
             self.start_ota_data.addrs.append(device_addr)
+            self._pending_start_acks.discard(device_addr)
+            self.start_ota_data.device_chunk_size = min(
+                self.start_ota_data.device_chunk_size,
+                packet.payload.chunk_size,
+            )
+            self.start_ota_data.written[device_addr] = packet.payload.written
         elif (
             packet.payload_type
             == SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_CHUNK_ACK
         ):
-            try:
-                acked = bool(
-                    self.transfer_data[device_addr]
-                    .chunks[packet.payload.index]
-                    .acked
-                )
-            except (IndexError, KeyError):
+            status = self.transfer_data.get(device_addr)
+            index = packet.payload.index
+            if status is None or index >= status.acked.size:
                 self.logger.warning(
                     "Chunk index out of range",
                     device_addr=device_addr,
-                    chunk_index=packet.payload.index,
+                    chunk_index=index,
+                )
+                return
+            if status.acked.add(index):
+                self._pending_chunk_acks.get(index, set()).discard(
+                    device_addr
                 )
+                self._sample_rtt(device_addr, index)
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_CHUNK_BITMAP
+        ):
+            if device_addr not in self.transfer_data:
                 return
-            if acked is False:
-                self.transfer_data[device_addr].chunks[
-                    packet.payload.index
-                ].acked = 1
-        elif packet.payload_type in [
-            SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_GPIO,
-            SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG,
-        ]:
+            if device_addr not in self.bitmap_data.get(
+                packet.payload.index, set()
+            ):
+                self._sample_rtt(device_addr, ("bitmap", packet.payload.index))
+            acked = self.transfer_data[device_addr].acked
+            for index in packet.payload.chunks():
+                if index < acked.size and acked.add(index):
+                    self._pending_chunk_acks.get(index, set()).discard(
+                        device_addr
+                    )
+            self.bitmap_data.setdefault(packet.payload.index, set()).add(
+                device_addr
+            )
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_PAGE_HASHES
+        ):
+            self.page_hashes.setdefault(device_addr, {}).update(
+                packet.payload.page_hashes()
+            )
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_VERIFY
+        ):
+            self.verify_data[device_addr] = bool(packet.payload.valid)
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_RECORD_DATA
+        ):
+            download = self.record_data.get(device_addr)
+            if download is None:
+                return
+            download.total = packet.payload.total
+            if packet.payload.size:
+                download.chunks[packet.payload.offset] = bytes(
+                    packet.payload.data
+                )
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_PROFILE
+        ):
+            profile = self.profile_data.get(device_addr)
+            if profile is None:
+                return
+            core = ProfileCore(packet.payload.core)
+            profile.cpu_mhz[core] = packet.payload.cpu_mhz
+            profile.entries[core].update(packet.payload.entries())
+        elif packet.payload_type == SwarmitPayloadType.SWARMIT_MESSAGE:
+            if not self.messages_recorded:
+                return
+            self.message_data.setdefault(device_addr, []).append(
+                (time.time(), bytes(packet.payload.message))
+            )
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG
+        ):
             if (
                 self.settings.devices
                 and device_addr not in self.settings.devices
             ):
                 return
-            logger = self.logger.bind(
+            self.logger.bind(
                 device_addr=device_addr,
                 notification=SwarmitPayloadType(packet.payload_type).name,
                 timestamp=packet.payload.timestamp,
+                time=self.network_time(packet.payload.timestamp),
                 data_size=packet.payload.count,
                 data=packet.payload.data,
-            )
+            ).info("LOG event")
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_GPIO
+        ):
             if (
-                packet.payload_type
-                == SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_GPIO
+                self.settings.devices
+                and device_addr not in self.settings.devices
             ):
-                logger.info("GPIO event")
-            elif (
-                packet.payload_type
-                == SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG
+                return
+            for event in packet.payload.events():
+                self.logger.bind(
+                    device_addr=device_addr,
+                    notification=SwarmitPayloadType(packet.payload_type).name,
+                    timestamp=event.timestamp,
+                    time=self.network_time(event.timestamp),
+                    port=event.port,
+                    pin=event.pin,
+                    value=event.value,
+                ).info("GPIO event")
+        elif (
+            packet.payload_type
+            == SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG_BATCH
+        ):
+            if (
+                self.settings.devices
+                and device_addr not in self.settings.devices
             ):
-                logger.info("LOG event")
+                return
+            # Batched entries are logged like individual log events
+            for event in packet.payload.events():
+                self._log_event(device_addr, event)
         else:
             self.logger.error(
                 "Unknown payload type", payload_type=packet.payload_type
             )
 
+    def _sample_rtt(self, device_addr: str, key):
+        """Update the RTT estimation of a device with an answer to key."""
+        sent_at = self._sent_at.get((device_addr, key))
+        if sent_at is None:
+            sent_at = self._sent_at.get(
+                (addr_to_hex(BROADCAST_ADDRESS), key)
+            )
+        if sent_at is None:
+            return
+        self.transfer_data[device_addr].rtt.update(time.time() - sent_at)
+
+    def _mark_sent(self, device_addr: str, key, retransmission: bool):
+        """Record the send time of a request, used for RTT samples.
+
+        Answers to retransmitted requests are ambiguous and not sampled
+        (Karn's algorithm).
+        """
+        with self._condition:
+            if retransmission:
+                self._sent_at.pop((device_addr, key), None)
+            else:
+                self._sent_at[(device_addr, key)] = time.time()
+
+    def _rto(self, devices) -> float:
+        """Return the retransmission timeout covering the given devices."""
+        with self._condition:
+            return max(
+                (
+                    self.transfer_data[addr].rtt.rto
+                    for addr in devices
+                    if addr in self.transfer_data
+                ),
+                default=self.settings.ota_timeout,
+            )
+
+    def _backoff(self, devices):
+        """Back off the timeout of the devices that did not answer."""
+        with self._condition:
+            for addr in devices:
+                if addr in self.transfer_data:
+                    self.transfer_data[addr].rtt.backoff()
+
+    @staticmethod
+    def network_time(timestamp: int) -> float:
+        """Return the network time of the 32-bit timestamp of an event.
+
+        Timestamps are the low 32 bits of the network time in microseconds,
+        they are unwrapped to the closest time in the past.
+        """
+        now = int(time.time() * 1e6)
+        return (now - ((now - timestamp) & 0xFFFFFFFF)) / 1e6
+
+    def _log_event(self, device_addr: str, event: PayloadEventNotification):
+        """Log an entry of a batch, formatted entries are rendered."""
+        logger = self.logger.bind(
+            device_addr=device_addr,
+            notification=SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG.name,
+            timestamp=event.timestamp,
+            time=self.network_time(event.timestamp),
+            data_size=event.count & ~LOG_FORMAT_FLAG,
+            data=event.data,
+        )
+        if event.count & LOG_FORMAT_FLAG:
+            logger = logger.bind(
+                message=render(self.settings.log_formats, event.data)
+            )
+        logger.info("LOG event")
+
+    def _send_status_request(self, devices: list[str]):
+        payload = PayloadStatusRequest()
+        if not devices:
+            self.send_payload(BROADCAST_ADDRESS, payload)
+            return
+        for device_addr in devices:
+            self.send_payload(int(device_addr, 16), payload)
+
+    def poll_status(self, timeout=COMMAND_TIMEOUT) -> StatusStore:
+        """Poll the status of the devices.
+
+        Return as soon as all the configured devices answered or, when no
+        device is configured, once no new device answered for a while.
+        """
+        expected = set(self.settings.devices)
+        start = time.time()
+        deadline = start + timeout
+        with self._condition:
+            self._status_answers = set()
+            answers = 0
+            last_answer = start
+            next_poll = start
+            while (now := time.time()) < deadline:
+                if expected and expected <= self._status_answers:
+                    break
+                if len(self._status_answers) != answers:
+                    answers = len(self._status_answers)
+                    last_answer = now
+                elif (
+                    not expected
+                    and answers
+                    and now - last_answer >= STATUS_POLL_QUIET_TIME
+                ):
+                    break
+                if now >= next_poll:
+                    self._send_status_request(
+                        sorted(expected - self._status_answers)
+                    )
+                    next_poll = now + STATUS_POLL_PERIOD
+                wake_time = min(next_poll, deadline)
+                if not expected and answers:
+                    wake_time = min(
+                        wake_time, last_answer + STATUS_POLL_QUIET_TIME
+                    )
+                # Woken up by the received frames
+                self._condition.wait(wake_time - now)
+        return self.status_data
+
+    def status_snapshot(self) -> StatusStore:
+        """Return a copy of the status of the devices."""
+        with self._condition:
+            return self.status_data.copy()
+
     def _live_status(
-        self, devices=[], timeout=STATUS_TIMEOUT, message="found"
+        self,
+        devices=[],
+        timeout=STATUS_TIMEOUT,
+        message="found",
+        condition_func=lambda: False,
     ):
         """Request the live status of the testbed."""
+        if not self.settings.live_status:
+            self.wait_for_done(timeout, condition_func)
+            return
+        deadline = time.time() + timeout
+        view = StatusView(devices, status_message=message)
         with Live(
-            generate_status(self.status_data, devices, status_message=message),
+            view.render(self.status_snapshot(), status_rows()),
             refresh_per_second=4,
         ) as live:
-            while timeout > 0:
-                live.update(
-                    generate_status(
-                        self.status_data, devices, status_message=message
-                    )
-                )
-                timeout -= 0.01
-                time.sleep(0.01)
+            while time.time() < deadline and not self.wait_for_done(
+                min(STATUS_REFRESH_PERIOD, deadline - time.time()),
+                condition_func,
+            ):
+                live.update(view.render(self.status_snapshot(), status_rows()))
+            # The final table is left on the terminal, with all the rows
+            live.update(view.render(self.status_snapshot()))
 
     def status(self):
         """Request the status of the testbed."""
-        self._live_status(self.settings.devices)
+        self.poll_status()
+        self._live_status(self.settings.devices, timeout=0)
 
     def _send_start(self, device_addr: str):
         payload = PayloadStartRequest()
         self.send_payload(int(device_addr, 16), payload)
 
-    def start(self):
-        """Start the application."""
+    def sync_time(self):
+        """Broadcast the time to synchronize the network time of devices.
+
+        The devices receiving the same broadcast are synchronized together
+        within microseconds, they are all offset by the latency to the
+        gateway.
+        """
+        payload = PayloadTimeSyncRequest(time_us=int(time.time() * 1e6))
+        self.send_payload(BROADCAST_ADDRESS, payload)
+
+    def _send_start_at(self, device_addr: str, start_at: float):
+        # Retries carry the remaining delay and the same ID
+        delay = max(0.0, start_at - time.time())
+        payload = PayloadStartAtRequest(
+            id=int(start_at * 1000) & 0xFF, delay_us=int(delay * 1e6)
+        )
+        self.send_payload(int(device_addr, 16), payload)
+
+    def start(self, start_at: float | None = None):
+        """Start the application.
+
+        If start_at is given, as a time.time() value, the devices start
+        together at that time instead of when they receive the request.
+        Devices receiving the same broadcast start within microseconds.
+        """
         ready_devices = self.ready_devices
+        ready = set(ready_devices)
+        # Logs of the experiment are timestamped with the network time
+        self.sync_time()
+
+        def all_started():
+            # Evaluated for each received frame
+            return self.status_data.all_in(ready, StatusType.Running)
+
+        def send_start(device_addr: str):
+            if start_at is None:
+                self._send_start(device_addr)
+            else:
+                self._send_start_at(device_addr, start_at)
+
         attempts = 0
-        while attempts < COMMAND_MAX_ATTEMPTS and not all(
-            self.status_data[addr].status == StatusType.Running
-            for addr in ready_devices
-        ):
-            if not self.settings.devices:
-                self._send_start(addr_to_hex(BROADCAST_ADDRESS))
+        while attempts < COMMAND_MAX_ATTEMPTS and not all_started():
+            if self.broadcast:
+                send_start(addr_to_hex(BROADCAST_ADDRESS))
             else:
                 for device_addr in self.settings.devices:
-                    if device_addr not in ready_devices:
+                    if device_addr not in ready:
                         continue
-                    self._send_start(device_addr)
+                    send_start(device_addr)
             attempts += 1
-            time.sleep(COMMAND_ATTEMPT_DELAY)
+            self.wait_for_done(COMMAND_ATTEMPT_DELAY, all_started)
+        delay = max(0.0, start_at - time.time()) if start_at else 0.0
         self._live_status(
-            ready_devices, timeout=COMMAND_TIMEOUT, message="to start"
+            ready_devices,
+            timeout=COMMAND_TIMEOUT + delay,
+            message="to start",
+            condition_func=all_started,
         )
 
     def stop(self):
-        """Stop the application."""
+        """Stop the application.
+
+        Ready devices receive a single stop request, which cancels their
+        scheduled start if any.
+        """
+        if self.broadcast:
+            self.send_payload(BROADCAST_ADDRESS, PayloadStopRequest())
+        else:
+            for device_addr in self.ready_devices:
+                self.send_payload(int(device_addr, 16), PayloadStopRequest())
+
         stoppable_devices = self.running_devices + self.resetting_devices
+        if not stoppable_devices:
+            return
+        stoppable = set(stoppable_devices)
+
+        def all_stopped():
+            return self.status_data.all_in(
+                stoppable, StatusType.Stopping, StatusType.Bootloader
+            )
 
         attempts = 0
-        while attempts < COMMAND_MAX_ATTEMPTS and not all(
-            self.status_data[addr].status
-            in [StatusType.Stopping, StatusType.Bootloader]
-            for addr in stoppable_devices
-        ):
-            if not self.settings.devices:
+        while attempts < COMMAND_MAX_ATTEMPTS and not all_stopped():
+            if self.broadcast:
                 self.send_payload(BROADCAST_ADDRESS, PayloadStopRequest())
             else:
                 for device_addr in self.settings.devices:
                     if (
-                        device_addr not in stoppable_devices
+                        device_addr not in stoppable
                         or self.status_data[device_addr].status
                         in [StatusType.Stopping, StatusType.Bootloader]
                     ):
@@ -469,9 +1045,12 @@ class Controller:
                         int(device_addr, 16), PayloadStopRequest()
                     )
             attempts += 1
-            time.sleep(COMMAND_ATTEMPT_DELAY)
+            self.wait_for_done(COMMAND_ATTEMPT_DELAY, all_stopped)
         self._live_status(
-            stoppable_devices, timeout=COMMAND_TIMEOUT, message="to stop"
+            stoppable_devices,
+            timeout=COMMAND_TIMEOUT,
+            message="to stop",
+            condition_func=all_stopped,
         )
 
     def _send_reset(self, device_addr: int, location: ResetLocation):
@@ -483,7 +1062,7 @@ class Controller:
 
     def reset(self, locations: dict[str, ResetLocation]):
         """Reset the application."""
-        ready_devices = self.ready_devices
+        ready_devices = set(self.ready_devices)
         for device_addr in self.settings.devices:
             if device_addr not in ready_devices:
                 continue
@@ -492,23 +1071,166 @@ class Controller:
             )
             self._send_reset(int(device_addr, 16), locations[device_addr])
 
+    def _send_reset_waypoints(
+        self, device_addr: int, waypoints: list[ResetLocation]
+    ):
+        payload = PayloadResetWaypointsRequest(
+            count=len(waypoints),
+            size=len(waypoints) * 8,
+            waypoints=b"".join(
+                waypoint.pos_x.to_bytes(4, "little")
+                + waypoint.pos_y.to_bytes(4, "little")
+                for waypoint in waypoints
+            ),
+        )
+        self.send_payload(device_addr, payload)
+
+    def reset_waypoints(self, plan: dict[str, list[ResetLocation]]):
+        """Reset the application, each device following its waypoints."""
+        ready_devices = set(self.ready_devices)
+        for device_addr, waypoints in sorted(plan.items()):
+            if device_addr not in ready_devices:
+                continue
+            print(
+                f"Resetting device {device_addr} to location {waypoints[-1]} "
+                f"through {len(waypoints) - 1} waypoints"
+            )
+            self._send_reset_waypoints(int(device_addr, 16), waypoints)
+
+    def _record_window(self, device_addr: str) -> tuple[int, int] | None:
+        """Return the offset and number of chunks to request to a device."""
+        download = self.record_data[device_addr]
+        missing = download.missing()
+        if not missing or download.retries > self.settings.ota_max_retries:
+            return None
+        if download.total is None:
+            # The device only sends the chunks below the recorded size
+            return 0, RECORD_WINDOW_MAX
+        count = (missing[-1] - missing[0]) // RECORD_CHUNK_SIZE + 1
+        return missing[0], min(count, RECORD_WINDOW_MAX)
+
+    def _record_window_received(
+        self, device_addr: str, window: tuple[int, int]
+    ) -> bool:
+        download = self.record_data[device_addr]
+        if download.total is None:
+            return False
+        offset, count = window
+        end = min(offset + count * RECORD_CHUNK_SIZE, download.total)
+        return all(
+            chunk in download.chunks
+            for chunk in range(offset, end, RECORD_CHUNK_SIZE)
+        )
+
+    def download_records(self) -> dict[str, RecordDownload]:
+        """Read back the data recorded by the ready devices.
+
+        A window of chunks is requested to all the devices before waiting,
+        so they all stream their data in parallel. The chunks still missing
+        are requested again in the next windows, a device is given up once
+        several windows in a row brought no new chunk.
+        """
+        devices = self.ready_devices
+        with self._condition:
+            self.record_data = {addr: RecordDownload() for addr in devices}
+        while True:
+            with self._condition:
+                windows = {
+                    addr: window
+                    for addr in devices
+                    if (window := self._record_window(addr)) is not None
+                }
+            if not windows:
+                break
+            with self._condition:
+                received = {
+                    addr: len(self.record_data[addr].chunks)
+                    for addr in windows
+                }
+            for addr, (offset, count) in windows.items():
+                payload = PayloadRecordReadRequest(offset=offset, count=count)
+                self.send_payload(int(addr, 16), payload)
+            self.wait_for_done(
+                RECORD_WINDOW_TIMEOUT,
+                lambda: all(
+                    self._record_window_received(addr, window)
+                    for addr, window in windows.items()
+                ),
+            )
+            with self._condition:
+                # Only give up on the devices that stopped sending chunks
+                for addr in windows:
+                    download = self.record_data[addr]
+                    if len(download.chunks) > received[addr]:
+                        download.retries = 0
+                    else:
+                        download.retries += 1
+        return self.record_data
+
+    def profile(self, clear: bool = False) -> dict[str, DeviceProfile]:
+        """Read the profile statistics of the ready and running devices.
+
+        The statistics are sent by the network core, whatever runs on the
+        application core. With clear, they are reset once sent, so a second
+        read only covers what happened in between. Devices missing some
+        entries are asked again, only the first attempt clears them.
+        """
+        devices = self.ready_devices + self.running_devices
+        with self._condition:
+            self.profile_data = {addr: DeviceProfile() for addr in devices}
+        for attempt in range(COMMAND_MAX_ATTEMPTS):
+            with self._condition:
+                missing = [
+                    addr
+                    for addr, profile in self.profile_data.items()
+                    if not profile.complete
+                ]
+            if not missing:
+                break
+            payload = PayloadProfileRequest(clear=int(clear and attempt == 0))
+            for addr in missing:
+                self.send_payload(int(addr, 16), payload)
+            self.wait_for_done(
+                PROFILE_TIMEOUT,
+                lambda: all(
+                    self.profile_data[addr].complete for addr in missing
+                ),
+            )
+        return self.profile_data
+
     def monitor(self):
         """Monitor the testbed."""
         self.logger.info("Monitoring testbed")
         while True:
-            time.sleep(0.01)
-
-    def _send_message(self, device_addr: int, message: str):
-        payload = PayloadMessage(
-            count=len(message),
-            message=message.encode(),
-        )
+            # Keep the network time of the devices from drifting apart
+            self.sync_time()
+            time.sleep(TIME_SYNC_PERIOD)
+
+    def record_messages(self):
+        """Record the next messages received from the user images.
+
+        The messages received before are forgotten.
+        """
+        with self._condition:
+            self.message_data = {}
+            self.messages_recorded = True
+
+    def clear_messages(self):
+        """Stop recording and forget the messages of the user images."""
+        with self._condition:
+            self.message_data = {}
+            self.messages_recorded = False
+
+    def _send_message(self, device_addr: int, message: str | bytes):
+        if isinstance(message, str):
+            message = message.encode()
+        payload = PayloadMessage(count=len(message), message=message)
         self.send_payload(device_addr, payload)
 
-    def send_message(self, message):
+    def send_message(self, message: str | bytes):
         """Send a message to the devices."""
-        running_devices = self.running_devices
-        if not self.settings.devices:
+        running_devices = set(self.running_devices)
+        if self.broadcast:
             self._send_message(BROADCAST_ADDRESS, message)
         else:
             for addr in self.settings.devices:
@@ -516,76 +1238,248 @@ class Controller:
                     continue
                 self._send_message(int(addr, 16), message)
 
-    def _send_start_ota(
-        self, device_addr: str, devices_to_flash: set[str], firmware: bytes
+    def _send_config(
+        self, key: ConfigKey, value: bytes, multicast: bool = True
+    ):
+        payload = PayloadConfigRequest(key=key, count=len(value), value=value)
+        for attempt in range(CONFIG_ATTEMPTS):
+            if attempt:
+                time.sleep(COMMAND_ATTEMPT_DELAY)
+            if not self.settings.devices:
+                self.send_payload(BROADCAST_ADDRESS, payload, multicast)
+                continue
+            for device_addr in self.settings.devices:
+                self.send_payload(int(device_addr, 16), payload)
+
+    def configure_status_policy(
+        self, heartbeat_ms: int, position_threshold: int, on_change: bool
     ):
+        """Configure when the devices send their status.
+
+        Status notifications are sent when the heartbeat expires (0 to
+        disable), when the position changes by more than the threshold
+        (1e-6 units, 0 to disable) or when the status changes.
+        """
+        value = (
+            heartbeat_ms.to_bytes(4, "little")
+            + position_threshold.to_bytes(4, "little")
+            + int(on_change).to_bytes(1, "little")
+        )
+        self._send_config(ConfigKey.StatusPolicy, value)
+
+    def configure_groups(self, groups: list[int]):
+        """Set the multicast groups the devices belong to."""
+        bitmap = 0
+        for group in groups:
+            bitmap |= 1 << group
+        # Devices outside the group would drop a multicast request
+        self._send_config(
+            ConfigKey.Groups, bitmap.to_bytes(4, "little"), multicast=False
+        )
+
+    def configure_network(self, network_id: int, schedule: MariSchedule):
+        """Set the Mari network ID and schedule of the devices.
+
+        The settings are stored in flash and applied right away by idle
+        devices, or when the running application stops.
+        """
+        value = network_id.to_bytes(2, "little") + bytes([schedule])
+        self._send_config(ConfigKey.Network, value)
+
+    def configure_calibration(self, homographies: dict[int, list[list[int]]]):
+        """Upload the LH2 homographies of the basestations to the devices.
+
+        Matrix elements are multiplied by 1e6. Homographies are stored in
+        flash by ready devices and used right away.
+        """
+        for basestation, matrix in sorted(homographies.items()):
+            value = bytes([basestation]) + b"".join(
+                element.to_bytes(4, "little", signed=True)
+                for row in matrix
+                for element in row
+            )
+            self._send_config(ConfigKey.Calibration, value)
+
+    def _start_ota_payload(self) -> Payload:
+        return PayloadOTAStartRequest(
+            fw_length=self.manifest.fw_length,
+            fw_chunk_count=self.chunk_table.count,
+            mode=(
+                OTAMode.Windowed
+                if self.settings.ota_window > 0
+                else OTAMode.StopAndWait
+            ),
+            chunk_size=self.start_ota_data.chunk_size,
+            compression=(
+                OTACompression.LZSS
+                if self.settings.ota_compress
+                else OTACompression.Disabled
+            ),
+            fw_hash=self.start_ota_data.fw_hash,
+            delta=int(bool(self.start_ota_data.pages_bitmap)),
+            pages_bitmap=(
+                self.start_ota_data.pages_bitmap
+                or bytes(OTA_PAGES_BITMAP_SIZE)
+            ),
+            session_id=self.start_ota_data.session_id,
+        )
+
+    def _send_start_ota(self, device_addr: str):
         def is_start_ota_acknowledged():
             if int(device_addr, 16) == BROADCAST_ADDRESS:
-                return sorted(self.start_ota_data.addrs) == sorted(
-                    devices_to_flash
-                )
+                return not self._pending_start_acks
             else:
-                return device_addr in self.start_ota_data.addrs
+                return device_addr not in self._pending_start_acks
 
-        payload = PayloadOTAStartRequest(
-            fw_length=len(firmware),
-            fw_chunk_count=len(self.chunks),
-        )
-        send_time = time.time()
-        send = True
+        payload = self._start_ota_payload()
         while (
             not is_start_ota_acknowledged()
             and self.start_ota_data.retries <= self.settings.ota_max_retries
         ):
-            if send is True:
-                self.send_payload(int(device_addr, 16), payload)
-                send_time = time.time()
-                self.start_ota_data.retries += 1
-            time.sleep(0.001)
-            send = time.time() - send_time > self.settings.ota_timeout
+            self.send_payload(int(device_addr, 16), payload)
+            self.start_ota_data.retries += 1
+            self.wait_for_done(
+                self.settings.ota_timeout, is_start_ota_acknowledged
+            )
 
-    def start_ota(self, firmware) -> StartOtaData:
-        """Start the OTA process."""
-        self.start_ota_data = StartOtaData()
-        self.chunks = []
-        digest = hashes.Hash(hashes.SHA256())
-        chunks_count = int(len(firmware) / CHUNK_SIZE) + int(
-            len(firmware) % CHUNK_SIZE != 0
+    def _prepare_chunks(self, chunk_size: int):
+        self.chunk_table = self.manifest.chunks(
+            chunk_size, self.settings.ota_compress
         )
-        for chunk_idx in range(chunks_count):
-            if chunk_idx == chunks_count - 1:
-                chunk_size = len(firmware) % CHUNK_SIZE
-            else:
-                chunk_size = CHUNK_SIZE
-            data = firmware[
-                chunk_idx * CHUNK_SIZE : chunk_idx * CHUNK_SIZE + chunk_size
-            ]
-            digest.update(data)
-            chunk_sha = hashes.Hash(hashes.SHA256())
-            chunk_sha.update(data)
-            self.chunks.append(
-                DataChunk(
-                    index=chunk_idx,
-                    size=chunk_size,
-                    sha=chunk_sha.finalize()[
-                        :8
-                    ],  # the first 8 bytes should be enough
-                    data=data,
+        self.start_ota_data.chunks = self.chunk_table.count
+        self.start_ota_data.chunk_size = chunk_size
+        if not self.start_ota_data.pages_bitmap:
+            return
+        # Must match the chunks considered unchanged by the bootloader
+        bitmap = self.start_ota_data.pages_bitmap
+        self.start_ota_data.unchanged_chunks = [
+            index
+            for index in range(self.chunk_table.count)
+            if not any(
+                bitmap[page >> 3] & (1 << (page & 0x07))
+                for page in range(
+                    index * chunk_size // OTA_PAGE_SIZE,
+                    ((index + 1) * chunk_size - 1) // OTA_PAGE_SIZE + 1,
                 )
             )
-        self.start_ota_data.fw_hash = digest.finalize()
-        self.start_ota_data.chunks = len(self.chunks)
-        devices_to_flash = self.ready_devices
-        if not self.settings.devices:
-            print("Broadcast start ota notification...")
-            self._send_start_ota(
-                addr_to_hex(BROADCAST_ADDRESS), devices_to_flash, firmware
+        ]
+
+    def _request_page_hashes(self, device_addr: str, pages_count: int):
+        """Request the hashes of the pages installed on a device."""
+        received = self.page_hashes.setdefault(device_addr, {})
+        for start in range(0, pages_count, OTA_PAGE_HASHES_MAX):
+            end = min(start + OTA_PAGE_HASHES_MAX, pages_count)
+            pages = range(start, end)
+            payload = PayloadOTAPageHashesRequest(
+                page=start, count=end - start
+            )
+            retries_count = 0
+            while (
+                not all(page in received for page in pages)
+                and retries_count <= self.settings.ota_max_retries
+            ):
+                self.send_payload(int(device_addr, 16), payload)
+                retries_count += 1
+                self.wait_for_done(
+                    self.settings.ota_timeout,
+                    lambda: all(page in received for page in pages),
+                )
+
+    def _changed_pages(self, devices: list[str]) -> bytes:
+        """Return the bitmap of the pages differing on at least one device."""
+        pages_count = self.manifest.pages_count
+        self.page_hashes = {}
+        for device_addr in devices:
+            self._request_page_hashes(device_addr, pages_count)
+        bitmap = bytearray(OTA_PAGES_BITMAP_SIZE)
+        for page in range(pages_count):
+            page_hash = self.manifest.page_hash(page)
+            if any(
+                self.page_hashes[device_addr].get(page) != page_hash
+                for device_addr in devices
+            ):
+                bitmap[page >> 3] |= 1 << (page & 0x07)
+        return bytes(bitmap)
+
+    def _send_start_ota_all(self, devices_to_flash: set[str]):
+        with self._condition:
+            self._pending_start_acks = set(devices_to_flash).difference(
+                self.start_ota_data.addrs
             )
+        if self.broadcast:
+            print("Broadcast start ota notification...")
+            self._send_start_ota(addr_to_hex(BROADCAST_ADDRESS))
         else:
             for addr in devices_to_flash:
                 print(f"Sending start ota notification to {addr}...")
-                self._send_start_ota(addr, devices_to_flash, firmware)
+                self._send_start_ota(addr)
                 time.sleep(0.2)
+
+    def start_ota(
+        self, firmware: bytes | OtaManifest, new_session: bool = False
+    ) -> StartOtaData:
+        """Start the OTA process.
+
+        The firmware is either an image or its OTA manifest, the OTA data of
+        an image is computed once and kept while the same image is flashed.
+        With new_session, the devices flash the image from scratch instead of
+        resuming a previous OTA of the same image.
+        """
+        if isinstance(firmware, OtaManifest):
+            self.manifest = firmware
+        elif self.manifest is None or self.manifest.image != firmware:
+            self.manifest = OtaManifest.from_image(firmware)
+        self.start_ota_data = StartOtaData()
+        self.start_ota_data.fw_hash = self.manifest.fw_hash
+        if new_session:
+            self.start_ota_data.session_id = random.randint(1, 0xFFFFFFFF)
+        with self._condition:
+            # Devices already holding the image notify it when started
+            self.verify_data = {}
+        # Devices verify the hash of the decompressed image once written
+        self.start_ota_data.compressed_size = len(
+            self.manifest.payload(self.settings.ota_compress)
+        )
+        devices_to_flash = self.ota_devices
+        if self.settings.ota_delta and not self.settings.ota_compress:
+            print("Reading installed images...")
+            self.start_ota_data.pages_bitmap = self._changed_pages(
+                devices_to_flash
+            )
+        # Devices with a smaller limit make the OTA restart with it
+        self._prepare_chunks(
+            min(
+                (
+                    OTA_CHUNK_SIZE_MAX
+                    if self.settings.group is None
+                    else OTA_MULTICAST_CHUNK_SIZE_MAX
+                ),
+                OTA_DEVICE_CHUNK_SIZE_MAX,
+            ),
+        )
+        self._send_start_ota_all(devices_to_flash)
+        chunk_size = self.start_ota_data.device_chunk_size
+        if (
+            self.start_ota_data.addrs
+            and chunk_size < self.start_ota_data.chunk_size
+        ):
+            # Restart with the largest chunk size supported by all devices
+            print(f"Restart ota with {chunk_size}B chunks...")
+            self._prepare_chunks(chunk_size)
+            self.start_ota_data.addrs = []
+            self.start_ota_data.written = {}
+            self.start_ota_data.retries = 0
+            self._send_start_ota_all(devices_to_flash)
+        # Unchanged chunks are reported as written by a new OTA too
+        unchanged_count = len(self.start_ota_data.unchanged_chunks)
+        resumed = [
+            addr
+            for addr in self.start_ota_data.addrs
+            if self.start_ota_data.written.get(addr, 0) > unchanged_count
+        ]
+        if resumed:
+            print(f"Resuming the transfer on {len(resumed)} devices...")
+            self._resume_transfer(resumed)
         return {
             "ota": self.start_ota_data,
             "acked": sorted(self.start_ota_data.addrs),
@@ -596,78 +1490,330 @@ class Controller:
             ),
         }
 
+    def _new_transfer_status(self) -> TransferDataStatus:
+        return TransferDataStatus(
+            acked=ChunkSet(self.chunk_table.count),
+            rtt=RttEstimator(rto=self.settings.ota_timeout),
+        )
+
+    def _session_key(self) -> tuple[str, int, bool]:
+        return (
+            self.start_ota_data.fw_hash.hex(),
+            self.start_ota_data.chunk_size,
+            self.settings.ota_compress,
+        )
+
+    def _load_session(self) -> dict[str, str]:
+        """Return the saved chunks acked by the devices, for this image."""
+        if self.settings.ota_session is None:
+            return {}
+        with OTA_SESSION_LOCK:
+            session = OtaSession.load(self.settings.ota_session)
+        key = (session.fw_hash, session.chunk_size, session.compressed)
+        return session.acked if key == self._session_key() else {}
+
+    def _save_session(self, force: bool = False):
+        """Save the chunks acked by the devices not flashed yet."""
+        path = self.settings.ota_session
+        if path is None or (
+            not force
+            and time.time() - self._session_saved_at < OTA_SESSION_SAVE_PERIOD
+        ):
+            return
+        self._session_saved_at = time.time()
+        with self._condition:
+            acked = {
+                addr: status.acked.to_bytes().hex()
+                for addr, status in self.transfer_data.items()
+                if not status.success
+            }
+        with OTA_SESSION_LOCK:
+            session = OtaSession.load(path)
+            key = (session.fw_hash, session.chunk_size, session.compressed)
+            if key != self._session_key():
+                session = OtaSession(*self._session_key())
+            for addr in self.transfer_data:
+                session.acked.pop(addr, None)
+            session.acked.update(acked)
+            if session.acked:
+                session.save(path)
+            elif os.path.exists(path):
+                os.remove(path)
+
+    def _resume_transfer(self, devices: list[str]):
+        """Restore the chunks written by the devices resuming a transfer.
+
+        The saved session gives them while a device reports the same number
+        of written chunks, else its bitmaps are read back, e.g. when it
+        rebooted and only kept the pages completely written.
+        """
+        count = self.chunk_table.count
+        saved = self._load_session()
+        to_read = []
+        for addr in devices:
+            written = self.start_ota_data.written[addr]
+            acked = None
+            if written >= count:
+                acked = ChunkSet.from_bytes(count, b"\xff" * count)
+            elif addr in saved:
+                acked = ChunkSet.from_bytes(count, bytes.fromhex(saved[addr]))
+            if acked is not None and len(acked) == written:
+                self.start_ota_data.resumed[addr] = acked
+            else:
+                to_read.append(addr)
+        if not to_read:
+            return
+        with self._condition:
+            self.transfer_data = {
+                addr: self._new_transfer_status() for addr in to_read
+            }
+            self._sent_at = {}
+        for device_addr in (
+            [addr_to_hex(BROADCAST_ADDRESS)] if self.broadcast else to_read
+        ):
+            self._request_bitmaps(range(count), device_addr, to_read)
+        with self._condition:
+            for addr, status in self.transfer_data.items():
+                self.start_ota_data.resumed[addr] = status.acked
+
+    def _initial_acked(self, unchanged: ChunkSet, device_addr: str):
+        """Return the chunks not sent to a device, unchanged or resumed."""
+        resumed = self.start_ota_data.resumed.get(device_addr)
+        return ChunkSet.union([unchanged] + ([resumed] if resumed else []))
+
+    def _unchanged_chunks(self) -> ChunkSet:
+        unchanged = ChunkSet(self.chunk_table.count)
+        for index in self.start_ota_data.unchanged_chunks:
+            unchanged.add(index)
+        return unchanged
+
+    def _chunk_payload(self, index: int) -> Payload:
+        table = self.chunk_table
+        if self.settings.ota_chunk_hash is False:
+            return PayloadOTARawChunkRequest(
+                index=index, count=table.size(index), chunk=table.chunk(index)
+            )
+        return PayloadOTAChunkRequest(
+            index=index,
+            count=table.size(index),
+            sha=table.sha(index),
+            chunk=table.chunk(index),
+        )
+
     def send_chunk(
         self,
-        chunk: DataChunk,
+        index: int,
         device_addr: str,
         devices_to_flash: set[str],
     ):
-        def is_chunk_acknowledged():
-            if int(device_addr, 16) == BROADCAST_ADDRESS:
-                return sorted(self.transfer_data.keys()) == sorted(
+        with self._condition:
+            pending = {
+                addr
+                for addr in (
                     devices_to_flash
-                ) and all(
-                    [
-                        status.chunks[chunk.index].acked
-                        for status in self.transfer_data.values()
-                    ]
+                    if int(device_addr, 16) == BROADCAST_ADDRESS
+                    else [device_addr]
                 )
+                if index not in self.transfer_data[addr].acked
+            }
+            self._pending_chunk_acks[index] = pending
+
+        def is_chunk_acknowledged():
+            if int(device_addr, 16) == BROADCAST_ADDRESS:
+                return not pending
             else:
-                return (
-                    device_addr in self.transfer_data.keys()
-                    and self.transfer_data[device_addr]
-                    .chunks[chunk.index]
-                    .acked
-                )
+                return device_addr not in pending
 
-        payload = PayloadOTAChunkRequest(
-            index=chunk.index,
-            count=chunk.size,
-            sha=chunk.sha,
-            chunk=chunk.data,
-        )
-        send_time = time.time()
-        send = True
+        payload = self._chunk_payload(index)
         retries_count = 0
         while (
             not is_chunk_acknowledged()
             and retries_count <= self.settings.ota_max_retries
         ):
-            if send is True:
-                if self.settings.verbose:
-                    missing_acks = [
-                        addr
-                        for addr in devices_to_flash
-                        if addr not in self.transfer_data
-                        or not self.transfer_data[addr]
-                        .chunks[chunk.index]
-                        .acked
+            if self.settings.verbose:
+                with self._condition:
+                    missing_acks = sorted(pending)
+                print(
+                    f"Transferring chunk {index}/{self.start_ota_data.chunks} to {device_addr} "
+                    f"- {retries_count} retries "
+                    f"- {len(missing_acks)} missing acks: {', '.join(missing_acks) if missing_acks else 'none'}"
+                )
+            with self._condition:
+                targets = set(pending)
+            timeout = self._rto(targets)
+            self._mark_sent(device_addr, index, retries_count > 0)
+            self.send_payload(int(device_addr, 16), payload)
+            if retries_count > 0:
+                for addr in targets:
+                    self.transfer_data[addr].retries += 1
+            retries_count += 1
+            if not self.wait_for_done(timeout, is_chunk_acknowledged):
+                with self._condition:
+                    self._backoff(targets & pending)
+        with self._condition:
+            self._pending_chunk_acks.pop(index, None)
+
+    def _send_window(
+        self, indexes: list[int], device_addr: str, retry: bool = False
+    ):
+        """Send a window of chunks without waiting for acknowledgments."""
+        for index in indexes:
+            payload = self._chunk_payload(index)
+            self.send_payload(int(device_addr, 16), payload)
+            if retry is False:
+                continue
+            if int(device_addr, 16) == BROADCAST_ADDRESS:
+                statuses = self.transfer_data.values()
+            else:
+                statuses = [self.transfer_data[device_addr]]
+            for status in statuses:
+                if index not in status.acked:
+                    status.retries += 1
+
+    def _request_bitmaps(
+        self,
+        indexes: list[int],
+        device_addr: str,
+        devices_to_flash: list[str],
+    ):
+        """Request the bitmaps covering the given chunks and wait for them."""
+        chunks_per_bitmap = OTA_CHUNK_BITMAP_SIZE * 8
+        targets = (
+            set(devices_to_flash)
+            if int(device_addr, 16) == BROADCAST_ADDRESS
+            else {device_addr}
+        )
+        for base in sorted({i - i % chunks_per_bitmap for i in indexes}):
+            self.bitmap_data[base] = set()
+            payload = PayloadOTAChunkBitmapRequest(index=base)
+            retries_count = 0
+            while (
+                not targets.issubset(self.bitmap_data[base])
+                and retries_count <= self.settings.ota_max_retries
+            ):
+                timeout = self._rto(targets)
+                self._mark_sent(
+                    device_addr, ("bitmap", base), retries_count > 0
+                )
+                self.send_payload(int(device_addr, 16), payload)
+                retries_count += 1
+                if not self.wait_for_done(
+                    timeout,
+                    lambda: targets.issubset(self.bitmap_data[base]),
+                ):
+                    with self._condition:
+                        self._backoff(targets - self.bitmap_data[base])
+
+    def _missing_chunks(self, device_addr: str) -> list[int]:
+        """Return the indexes of the chunks not acked yet by the device(s)."""
+        with self._condition:
+            if int(device_addr, 16) == BROADCAST_ADDRESS:
+                return ChunkSet.intersection(
+                    [status.acked for status in self.transfer_data.values()]
+                ).missing()
+            return self.transfer_data[device_addr].acked.missing()
+
+    def _transfer_windowed(
+        self, destinations: list[str], devices: list[str], progress=None
+    ):
+        """Stream the firmware in windows, then repair the missing chunks."""
+        window = min(self.settings.ota_window, OTA_WINDOW_MAX)
+        to_send = self._chunks_to_send()
+        for start in range(0, len(to_send), window):
+            indexes = to_send[start : start + window]
+            for device_addr in destinations:
+                pending = indexes
+                if int(device_addr, 16) != BROADCAST_ADDRESS:
+                    # Chunks written before a resumed transfer are skipped
+                    acked = self.transfer_data[device_addr].acked
+                    pending = [
+                        index for index in indexes if index not in acked
                     ]
+                if not pending:
+                    continue
+                self._send_window(pending, device_addr)
+                self._request_bitmaps(pending, device_addr, devices)
+            if progress is not None:
+                progress.update(
+                    sum(self.chunk_table.size(index) for index in indexes)
+                )
+            self._save_session()
+        for device_addr in destinations:
+            retries_count = 0
+            missing = self._missing_chunks(device_addr)
+            while missing and retries_count < self.settings.ota_max_retries:
+                if self.settings.verbose:
                     print(
-                        f"Transferring chunk {chunk.index}/{len(self.start_ota_data.chunks)} to {device_addr} "
-                        f"- {retries_count} retries "
-                        f"- {len(missing_acks)} missing acks: {', '.join(missing_acks) if missing_acks else 'none'}"
+                        f"Repairing {len(missing)} chunks on {device_addr} "
+                        f"- {retries_count} retries"
                     )
+                for start in range(0, len(missing), window):
+                    indexes = missing[start : start + window]
+                    self._send_window(indexes, device_addr, retry=True)
+                    self._request_bitmaps(indexes, device_addr, devices)
+                retries_count += 1
+                self._save_session()
+                missing = self._missing_chunks(device_addr)
+
+    def _wait_verify(self, destinations: list[str], devices: list[str]):
+        """Wait for the image verification results of the devices."""
+        # Devices send their result again when receiving the start request
+        # of the image they hold, in case the first notification was lost
+        if not self.chunk_table or not self.chunk_table.count:
+            return
+        payload = self._start_ota_payload()
+        for device_addr in destinations:
+            targets = (
+                set(devices)
+                if int(device_addr, 16) == BROADCAST_ADDRESS
+                else {device_addr}
+            )
+            retries_count = 0
+            while (
+                not self.wait_for_done(
+                    self._rto(targets),
+                    lambda: targets.issubset(self.verify_data),
+                )
+                and retries_count < self.settings.ota_max_retries
+            ):
                 self.send_payload(int(device_addr, 16), payload)
-                if int(device_addr, 16) == BROADCAST_ADDRESS:
-                    for addr in devices_to_flash:
-                        self.transfer_data[addr].chunks[
-                            chunk.index
-                        ].retries = retries_count
-                else:
-                    self.transfer_data[device_addr].chunks[
-                        chunk.index
-                    ].retries = retries_count
-                send_time = time.time()
                 retries_count += 1
-            time.sleep(0.001)
-            send = time.time() - send_time > self.settings.ota_timeout
-
-    def transfer(self, firmware, devices) -> dict[str, TransferDataStatus]:
-        """Transfer the firmware to the devices."""
-        data_size = len(firmware)
-        use_progress_bar = not self.settings.verbose
-        if use_progress_bar:
+
+    def _chunks_to_send(self) -> list[int]:
+        """Return the indexes of the chunks to send.
+
+        Unchanged chunks are skipped, as well as the chunks already written
+        by all the devices when they all resume a transfer.
+        """
+        unchanged = self._unchanged_chunks()
+        resumed = [
+            self.start_ota_data.resumed.get(addr)
+            for addr in self.start_ota_data.addrs
+        ]
+        if resumed and all(resumed):
+            unchanged = ChunkSet.union(
+                [unchanged, ChunkSet.intersection(resumed)]
+            )
+        return unchanged.missing()
+
+    def transfer_size(self) -> int:
+        """Return the number of bytes sent by a transfer."""
+        return sum(
+            self.chunk_table.size(index) for index in self._chunks_to_send()
+        )
+
+    def transfer(
+        self, devices, progress=None
+    ) -> dict[str, TransferDataStatus]:
+        """Transfer the firmware to the devices.
+
+        The chunks are those prepared by start_ota. The progress of the
+        transfer is reported to the given progress bar, or to a progress bar
+        owned by the transfer if none is given.
+        """
+        data_size = self.transfer_size()
+        own_progress_bar = progress is None and not self.settings.verbose
+        if own_progress_bar:
             progress = tqdm(
                 range(0, data_size),
                 unit="B",
@@ -678,32 +1824,58 @@ class Controller:
             progress.set_description(
                 f"Loading firmware ({int(data_size / 1024)}kB)"
             )
-        self.transfer_data = {}
+        transfer_data = {}
+        unchanged = self._unchanged_chunks()
         for device_addr in devices:
-            self.transfer_data[device_addr] = TransferDataStatus()
-            self.transfer_data[device_addr].chunks = [
-                Chunk(index=f"{i:03d}", size=f"{self.chunks[i].size:03d}B")
-                for i in range(len(self.chunks))
-            ]
-        for chunk in self.chunks:
-            if not self.settings.devices:
-                self.send_chunk(
-                    chunk,
-                    addr_to_hex(BROADCAST_ADDRESS),
-                    devices,
-                )
-            else:
-                for addr in devices:
-                    self.send_chunk(chunk, addr, devices)
-            if use_progress_bar:
-                progress.update(chunk.size)
-        if use_progress_bar:
+            transfer_data[device_addr] = self._new_transfer_status()
+            transfer_data[device_addr].acked = self._initial_acked(
+                unchanged, device_addr
+            )
+        with self._condition:
+            self.transfer_data = transfer_data
+            self._sent_at = {}
+            self._pending_chunk_acks = {}
+        if self.settings.ota_window > 0:
+            self._transfer_windowed(
+                (
+                    [addr_to_hex(BROADCAST_ADDRESS)]
+                    if self.broadcast
+                    else devices
+                ),
+                devices,
+                progress,
+            )
+        else:
+            for index in self._chunks_to_send():
+                if self.broadcast:
+                    self.send_chunk(
+                        index,
+                        addr_to_hex(BROADCAST_ADDRESS),
+                        devices,
+                    )
+                else:
+                    for addr in devices:
+                        self.send_chunk(index, addr, devices)
+                if progress is not None:
+                    progress.update(self.chunk_table.size(index))
+                self._save_session()
+        if own_progress_bar:
             progress.close()
+        self._wait_verify(
+            (
+                [addr_to_hex(BROADCAST_ADDRESS)]
+                if self.broadcast
+                else devices
+            ),
+            devices,
+        )
         for device in devices:
             device_data = self.transfer_data.get(device)
             if device_data:
-                device_data.success = all(
-                    chunk.acked for chunk in device_data.chunks
+                device_data.verified = self.verify_data.get(device, False)
+                device_data.success = (
+                    device_data.verified and device_data.acked.complete
                 )
                 self.transfer_data[device] = device_data
+        self._save_session(force=True)
         return self.transfer_data
@@ -0,0 +1,95 @@
+"""Rendering of the formatted log entries sent by the devices.
+
+Formatted entries only contain a format ID followed by 32-bit arguments.
+The format strings are stored in the .swarmit_log_fmt section of the user
+image and the format ID is the offset of the string in this section, so the
+host resolves them from the ELF file of the user image, or from a dictionary
+extracted from it at build time.
+"""
+
+import json
+import re
+import struct
+
+LOG_FORMAT_SECTION = ".swarmit_log_fmt"
+
+# Conversion specifiers supported by the devices, length modifiers are ignored
+_SPECIFIER_RE = re.compile(
+    r"%(?P<flags>[-+ 0#]*)(?P<width>\d*)(?:\.(?P<precision>\d+))?"
+    r"(?:hh|h|ll|l|z|j|t)?(?P<conversion>[diuxXoc%])"
+)
+
+
+def _elf_section(data: bytes, name: str) -> bytes:
+    """Return the content of a section of an ELF32 little endian file."""
+    if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+        raise ValueError("Not an ELF32 little endian file")
+    shoff = struct.unpack_from("<I", data, 0x20)[0]
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x2E)
+    sections = [
+        struct.unpack_from("<IIIIII", data, shoff + idx * shentsize)
+        for idx in range(shnum)
+    ]
+    strtab_offset = sections[shstrndx][4]
+    for sh_name, _, _, _, sh_offset, sh_size in sections:
+        start = strtab_offset + sh_name
+        if data[start : data.index(b"\x00", start)].decode() == name:
+            return data[sh_offset : sh_offset + sh_size]
+    raise ValueError(f"Section {name} not found")
+
+
+def formats_from_elf(data: bytes) -> dict[int, str]:
+    """Return the format strings of an ELF file, indexed by format ID."""
+    section = _elf_section(data, LOG_FORMAT_SECTION)
+    formats = {}
+    pos = 0
+    while pos < len(section):
+        # Strings can be separated by alignment padding
+        if section[pos] == 0:
+            pos += 1
+            continue
+        end = section.index(b"\x00", pos)
+        formats[pos] = section[pos:end].decode(errors="replace")
+        pos = end + 1
+    return formats
+
+
+def load_formats(path: str) -> dict[int, str]:
+    """Load the format strings from an ELF file or a JSON dictionary."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] == b"\x7fELF":
+        return formats_from_elf(data)
+    return {int(key): value for key, value in json.loads(data).items()}
+
+
+def save_formats(formats: dict[int, str], path: str):
+    """Save the format strings in a JSON dictionary."""
+    with open(path, "w") as f:
+        json.dump({str(key): value for key, value in formats.items()}, f)
+
+
+def render(formats: dict[int, str], data: bytes) -> str:
+    """Render a formatted log entry, unknown format IDs are kept as is."""
+    format_id = int.from_bytes(data[:2], "little")
+    args = list(struct.unpack_from(f"<{(len(data) - 2) // 4}I", data, 2))
+    if format_id not in formats:
+        return f"<unknown format {format_id}> {args}"
+    args.reverse()
+
+    def _convert(match: re.Match) -> str:
+        conversion = match.group("conversion")
+        if conversion == "%":
+            return "%"
+        value = args.pop() if args else 0
+        if conversion in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+        elif conversion == "c":
+            return chr(value & 0xFF)
+        spec = "%" + match.group("flags") + match.group("width")
+        if match.group("precision") is not None:
+            spec += "." + match.group("precision")
+        conversion = {"i": "d", "u": "d"}.get(conversion, conversion)
+        return (spec + conversion) % value
+
+    return _SPECIFIER_RE.sub(_convert, formats[format_id])
@@ -0,0 +1,273 @@
+"""Precomputed OTA data of a firmware image, shared by repeated flashing.
+
+A manifest holds a firmware image with all the data the controller derives
+from it before flashing: the hash of the image, the hashes of its flash pages
+compared in delta mode, the LZSS compressed image and the hashes of the chunks
+for the usual chunk sizes. It is generated once by `swarmit manifest` and
+memory mapped by the controller, the chunks are then sliced from the mapping
+when they are sent. Data missing from a manifest is computed on first use and
+kept for the next transfers.
+
+All integers are little endian, the file starts with a header followed by the
+chunk tables, the image, the compressed image, the page hashes and the chunk
+hashes of each table.
+"""
+
+import hashlib
+import mmap
+import struct
+import threading
+
+from testbed.swarmit.compress import compress
+from testbed.swarmit.protocol import OTA_PAGE_HASH_LENGTH, OTA_PAGE_SIZE
+
+MANIFEST_MAGIC = b"SWOM"
+MANIFEST_VERSION = 1
+MANIFEST_FLAG_COMPRESSED = 0x01
+# Magic, version, flags, tables count, image length and offset, compressed
+# image length and offset, page hashes offset and image hash
+MANIFEST_HEADER = struct.Struct("<4sBBHIIIII32s")
+# Chunk size, compressed, chunks count and chunk hashes offset
+MANIFEST_TABLE = struct.Struct("<HBxII")
+OTA_CHUNK_HASH_LENGTH = 8  # Truncated SHA256 hash of a chunk
+
+
+def _blocks_count(length: int, block_size: int) -> int:
+    return length // block_size + int(length % block_size != 0)
+
+
+def _section(data: memoryview, offset: int, length: int) -> memoryview:
+    if offset + length > len(data):
+        raise ValueError("Truncated OTA manifest")
+    return data[offset : offset + length]
+
+
+class ChunkTable:
+    """Chunks of an OTA payload, with their truncated hash."""
+
+    def __init__(self, data: memoryview, chunk_size: int, hashes: memoryview):
+        self.data = data
+        self.chunk_size = chunk_size
+        self.hashes = hashes
+        self.count = _blocks_count(len(data), chunk_size)
+
+    @classmethod
+    def compute(cls, data: memoryview, chunk_size: int) -> "ChunkTable":
+        """Return the chunks of the payload, hashing each of them."""
+        hashes = b"".join(
+            hashlib.sha256(data[start : start + chunk_size]).digest()[
+                :OTA_CHUNK_HASH_LENGTH
+            ]
+            for start in range(0, len(data), chunk_size)
+        )
+        return cls(data, chunk_size, memoryview(hashes))
+
+    def chunk(self, index: int) -> bytes:
+        """Return the data of a chunk."""
+        start = index * self.chunk_size
+        return bytes(self.data[start : start + self.chunk_size])
+
+    def size(self, index: int) -> int:
+        """Return the size of a chunk, the last one can be shorter."""
+        return min(self.chunk_size, len(self.data) - index * self.chunk_size)
+
+    def sha(self, index: int) -> bytes:
+        """Return the truncated hash of a chunk."""
+        start = index * OTA_CHUNK_HASH_LENGTH
+        return bytes(self.hashes[start : start + OTA_CHUNK_HASH_LENGTH])
+
+
+class OtaManifest:
+    """Firmware image with its precomputed OTA data."""
+
+    def __init__(
+        self,
+        image: bytes | memoryview,
+        fw_hash: bytes,
+        compressed: memoryview | None = None,
+        page_hashes: memoryview | None = None,
+        tables: dict[tuple[int, bool], ChunkTable] | None = None,
+    ):
+        self.image = memoryview(image)
+        self.fw_hash = bytes(fw_hash)
+        self._compressed = compressed
+        self._page_hashes = page_hashes
+        self._tables = tables or {}
+        # Shards of a multi controller share the manifest
+        self._lock = threading.RLock()
+
+    @classmethod
+    def from_image(cls, image: bytes) -> "OtaManifest":
+        """Return a manifest computing the OTA data of the image on use."""
+        image = bytes(image)
+        return cls(image, hashlib.sha256(image).digest())
+
+    @classmethod
+    def from_buffer(cls, data: memoryview) -> "OtaManifest":
+        """Return the manifest stored in the buffer, without copying it."""
+        if len(data) < MANIFEST_HEADER.size:
+            raise ValueError("Truncated OTA manifest")
+        (
+            magic,
+            version,
+            flags,
+            tables_count,
+            fw_length,
+            image_offset,
+            compressed_length,
+            compressed_offset,
+            page_hashes_offset,
+            fw_hash,
+        ) = MANIFEST_HEADER.unpack_from(data)
+        if magic != MANIFEST_MAGIC:
+            raise ValueError("Not an OTA manifest")
+        if version != MANIFEST_VERSION:
+            raise ValueError(f"Unsupported OTA manifest version {version}")
+        image = _section(data, image_offset, fw_length)
+        if hashlib.sha256(image).digest() != fw_hash:
+            raise ValueError("Corrupted OTA manifest image")
+        compressed = None
+        if flags & MANIFEST_FLAG_COMPRESSED:
+            compressed = _section(data, compressed_offset, compressed_length)
+        page_hashes = _section(
+            data,
+            page_hashes_offset,
+            _blocks_count(fw_length, OTA_PAGE_SIZE) * OTA_PAGE_HASH_LENGTH,
+        )
+        _section(
+            data, 0, MANIFEST_HEADER.size + tables_count * MANIFEST_TABLE.size
+        )
+        tables = {}
+        for table_index in range(tables_count):
+            chunk_size, is_compressed, count, offset = (
+                MANIFEST_TABLE.unpack_from(
+                    data,
+                    MANIFEST_HEADER.size + table_index * MANIFEST_TABLE.size,
+                )
+            )
+            payload = compressed if is_compressed else image
+            if (
+                payload is None
+                or chunk_size == 0
+                or count != _blocks_count(len(payload), chunk_size)
+            ):
+                raise ValueError("Invalid OTA manifest chunk table")
+            tables[(chunk_size, bool(is_compressed))] = ChunkTable(
+                payload,
+                chunk_size,
+                _section(data, offset, count * OTA_CHUNK_HASH_LENGTH),
+            )
+        return cls(image, fw_hash, compressed, page_hashes, tables)
+
+    @classmethod
+    def load(cls, path: str) -> "OtaManifest":
+        """Return the manifest stored in a file, memory mapped."""
+        with open(path, "rb") as manifest_file:
+            data = mmap.mmap(
+                manifest_file.fileno(), 0, access=mmap.ACCESS_READ
+            )
+        return cls.from_buffer(memoryview(data))
+
+    @staticmethod
+    def is_manifest(header: bytes) -> bool:
+        """Return whether the first bytes of a file are those of a manifest."""
+        return header[: len(MANIFEST_MAGIC)] == MANIFEST_MAGIC
+
+    @property
+    def fw_length(self) -> int:
+        return len(self.image)
+
+    @property
+    def pages_count(self) -> int:
+        return _blocks_count(self.fw_length, OTA_PAGE_SIZE)
+
+    def payload(self, compressed: bool = False) -> memoryview:
+        """Return the data sent to the devices."""
+        if not compressed:
+            return self.image
+        with self._lock:
+            if self._compressed is None:
+                self._compressed = memoryview(compress(bytes(self.image)))
+            return self._compressed
+
+    def page_hashes(self) -> memoryview:
+        """Return the truncated hashes of the flash pages of the image."""
+        with self._lock:
+            if self._page_hashes is None:
+                # The end of the last page is left erased by the bootloader
+                self._page_hashes = memoryview(
+                    b"".join(
+                        hashlib.sha256(
+                            bytes(
+                                self.image[start : start + OTA_PAGE_SIZE]
+                            ).ljust(OTA_PAGE_SIZE, b"\xff")
+                        ).digest()[:OTA_PAGE_HASH_LENGTH]
+                        for start in range(0, self.fw_length, OTA_PAGE_SIZE)
+                    )
+                )
+            return self._page_hashes
+
+    def page_hash(self, page: int) -> bytes:
+        """Return the truncated hash of a flash page, as hashed by devices."""
+        start = page * OTA_PAGE_HASH_LENGTH
+        return bytes(self.page_hashes()[start : start + OTA_PAGE_HASH_LENGTH])
+
+    def chunks(self, chunk_size: int, compressed: bool = False) -> ChunkTable:
+        """Return the chunks of the payload sent with the chunk size."""
+        with self._lock:
+            key = (chunk_size, compressed)
+            if key not in self._tables:
+                self._tables[key] = ChunkTable.compute(
+                    self.payload(compressed), chunk_size
+                )
+            return self._tables[key]
+
+    def to_bytes(self, chunk_sizes, compressed: bool = False) -> bytes:
+        """Return the manifest with the chunk tables of the chunk sizes."""
+        keys = [(chunk_size, False) for chunk_size in chunk_sizes]
+        if compressed:
+            keys += [(chunk_size, True) for chunk_size in chunk_sizes]
+        tables = [
+            (key, self.chunks(*key)) for key in dict.fromkeys(keys).keys()
+        ]
+        page_hashes = self.page_hashes()
+        compressed_data = self.payload(True) if compressed else b""
+        image_offset = MANIFEST_HEADER.size + len(tables) * MANIFEST_TABLE.size
+        compressed_offset = image_offset + self.fw_length
+        page_hashes_offset = compressed_offset + len(compressed_data)
+        offset = page_hashes_offset + len(page_hashes)
+        directory = []
+        for (chunk_size, is_compressed), table in tables:
+            directory.append(
+                MANIFEST_TABLE.pack(
+                    chunk_size, int(is_compressed), table.count, offset
+                )
+            )
+            offset += len(table.hashes)
+        header = MANIFEST_HEADER.pack(
+            MANIFEST_MAGIC,
+            MANIFEST_VERSION,
+            MANIFEST_FLAG_COMPRESSED if compressed else 0,
+            len(tables),
+            self.fw_length,
+            image_offset,
+            len(compressed_data),
+            compressed_offset,
+            page_hashes_offset,
+            self.fw_hash,
+        )
+        return b"".join(
+            [
+                header,
+                *directory,
+                self.image,
+                compressed_data,
+                page_hashes,
+                *(table.hashes for _, table in tables),
+            ]
+        )
+
+    def save(self, path: str, chunk_sizes, compressed: bool = False):
+        """Write the manifest with the chunk tables of the chunk sizes."""
+        with open(path, "wb") as manifest_file:
+            manifest_file.write(self.to_bytes(chunk_sizes, compressed))
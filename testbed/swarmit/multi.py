@@ -0,0 +1,288 @@
+"""Control a testbed spanning several gateways.
+
+Each gateway is driven by its own controller and the selected devices are
+sharded by the gateway they joined: a device belongs to the controller whose
+gateway relayed its status. Commands run on all the shards in parallel.
+"""
+
+import dataclasses
+import time
+from concurrent.futures import ThreadPoolExecutor, wait
+
+from rich.live import Live
+from tqdm import tqdm
+
+from testbed.swarmit.controller import (
+    STATUS_REFRESH_PERIOD,
+    TIME_SYNC_PERIOD,
+    Controller,
+    ControllerSettings,
+    DeviceProfile,
+    RecordDownload,
+    ResetLocation,
+    StartOtaData,
+    TransferDataStatus,
+)
+from testbed.swarmit.manifest import OtaManifest
+from testbed.swarmit.status import StatusStore, StatusView, status_rows
+
+
+class MultiController:
+    """Class used to control a swarm testbed through several gateways."""
+
+    def __init__(self, settings: list[ControllerSettings]):
+        self.settings = settings[0]
+        selected = set(self.settings.devices)
+        shards_settings = [
+            dataclasses.replace(
+                gateway_settings, devices=[], live_status=False
+            )
+            for gateway_settings in settings
+        ]
+        with ThreadPoolExecutor(max_workers=len(settings)) as executor:
+            controllers = list(executor.map(Controller, shards_settings))
+            # Discover the devices of each gateway
+            list(
+                executor.map(
+                    lambda controller: controller.known_devices, controllers
+                )
+            )
+        self.controllers: list[Controller] = []
+        for controller in controllers:
+            if not selected:
+                self.controllers.append(controller)
+                continue
+            shard = sorted(selected.intersection(controller.status_data))
+            if not shard:
+                controller.terminate()
+                continue
+            controller.settings.devices = shard
+            self.controllers.append(controller)
+
+    def _run(self, func: callable, devices=None, message=None) -> list:
+        """Run a function on all the shards in parallel.
+
+        The aggregated status of the given devices is displayed while the
+        function runs, if a message is given.
+        """
+        if not self.controllers:
+            return []
+        with ThreadPoolExecutor(max_workers=len(self.controllers)) as executor:
+            futures = [
+                executor.submit(func, controller)
+                for controller in self.controllers
+            ]
+            if message is not None:
+                view = StatusView(devices, message)
+                with Live(
+                    view.render(self.status_data, status_rows()),
+                    refresh_per_second=4,
+                ) as live:
+                    while wait(
+                        futures, timeout=STATUS_REFRESH_PERIOD
+                    ).not_done:
+                        live.update(
+                            view.render(self.status_data, status_rows())
+                        )
+                    live.update(view.render(self.status_data))
+            return [future.result() for future in futures]
+
+    @property
+    def status_data(self) -> StatusStore:
+        """Return the status of the devices of all the shards."""
+        return StatusStore.merge(
+            controller.status_snapshot() for controller in self.controllers
+        )
+
+    @property
+    def ready_devices(self) -> list[str]:
+        """Return the ready devices."""
+        return sorted(
+            addr
+            for controller in self.controllers
+            for addr in controller.ready_devices
+        )
+
+    @property
+    def ota_devices(self) -> list[str]:
+        """Return the devices to flash, including those left programming."""
+        return sorted(
+            addr
+            for controller in self.controllers
+            for addr in controller.ota_devices
+        )
+
+    @property
+    def running_devices(self) -> list[str]:
+        """Return the running devices."""
+        return sorted(
+            addr
+            for controller in self.controllers
+            for addr in controller.running_devices
+        )
+
+    @property
+    def resetting_devices(self) -> list[str]:
+        """Return the resetting devices."""
+        return sorted(
+            addr
+            for controller in self.controllers
+            for addr in controller.resetting_devices
+        )
+
+    def terminate(self):
+        """Terminate the controllers of all the shards."""
+        for controller in self.controllers:
+            controller.terminate()
+
+    def status(self):
+        """Request the status of the testbed."""
+        self._run(
+            lambda controller: controller.poll_status(),
+            self.settings.devices,
+            message="found",
+        )
+
+    def start(self, start_at: float | None = None):
+        """Start the application on all the shards."""
+        devices = self.ready_devices
+        self._run(
+            lambda controller: controller.start(start_at),
+            devices,
+            message="to start",
+        )
+
+    def stop(self):
+        """Stop the application on all the shards."""
+        devices = self.running_devices + self.resetting_devices
+        # Only scheduled starts are cancelled when no device is stoppable
+        self._run(
+            lambda controller: controller.stop(),
+            devices,
+            message="to stop" if devices else None,
+        )
+
+    def reset(self, locations: dict[str, ResetLocation]):
+        """Reset the application on all the shards."""
+        self._run(lambda controller: controller.reset(locations))
+
+    def reset_waypoints(self, plan: dict[str, list[ResetLocation]]):
+        """Reset the application on all the shards, following waypoints."""
+        self._run(lambda controller: controller.reset_waypoints(plan))
+
+    def download_records(self) -> dict[str, RecordDownload]:
+        """Read back the data recorded by the devices of all the shards."""
+        results = self._run(lambda controller: controller.download_records())
+        return {
+            addr: download
+            for result in results
+            for addr, download in result.items()
+        }
+
+    def profile(self, clear: bool = False) -> dict[str, DeviceProfile]:
+        """Read the profile statistics of the devices of all the shards."""
+        results = self._run(lambda controller: controller.profile(clear))
+        return {
+            addr: profile
+            for result in results
+            for addr, profile in result.items()
+        }
+
+    def monitor(self):
+        """Monitor the testbed."""
+        while True:
+            for controller in self.controllers:
+                controller.sync_time()
+            time.sleep(TIME_SYNC_PERIOD)
+
+    def send_message(self, message):
+        """Send a message to the devices of all the shards."""
+        self._run(lambda controller: controller.send_message(message))
+
+    def configure_status_policy(
+        self, heartbeat_ms: int, position_threshold: int, on_change: bool
+    ):
+        """Configure when the devices of all the shards send their status."""
+        self._run(
+            lambda controller: controller.configure_status_policy(
+                heartbeat_ms, position_threshold, on_change
+            )
+        )
+
+    def configure_groups(self, groups: list[int]):
+        """Set the multicast groups of the devices of all the shards."""
+        self._run(lambda controller: controller.configure_groups(groups))
+
+    def configure_network(self, network_id: int, schedule):
+        """Set the Mari network ID and schedule of all the shards."""
+        self._run(
+            lambda controller: controller.configure_network(
+                network_id, schedule
+            )
+        )
+
+    def configure_calibration(self, homographies: dict[int, list[list[int]]]):
+        """Upload the LH2 homographies to the devices of all the shards."""
+        self._run(
+            lambda controller: controller.configure_calibration(homographies)
+        )
+
+    def start_ota(self, firmware, new_session: bool = False) -> dict:
+        """Start the OTA process on all the shards.
+
+        The returned OTA data is the one of the first shard, chunk sizes are
+        negotiated independently by each shard. The OTA data of the image is
+        computed once for all the shards. With new_session, the devices flash
+        the image from scratch.
+        """
+        if not isinstance(firmware, OtaManifest):
+            firmware = OtaManifest.from_image(firmware)
+        results = self._run(
+            lambda controller: controller.start_ota(firmware, new_session)
+        )
+        if not results:
+            return {"ota": StartOtaData(), "acked": [], "missed": []}
+        return {
+            "ota": results[0]["ota"],
+            "acked": sorted(addr for r in results for addr in r["acked"]),
+            "missed": sorted(addr for r in results for addr in r["missed"]),
+        }
+
+    def transfer_size(self) -> int:
+        """Return the number of bytes sent by a transfer on all the shards."""
+        return sum(
+            controller.transfer_size() for controller in self.controllers
+        )
+
+    def transfer(self, devices) -> dict[str, TransferDataStatus]:
+        """Transfer the firmware to the devices of all the shards."""
+        data_size = self.transfer_size()
+        progress = None
+        if not self.settings.verbose:
+            progress = tqdm(
+                range(0, data_size),
+                unit="B",
+                unit_scale=False,
+                colour="green",
+                ncols=100,
+            )
+            progress.set_description(
+                f"Loading firmware on {len(self.controllers)} gateways "
+                f"({int(data_size / 1024)}kB)"
+            )
+
+        def shard_transfer(controller: Controller):
+            shard = controller.start_ota_data.addrs
+            shard_devices = [addr for addr in devices if addr in shard]
+            if not shard_devices:
+                return {}
+            return controller.transfer(shard_devices, progress)
+
+        results = self._run(shard_transfer)
+        if progress is not None:
+            progress.close()
+        return {
+            addr: status
+            for result in results
+            for addr, status in result.items()
+        }
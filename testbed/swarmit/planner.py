@@ -0,0 +1,161 @@
+"""Planning of the reset of several robots at once.
+
+Targets are assigned to the robots so the total travelled distance is
+minimal. With a Euclidean cost, the straight paths of such an assignment
+never cross: if 2 paths crossed, swapping their targets would be shorter.
+Paths passing too close to the target of another robot, which may already
+be parked there, are then bent with a detour waypoint.
+"""
+
+import math
+
+from testbed.swarmit.controller import ResetLocation
+
+RESET_CLEARANCE = 150_000  # Min distance in um between a path and a target
+RESET_WAYPOINTS_MAX = 8  # Max number of waypoints accepted by the devices
+
+
+def assign(costs: list[list[float]]) -> list[int]:
+    """Solve the assignment problem with the Hungarian algorithm.
+
+    costs[i][j] is the cost of assigning the column j to the row i, there
+    must be at least as many columns as rows. The returned list gives the
+    column assigned to each row.
+    """
+    rows = len(costs)
+    cols = len(costs[0]) if rows else 0
+    if rows > cols:
+        raise ValueError("Not enough columns to assign all the rows")
+    # Potentials and matching, 1-based with a virtual column 0
+    u = [0.0] * (rows + 1)
+    v = [0.0] * (cols + 1)
+    match = [0] * (cols + 1)
+    way = [0] * (cols + 1)
+    for row in range(1, rows + 1):
+        match[0] = row
+        col0 = 0
+        minv = [math.inf] * (cols + 1)
+        used = [False] * (cols + 1)
+        while True:
+            used[col0] = True
+            row0 = match[col0]
+            delta = math.inf
+            col1 = 0
+            for col in range(1, cols + 1):
+                if used[col]:
+                    continue
+                cur = costs[row0 - 1][col - 1] - u[row0] - v[col]
+                if cur < minv[col]:
+                    minv[col] = cur
+                    way[col] = col0
+                if minv[col] < delta:
+                    delta = minv[col]
+                    col1 = col
+            for col in range(cols + 1):
+                if used[col]:
+                    u[match[col]] += delta
+                    v[col] -= delta
+                else:
+                    minv[col] -= delta
+            col0 = col1
+            if match[col0] == 0:
+                break
+        # Update the matching along the augmenting path
+        while col0:
+            col1 = way[col0]
+            match[col0] = match[col1]
+            col0 = col1
+    result = [0] * rows
+    for col in range(1, cols + 1):
+        if match[col]:
+            result[match[col] - 1] = col - 1
+    return result
+
+
+def _distance(a: tuple[int, int], b: tuple[int, int]) -> float:
+    return math.hypot(a[0] - b[0], a[1] - b[1])
+
+
+def _closest_point(
+    start: tuple[int, int], end: tuple[int, int], point: tuple[int, int]
+) -> tuple[float, tuple[float, float]]:
+    """Return the ratio along the segment and the closest point to point."""
+    dx, dy = end[0] - start[0], end[1] - start[1]
+    length2 = dx * dx + dy * dy
+    if length2 == 0:
+        return 0.0, start
+    ratio = ((point[0] - start[0]) * dx + (point[1] - start[1]) * dy) / length2
+    ratio = min(max(ratio, 0.0), 1.0)
+    return ratio, (start[0] + ratio * dx, start[1] + ratio * dy)
+
+
+def _detour(
+    start: tuple[int, int],
+    end: tuple[int, int],
+    obstacles: list[tuple[int, int]],
+    clearance: int,
+) -> list[tuple[int, int]]:
+    """Return the waypoints going from start to end around the obstacles."""
+    for obstacle in obstacles:
+        ratio, closest = _closest_point(start, end, obstacle)
+        if ratio in (0.0, 1.0):
+            continue
+        distance = _distance(closest, obstacle)
+        if distance >= clearance:
+            continue
+        # Pass the obstacle on the side of the path it doesn't lie on
+        if distance:
+            nx = (closest[0] - obstacle[0]) / distance
+            ny = (closest[1] - obstacle[1]) / distance
+        else:
+            length = _distance(start, end)
+            nx = -(end[1] - start[1]) / length
+            ny = (end[0] - start[0]) / length
+        waypoint = (
+            max(0, round(obstacle[0] + nx * clearance)),
+            max(0, round(obstacle[1] + ny * clearance)),
+        )
+        others = [other for other in obstacles if other != obstacle]
+        return _detour(start, waypoint, others, clearance) + _detour(
+            waypoint, end, others, clearance
+        )
+    return [end]
+
+
+def plan_reset(
+    positions: dict[str, tuple[int, int]],
+    targets: list[ResetLocation],
+    clearance: int = RESET_CLEARANCE,
+) -> dict[str, list[ResetLocation]]:
+    """Assign the targets to the robots and compute their waypoints.
+
+    Positions and targets are in micrometers, the last waypoint of each
+    robot is its target. Robots are left in place if there are more robots
+    than targets.
+    """
+    addrs = sorted(positions)
+    goals = [(target.pos_x, target.pos_y) for target in targets]
+    if not goals:
+        return {}
+    if len(addrs) > len(goals):
+        # Only move the robots closest to the targets
+        addrs = sorted(
+            addrs,
+            key=lambda addr: min(_distance(positions[addr], g) for g in goals),
+        )[: len(goals)]
+    if not addrs:
+        return {}
+    costs = [[_distance(positions[addr], g) for g in goals] for addr in addrs]
+    assignment = assign(costs)
+    plan = {}
+    for addr, goal_index in zip(addrs, assignment):
+        goal = goals[goal_index]
+        obstacles = [
+            goals[other] for other in assignment if other != goal_index
+        ]
+        waypoints = _detour(positions[addr], goal, obstacles, clearance)
+        if len(waypoints) > RESET_WAYPOINTS_MAX:
+            # Keep the target if there are too many detours
+            waypoints = waypoints[: RESET_WAYPOINTS_MAX - 1] + [goal]
+        plan[addr] = [ResetLocation(pos_x=x, pos_y=y) for x, y in waypoints]
+    return plan
@@ -6,6 +6,49 @@ from enum import Enum, IntEnum
 
 from dotbot.protocol import Payload, PayloadFieldMetadata, register_parser
 
+OTA_CHUNK_BITMAP_SIZE = 32  # Bitmap size in bytes, 1 bit per chunk
+OTA_HASH_LENGTH = 32  # SHA256 hash of the whole image
+OTA_PAGE_SIZE = 4096  # Size of a flash page on the device
+OTA_PAGES_BITMAP_SIZE = 32  # Bitmap size in bytes, 1 bit per flash page
+OTA_PAGE_HASH_LENGTH = 8  # Truncated SHA256 hash of a flash page
+OTA_PAGE_HASHES_MAX = 16  # Max number of page hashes in a notification
+LOG_FORMAT_FLAG = 0x80  # Set in the length of formatted log entries
+GPIO_EVENT_SIZE = 7  # Timestamp, port, pin and value of a GPIO event
+RECORD_CHUNK_SIZE = 192  # Recorded data read back in a notification
+RECORD_WINDOW_MAX = 32  # Max number of chunks sent for a read request
+RECORD_HEADER_SIZE = 2  # Length of a record, records are padded to 4 bytes
+PROFILE_ENTRY_SIZE = 20  # Count, min, max and total cycles of a section
+PROFILE_APP_ENTRIES = 32  # Profiled sections of the application core
+PROFILE_NET_ENTRIES = 16  # Profiled request handlers of the network core
+# Profiled sections of the application core, in the order of profile_id_t
+PROFILE_APP_SECTIONS = [
+    "swarmit_keep_alive",
+    "swarmit_send_data_packet",
+    "swarmit_send_raw_data",
+    "swarmit_send_data_packet_nonblocking",
+    "swarmit_send_data_iov",
+    "swarmit_tx_stats",
+    "swarmit_ipc_isr",
+    "swarmit_ipc_isr_drain",
+    "swarmit_init_rng",
+    "swarmit_read_rng",
+    "swarmit_read_device_id",
+    "swarmit_get_time",
+    "swarmit_gpio_capture",
+    "swarmit_gpio_capture_flush",
+    "swarmit_log_data",
+    "swarmit_log_format",
+    "swarmit_record_append",
+    "swarmit_record_flush",
+    "swarmit_localization_process_data",
+    "swarmit_localization_get_position",
+    "swarmit_localization_handle_isr",
+    "swarmit_saadc_read",
+    "ipc_network_call",
+    "nvmc_write",
+    "nvmc_page_erase",
+]
+
 
 class StatusType(Enum):
     """Types of device status."""
@@ -26,6 +69,47 @@ class DeviceType(Enum):
     nRF5340DK = 3
 
 
+class OTAMode(IntEnum):
+    """OTA transfer modes."""
+
+    StopAndWait = 0
+    Windowed = 1
+
+
+class OTACompression(IntEnum):
+    """OTA image compression."""
+
+    Disabled = 0
+    LZSS = 1
+
+
+class ConfigKey(IntEnum):
+    """Settings configured with a config request."""
+
+    StatusPolicy = 0
+    Groups = 1
+    Network = 2
+    Calibration = 3
+
+
+class MariSchedule(IntEnum):
+    """Mari schedules available on the devices."""
+
+    Minuscule = 0
+    Tiny = 1
+    Small = 2
+    Huge = 3
+    OnlyBeacons = 4
+    OnlyBeaconsOptimizedScan = 5
+
+
+class ProfileCore(IntEnum):
+    """Cores of the profile statistics."""
+
+    App = 0
+    Net = 1
+
+
 class SwarmitPayloadType(IntEnum):
     """Types of DotBot payload types."""
 
@@ -36,6 +120,16 @@ class SwarmitPayloadType(IntEnum):
     SWARMIT_REQUEST_RESET = 0x83
     SWARMIT_REQUEST_OTA_START = 0x84
     SWARMIT_REQUEST_OTA_CHUNK = 0x85
+    SWARMIT_REQUEST_OTA_CHUNK_BITMAP = 0x86
+    SWARMIT_REQUEST_OTA_PAGE_HASHES = 0x87
+    SWARMIT_REQUEST_OTA_RAW_CHUNK = 0x88
+    SWARMIT_REQUEST_CONFIG = 0x89
+    SWARMIT_REQUEST_MULTICAST = 0x8A
+    SWARMIT_REQUEST_RESET_WAYPOINTS = 0x8B
+    SWARMIT_REQUEST_START_AT = 0x8C
+    SWARMIT_REQUEST_TIME_SYNC = 0x8D
+    SWARMIT_REQUEST_RECORD_READ = 0x8E
+    SWARMIT_REQUEST_PROFILE = 0x8F
 
     # Notifications
     SWARMIT_NOTIFICATION_STATUS = 0x90
@@ -43,6 +137,13 @@ class SwarmitPayloadType(IntEnum):
     SWARMIT_NOTIFICATION_OTA_CHUNK_ACK = 0x94
     SWARMIT_NOTIFICATION_EVENT_GPIO = 0x95
     SWARMIT_NOTIFICATION_EVENT_LOG = 0x96
+    SWARMIT_NOTIFICATION_OTA_CHUNK_BITMAP = 0x97
+    SWARMIT_NOTIFICATION_OTA_PAGE_HASHES = 0x98
+    SWARMIT_NOTIFICATION_OTA_VERIFY = 0x99
+    SWARMIT_NOTIFICATION_EVENT_LOG_BATCH = 0x9A
+    SWARMIT_NOTIFICATION_LINK_STATS = 0x9B
+    SWARMIT_NOTIFICATION_RECORD_DATA = 0x9C
+    SWARMIT_NOTIFICATION_PROFILE = 0x9D
 
     # Custom messages
     SWARMIT_MESSAGE = 0xA0
@@ -100,11 +201,37 @@ class PayloadOTAStartRequest(Payload):
             PayloadFieldMetadata(
                 name="fw_chunk_counts", disp="chunks", length=4
             ),
+            PayloadFieldMetadata(name="mode", disp="mode"),
+            PayloadFieldMetadata(name="chunk_size", disp="chunk size"),
+            PayloadFieldMetadata(name="compression", disp="comp."),
+            PayloadFieldMetadata(
+                name="fw_hash",
+                disp="hash",
+                type_=bytes,
+                length=OTA_HASH_LENGTH,
+            ),
+            PayloadFieldMetadata(name="delta", disp="delta"),
+            PayloadFieldMetadata(
+                name="pages_bitmap",
+                disp="pages",
+                type_=bytes,
+                length=OTA_PAGES_BITMAP_SIZE,
+            ),
+            PayloadFieldMetadata(name="session_id", disp="session", length=4),
         ]
     )
 
     fw_length: int = 0
     fw_chunk_count: int = 0
+    mode: int = OTAMode.StopAndWait
+    chunk_size: int = 0
+    compression: int = OTACompression.Disabled
+    fw_hash: bytes = dataclasses.field(default_factory=lambda: bytearray)
+    delta: int = 0
+    pages_bitmap: bytes = dataclasses.field(
+        default_factory=lambda: bytes(OTA_PAGES_BITMAP_SIZE)
+    )
+    session_id: int = 0  # OTA started with another ID are not resumed
 
 
 @dataclass
@@ -126,6 +253,171 @@ class PayloadOTAChunkRequest(Payload):
     chunk: bytes = dataclasses.field(default_factory=lambda: bytearray)
 
 
+@dataclass
+class PayloadOTARawChunkRequest(Payload):
+    """Dataclass that holds an OTA chunk packet without hash."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="index", disp="idx", length=4),
+            PayloadFieldMetadata(name="count", disp="size"),
+            PayloadFieldMetadata(name="chunk", type_=bytes, length=0),
+        ]
+    )
+
+    index: int = 0
+    count: int = 0
+    chunk: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+
+@dataclass
+class PayloadOTAChunkBitmapRequest(Payload):
+    """Dataclass that holds an OTA chunk bitmap request packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="index", disp="idx", length=4),
+        ]
+    )
+
+    index: int = 0
+
+
+@dataclass
+class PayloadOTAPageHashesRequest(Payload):
+    """Dataclass that holds an OTA page hashes request packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="page", disp="page", length=4),
+            PayloadFieldMetadata(name="count", disp="count"),
+        ]
+    )
+
+    page: int = 0
+    count: int = 0
+
+
+@dataclass
+class PayloadConfigRequest(Payload):
+    """Dataclass that holds a config request packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="key", disp="key"),
+            PayloadFieldMetadata(name="count", disp="len."),
+            PayloadFieldMetadata(
+                name="value", disp="value", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    key: int = 0
+    count: int = 0
+    value: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+
+@dataclass
+class PayloadMulticastRequest(Payload):
+    """Dataclass that holds a packet addressed to a group of devices."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="group", disp="group"),
+            PayloadFieldMetadata(name="count", disp="len."),
+            PayloadFieldMetadata(
+                name="packet", disp="packet", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    group: int = 0
+    count: int = 0
+    packet: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+
+@dataclass
+class PayloadResetWaypointsRequest(Payload):
+    """Dataclass that holds an application reset request with waypoints.
+
+    Waypoints are packed as consecutive 32-bit x and y coordinates.
+    """
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="count", disp="count"),
+            PayloadFieldMetadata(name="size", disp="size"),
+            PayloadFieldMetadata(
+                name="waypoints", disp="waypoints", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    count: int = 0
+    size: int = 0
+    waypoints: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+
+@dataclass
+class PayloadStartAtRequest(Payload):
+    """Dataclass that holds an application start request with a delay.
+
+    The delay starts at the reception of the request, retries carry the same
+    ID and the remaining delay.
+    """
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="id", disp="id"),
+            PayloadFieldMetadata(name="delay_us", disp="delay", length=4),
+        ]
+    )
+
+    id: int = 0
+    delay_us: int = 0
+
+
+@dataclass
+class PayloadTimeSyncRequest(Payload):
+    """Dataclass that holds a network time synchronization request."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="time_us", disp="time", length=8),
+        ]
+    )
+
+    time_us: int = 0
+
+
+@dataclass
+class PayloadRecordReadRequest(Payload):
+    """Dataclass that holds a recorded data read request."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="offset", disp="offset", length=4),
+            PayloadFieldMetadata(name="count", disp="count"),
+        ]
+    )
+
+    offset: int = 0
+    count: int = 0
+
+
+@dataclass
+class PayloadProfileRequest(Payload):
+    """Dataclass that holds a profile statistics request."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="clear", disp="clear"),
+        ]
+    )
+
+    clear: int = 0
+
+
 # Notifications
 
 
@@ -144,6 +436,8 @@ class PayloadStatusNotification(Payload):
             PayloadFieldMetadata(
                 name="pos_y", disp="pos y", length=4, signed=True
             ),
+            PayloadFieldMetadata(name="duty_cycle", disp="duty", length=2),
+            PayloadFieldMetadata(name="boot_time", disp="boot", length=4),
         ]
     )
 
@@ -152,6 +446,41 @@ class PayloadStatusNotification(Payload):
     battery: int = 0
     pos_x: int = 0
     pos_y: int = 0
+    duty_cycle: int = 0  # Active time of the application core in 1/100 %
+    boot_time: int = 0  # Time from reset to the start of the user image in us
+
+
+@dataclass
+class PayloadLinkStatsNotification(Payload):
+    """Dataclass that holds a radio link statistics notification packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="rx_packets", disp="rx", length=4),
+            PayloadFieldMetadata(name="rx_dropped", disp="drop", length=4),
+            PayloadFieldMetadata(name="tx_packets", disp="tx", length=4),
+            PayloadFieldMetadata(name="tx_deferred", disp="defer", length=4),
+            PayloadFieldMetadata(name="connections", disp="conn.", length=2),
+            PayloadFieldMetadata(
+                name="disconnections", disp="disc.", length=2
+            ),
+            PayloadFieldMetadata(name="disconnect_reason", disp="reason"),
+            PayloadFieldMetadata(name="rssi", disp="rssi", signed=True),
+            PayloadFieldMetadata(name="rssi_avg", disp="avg", signed=True),
+            PayloadFieldMetadata(name="tx_ring_max", disp="ring"),
+        ]
+    )
+
+    rx_packets: int = 0
+    rx_dropped: int = 0
+    tx_packets: int = 0
+    tx_deferred: int = 0
+    connections: int = 0
+    disconnections: int = 0
+    disconnect_reason: int = 0
+    rssi: int = 0
+    rssi_avg: int = 0
+    tx_ring_max: int = 0
 
 
 @dataclass
@@ -159,9 +488,15 @@ class PayloadOTAStartAckNotification(Payload):
     """Dataclass that holds an application OTA start ACK notification packet."""
 
     metadata: list[PayloadFieldMetadata] = dataclasses.field(
-        default_factory=lambda: []
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="chunk_size", disp="chunk size max"),
+            PayloadFieldMetadata(name="written", disp="written", length=4),
+        ]
     )
 
+    chunk_size: int = 0
+    written: int = 0  # chunks of the announced image already written
+
 
 @dataclass
 class PayloadOTAChunkAckNotification(Payload):
@@ -176,6 +511,78 @@ class PayloadOTAChunkAckNotification(Payload):
     index: int = 0
 
 
+@dataclass
+class PayloadOTAChunkBitmapNotification(Payload):
+    """Dataclass that holds an OTA chunk bitmap notification packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="index", disp="idx", length=4),
+            PayloadFieldMetadata(
+                name="bitmap",
+                disp="bitmap",
+                type_=bytes,
+                length=OTA_CHUNK_BITMAP_SIZE,
+            ),
+        ]
+    )
+
+    index: int = 0
+    bitmap: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+    def chunks(self) -> list[int]:
+        """Return the indexes of the chunks marked as written."""
+        return [
+            self.index + byte_idx * 8 + bit
+            for byte_idx, byte in enumerate(self.bitmap)
+            for bit in range(8)
+            if byte & (1 << bit)
+        ]
+
+
+@dataclass
+class PayloadOTAPageHashesNotification(Payload):
+    """Dataclass that holds an OTA page hashes notification packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="page", disp="page", length=4),
+            PayloadFieldMetadata(name="count", disp="count"),
+            PayloadFieldMetadata(name="size", disp="size"),
+            PayloadFieldMetadata(
+                name="hashes", disp="hashes", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    page: int = 0
+    count: int = 0
+    size: int = 0
+    hashes: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+    def page_hashes(self) -> dict[int, bytes]:
+        """Return the hash of each page, indexed by page."""
+        hashes = {}
+        for idx in range(self.count):
+            start = idx * OTA_PAGE_HASH_LENGTH
+            end = start + OTA_PAGE_HASH_LENGTH
+            hashes[self.page + idx] = bytes(self.hashes[start:end])
+        return hashes
+
+
+@dataclass
+class PayloadOTAVerifyNotification(Payload):
+    """Dataclass that holds an OTA image verification notification packet."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="valid", disp="valid"),
+        ]
+    )
+
+    valid: int = 0
+
+
 @dataclass
 class PayloadEventNotification(Payload):
     """Dataclass that holds an event notification packet."""
@@ -195,6 +602,189 @@ class PayloadEventNotification(Payload):
     data: bytes = dataclasses.field(default_factory=lambda: bytearray)
 
 
+@dataclass
+class PayloadEventBatchNotification(Payload):
+    """Dataclass that holds a batch of event notifications."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="count", disp="len."),
+            PayloadFieldMetadata(
+                name="data", disp="data", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    count: int = 0
+    data: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+    def events(self) -> list[PayloadEventNotification]:
+        """Return the events packed in the batch, in order."""
+        events = []
+        pos = 0
+        while pos + 5 <= len(self.data):
+            timestamp = int.from_bytes(self.data[pos : pos + 4], "little")
+            count = self.data[pos + 4]
+            size = count & ~LOG_FORMAT_FLAG
+            pos += 5
+            events.append(
+                PayloadEventNotification(
+                    timestamp=timestamp,
+                    count=count,
+                    data=bytes(self.data[pos : pos + size]),
+                )
+            )
+            pos += size
+        return events
+
+
+@dataclass
+class PayloadRecordDataNotification(Payload):
+    """Dataclass that holds a chunk of the data recorded by a device."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="total", disp="total", length=4),
+            PayloadFieldMetadata(name="offset", disp="offset", length=4),
+            PayloadFieldMetadata(name="size", disp="size"),
+            PayloadFieldMetadata(
+                name="data", disp="data", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    total: int = 0
+    offset: int = 0
+    size: int = 0
+    data: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+
+def parse_records(data: bytes) -> list[bytes]:
+    """Split the data recorded by a device into its records."""
+    records = []
+    pos = 0
+    while pos + RECORD_HEADER_SIZE <= len(data):
+        length = int.from_bytes(data[pos : pos + RECORD_HEADER_SIZE], "little")
+        start = pos + RECORD_HEADER_SIZE
+        if start + length > len(data):
+            break
+        records.append(bytes(data[start : start + length]))
+        pos = (start + length + 3) & ~0x03
+    return records
+
+
+@dataclass
+class GpioEvent:
+    """Edge of a GPIO captured by a device."""
+
+    timestamp: int
+    port: int
+    pin: int
+    value: int
+
+
+@dataclass
+class PayloadGpioEventNotification(Payload):
+    """Dataclass that holds a batch of GPIO event notifications."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="count", disp="count"),
+            PayloadFieldMetadata(name="size", disp="size"),
+            PayloadFieldMetadata(
+                name="data", disp="data", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    count: int = 0
+    size: int = 0
+    data: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+    def events(self) -> list[GpioEvent]:
+        """Return the events packed in the batch, in order."""
+        events = []
+        for idx in range(self.count):
+            pos = idx * GPIO_EVENT_SIZE
+            if pos + GPIO_EVENT_SIZE > len(self.data):
+                break
+            events.append(
+                GpioEvent(
+                    timestamp=int.from_bytes(
+                        self.data[pos : pos + 4], "little"
+                    ),
+                    port=self.data[pos + 4],
+                    pin=self.data[pos + 5],
+                    value=self.data[pos + 6],
+                )
+            )
+        return events
+
+
+@dataclass
+class ProfileEntry:
+    """Statistics of a profiled section, in cycles."""
+
+    count: int
+    min: int
+    max: int
+    total: int
+
+
+def profile_section_name(core: ProfileCore, index: int) -> str:
+    """Return the name of a profiled section."""
+    if core == ProfileCore.App:
+        if index < len(PROFILE_APP_SECTIONS):
+            return PROFILE_APP_SECTIONS[index]
+        return f"section {index}"
+    request_type = SwarmitPayloadType.SWARMIT_REQUEST_STATUS + index
+    try:
+        return SwarmitPayloadType(request_type).name
+    except ValueError:
+        return f"request 0x{request_type:02X}"
+
+
+@dataclass
+class PayloadProfileNotification(Payload):
+    """Dataclass that holds consecutive profile entries of a core."""
+
+    metadata: list[PayloadFieldMetadata] = dataclasses.field(
+        default_factory=lambda: [
+            PayloadFieldMetadata(name="core", disp="core"),
+            PayloadFieldMetadata(name="cpu_mhz", disp="cpu"),
+            PayloadFieldMetadata(name="index", disp="index"),
+            PayloadFieldMetadata(name="count", disp="count"),
+            PayloadFieldMetadata(name="size", disp="size"),
+            PayloadFieldMetadata(
+                name="data", disp="data", type_=bytes, length=0
+            ),
+        ]
+    )
+
+    core: int = 0
+    cpu_mhz: int = 0
+    index: int = 0
+    count: int = 0
+    size: int = 0
+    data: bytes = dataclasses.field(default_factory=lambda: bytearray)
+
+    def entries(self) -> dict[int, ProfileEntry]:
+        """Return the entries packed in the notification, by index."""
+        entries = {}
+        for idx in range(self.count):
+            pos = idx * PROFILE_ENTRY_SIZE
+            if pos + PROFILE_ENTRY_SIZE > len(self.data):
+                break
+            entry = self.data[pos : pos + PROFILE_ENTRY_SIZE]
+            entries[self.index + idx] = ProfileEntry(
+                count=int.from_bytes(entry[0:4], "little"),
+                min=int.from_bytes(entry[4:8], "little"),
+                max=int.from_bytes(entry[8:12], "little"),
+                total=int.from_bytes(entry[12:20], "little"),
+            )
+        return entries
+
+
 @dataclass
 class PayloadMessage(Payload):
     """Dataclass that holds a message packet."""
@@ -233,6 +823,41 @@ def register_parsers():
     register_parser(
         SwarmitPayloadType.SWARMIT_REQUEST_OTA_CHUNK, PayloadOTAChunkRequest
     )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_OTA_RAW_CHUNK,
+        PayloadOTARawChunkRequest,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_OTA_CHUNK_BITMAP,
+        PayloadOTAChunkBitmapRequest,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_OTA_PAGE_HASHES,
+        PayloadOTAPageHashesRequest,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_CONFIG, PayloadConfigRequest
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_MULTICAST, PayloadMulticastRequest
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_RESET_WAYPOINTS,
+        PayloadResetWaypointsRequest,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_START_AT, PayloadStartAtRequest
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_TIME_SYNC, PayloadTimeSyncRequest
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_RECORD_READ,
+        PayloadRecordReadRequest,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_REQUEST_PROFILE, PayloadProfileRequest
+    )
     register_parser(
         SwarmitPayloadType.SWARMIT_NOTIFICATION_STATUS,
         PayloadStatusNotification,
@@ -245,8 +870,40 @@ def register_parsers():
         SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_CHUNK_ACK,
         PayloadOTAChunkAckNotification,
     )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_CHUNK_BITMAP,
+        PayloadOTAChunkBitmapNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_PAGE_HASHES,
+        PayloadOTAPageHashesNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_OTA_VERIFY,
+        PayloadOTAVerifyNotification,
+    )
     register_parser(
         SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG,
         PayloadEventNotification,
     )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_GPIO,
+        PayloadGpioEventNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_EVENT_LOG_BATCH,
+        PayloadEventBatchNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_RECORD_DATA,
+        PayloadRecordDataNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_LINK_STATS,
+        PayloadLinkStatsNotification,
+    )
+    register_parser(
+        SwarmitPayloadType.SWARMIT_NOTIFICATION_PROFILE,
+        PayloadProfileNotification,
+    )
     register_parser(SwarmitPayloadType.SWARMIT_MESSAGE, PayloadMessage)
@@ -0,0 +1,338 @@
+"""Simulation of swarmit devices, to test the controller without robots.
+
+Each simulated device runs the bootloader and the network core firmware built
+for the host with `make host` (see device/host). Both cores run their own
+sources, talking through the IPC peripheral and the shared RAM like on the
+nRF5340, only Mari, the flash and the robot drivers are replaced. The devices
+are reached through SimulatorAdapter, which replaces the Mari gateway: frames
+are serialized and parsed like on the radio, delayed, rate limited and
+randomly lost. Thousands of devices can be simulated to measure how the
+controller scales.
+"""
+
+import ctypes
+import heapq
+import itertools
+import os
+import random
+import threading
+import time
+from dataclasses import dataclass
+
+from dotbot.protocol import (
+    Packet,
+    Payload,
+    ProtocolPayloadParserException,
+)
+from rich import print
+
+from testbed.swarmit.adapter import GatewayAdapterBase
+from testbed.swarmit.protocol import StatusType
+
+BROADCAST_ADDRESS = 0xFFFFFFFFFFFFFFFF  # Same as the controller
+SIM_LIBRARY_PATH = os.path.join(
+    os.path.dirname(__file__),
+    "..",
+    "..",
+    "device",
+    "host",
+    "swarmit-host.so",
+)
+SIM_FRAME_SIZE_MAX = 255  # HOST_FRAME_SIZE_MAX
+SIM_NEVER = 0xFFFFFFFFFFFFFFFF  # HOST_NEVER
+SIM_FLASH_ADDRESS = 0x10000  # Flash address of the user image
+SIM_RSSI = -60  # RSSI of all received frames, in dBm
+
+# Calls to the firmware are serialized, the devices of all the adapters share
+# the globals of the host build
+_lock = threading.RLock()
+_library = None
+
+
+def _load_library(verbose: bool) -> ctypes.CDLL:
+    """Load the host build of the firmware, once for the process."""
+    global _library
+    if _library is None:
+        if not os.path.exists(SIM_LIBRARY_PATH):
+            raise RuntimeError(
+                f"{os.path.normpath(SIM_LIBRARY_PATH)} not found, "
+                "build it with `make host`"
+            )
+        library = ctypes.CDLL(SIM_LIBRARY_PATH)
+        swarm, node = ctypes.c_void_p, ctypes.c_void_p
+        u8, u64 = ctypes.c_uint8, ctypes.c_uint64
+        signatures = {
+            "host_init": (ctypes.c_bool, [ctypes.c_bool]),
+            "host_swarm_create": (swarm, []),
+            "host_swarm_destroy": (None, [swarm]),
+            "host_swarm_run": (u64, [swarm, u64]),
+            "host_swarm_transmit": (
+                ctypes.c_size_t,
+                [swarm, ctypes.POINTER(u64), ctypes.c_char_p],
+            ),
+            "host_node_create": (
+                node,
+                [swarm, u64, u64, ctypes.c_int32, ctypes.c_int32],
+            ),
+            "host_node_destroy": (None, [node]),
+            "host_node_reboot": (None, [node, u64]),
+            "host_node_receive": (
+                None,
+                [node, u64, ctypes.c_char_p, ctypes.c_size_t, ctypes.c_int8],
+            ),
+            "host_node_status": (u8, [node]),
+            "host_node_record": (
+                ctypes.c_bool,
+                [node, u64, ctypes.c_char_p, u8],
+            ),
+            "host_node_flash_read": (
+                ctypes.c_bool,
+                [node, ctypes.c_uint32, ctypes.c_char_p, ctypes.c_size_t],
+            ),
+        }
+        for name, (restype, argtypes) in signatures.items():
+            function = getattr(library, name)
+            function.restype = restype
+            function.argtypes = argtypes
+        _library = library
+    if not _library.host_init(verbose):
+        raise RuntimeError("the flash addresses of the firmware are in use")
+    return _library
+
+
+@dataclass
+class SimulatorSettings:
+    """Class that holds the simulated network settings."""
+
+    devices: int = 100
+    network_id: int = 1  # devices addresses are derived from the network ID
+    latency: float = 0.005  # one way, in seconds
+    loss: float = 0.0  # probability that a frame is lost, in both directions
+    frame_rate: float = 0  # frames relayed per second in each direction
+    seed: int | None = None
+
+
+@dataclass
+class SimulatedHeader:
+    """Class that holds the header of a frame, like the Mari header."""
+
+    source: int
+    destination: int
+
+
+class SimulatedDevice:
+    """Class that gives access to a device of the host build."""
+
+    def __init__(self, address: int, adapter: "SimulatorAdapter"):
+        self.address = address
+        self.adapter = adapter
+        with _lock:
+            self._node = adapter.library.host_node_create(
+                adapter.swarm, address, adapter.now_us(), 0, 0
+            )
+        if not self._node:
+            raise RuntimeError(f"cannot map the memory of device {address:X}")
+
+    @property
+    def status(self) -> StatusType:
+        """Status published by the network core."""
+        with _lock:
+            status = self.adapter.library.host_node_status(self._node)
+        return StatusType(status)
+
+    def receive(self, data: bytes):
+        """Deliver a frame to the radio of the device."""
+        with _lock:
+            self.adapter.library.host_node_receive(
+                self._node, self.adapter.now_us(), data, len(data), SIM_RSSI
+            )
+            self.adapter.sync()
+
+    def record(self, data: bytes) -> bool:
+        """Record data from the user image, False if it doesn't run."""
+        with _lock:
+            recorded = self.adapter.library.host_node_record(
+                self._node, self.adapter.now_us(), data, len(data)
+            )
+            self.adapter.sync()
+        return recorded
+
+    def reboot(self):
+        """Power cycle the device, the flash content is kept."""
+        with _lock:
+            self.adapter.library.host_node_reboot(
+                self._node, self.adapter.now_us()
+            )
+            self.adapter.sync()
+
+    def read_flash(self, offset: int, length: int) -> bytes:
+        """Read the flash, from the start of the user image."""
+        buffer = ctypes.create_string_buffer(length)
+        with _lock:
+            if not self.adapter.library.host_node_flash_read(
+                self._node, SIM_FLASH_ADDRESS + offset, buffer, length
+            ):
+                raise ValueError("range not in the simulated flash")
+        return buffer.raw
+
+    def destroy(self):
+        with _lock:
+            self.adapter.library.host_node_destroy(self._node)
+
+
+class SimulatorAdapter(GatewayAdapterBase):
+    """Class used to reach simulated devices instead of a gateway.
+
+    The devices and frames are handled by a single thread, frames are
+    delivered in order of their arrival time. The devices run when they
+    receive a frame and when their timers expire, the other calls to the
+    firmware are made with the lock held.
+    """
+
+    def __init__(self, settings: SimulatorSettings, verbose: bool = False):
+        self.settings = settings
+        self.verbose = verbose
+        self.random = random.Random(settings.seed)
+        self.library = _load_library(verbose)
+        self.frames_sent = 0  # from the controller, a broadcast counts once
+        self.frames_received = 0  # by the controller
+        self._epoch = time.time()
+        self._events: list[tuple[float, int, callable]] = []
+        self._sequence = itertools.count()
+        self._wakeup_at = SIM_NEVER  # next deadline of the swarm, in us
+        self._downlink_free_at = 0.0
+        self._uplink_free_at = 0.0
+        self._condition = threading.Condition()
+        self._running = False
+        self._thread = threading.Thread(target=self._run, daemon=True)
+        with _lock:
+            self.swarm = self.library.host_swarm_create()
+            base = (settings.network_id & 0xFFFF) << 16
+            self.devices = {}
+            for idx in range(settings.devices):
+                address = base + idx + 1
+                self.devices[address] = SimulatedDevice(address, self)
+
+    def now_us(self) -> int:
+        """Return the time of the devices, in us."""
+        return int((time.time() - self._epoch) * 1e6)
+
+    def schedule(self, delay: float, callback: callable):
+        """Call the callback from the simulation thread after a delay."""
+        with self._condition:
+            heapq.heappush(
+                self._events,
+                (time.time() + delay, next(self._sequence), callback),
+            )
+            self._condition.notify()
+
+    def sync(self):
+        """Send the frames of the devices and wait for their next deadline."""
+        with _lock:
+            source = ctypes.c_uint64()
+            buffer = ctypes.create_string_buffer(SIM_FRAME_SIZE_MAX)
+            while length := self.library.host_swarm_transmit(
+                self.swarm, ctypes.byref(source), buffer
+            ):
+                self.uplink(source.value, buffer.raw[:length])
+            deadline = self.library.host_swarm_run(self.swarm, self.now_us())
+            if deadline >= self._wakeup_at:
+                return
+            self._wakeup_at = deadline
+        if deadline != SIM_NEVER:
+            delay = max(0.0, deadline / 1e6 - (time.time() - self._epoch))
+            self.schedule(delay, lambda: self._wakeup(deadline))
+
+    def _wakeup(self, deadline: int):
+        with _lock:
+            if self._wakeup_at != deadline:
+                # Superseded by an earlier deadline
+                return
+            self._wakeup_at = SIM_NEVER
+            self.sync()
+
+    def _frame_time(self, free_at: float) -> tuple[float, float]:
+        """Return the delivery delay of a frame and when the link is free."""
+        now = time.time()
+        if not self.settings.frame_rate:
+            return self.settings.latency, free_at
+        start = max(now, free_at)
+        free_at = start + 1 / self.settings.frame_rate
+        return start - now + self.settings.latency, free_at
+
+    def _lost(self) -> bool:
+        return self.random.random() < self.settings.loss
+
+    def uplink(self, source: int, data: bytes):
+        """Send a frame of a device to the controller."""
+        if self._lost():
+            return
+        delay, self._uplink_free_at = self._frame_time(self._uplink_free_at)
+
+        def deliver():
+            self.frames_received += 1
+            try:
+                packet = Packet.from_bytes(data)
+            except (ValueError, ProtocolPayloadParserException) as exc:
+                print(f"[red]Error parsing packet: {exc}[/]")
+                return
+            header = SimulatedHeader(source=source, destination=0)
+            self.on_frame_received(header, packet)
+
+        self.schedule(delay, deliver)
+
+    def _run(self):
+        while True:
+            with self._condition:
+                while self._running and (
+                    not self._events or self._events[0][0] > time.time()
+                ):
+                    timeout = (
+                        self._events[0][0] - time.time()
+                        if self._events
+                        else None
+                    )
+                    self._condition.wait(timeout)
+                if not self._running:
+                    return
+                _, _, callback = heapq.heappop(self._events)
+            callback()
+
+    def init(self, on_frame_received: callable):
+        self.on_frame_received = on_frame_received
+        self._running = True
+        self._thread.start()
+        # Frames sent while booting are delivered once the controller listens
+        self.sync()
+
+    def close(self):
+        with self._condition:
+            self._running = False
+            self._condition.notify()
+        if self._thread.is_alive():
+            self._thread.join()
+        with _lock:
+            for device in self.devices.values():
+                device.destroy()
+            self.library.host_swarm_destroy(self.swarm)
+            self.devices = {}
+
+    def send_payload(self, destination: int, payload: Payload):
+        data = Packet.from_payload(payload).to_bytes()
+        self.frames_sent += 1
+        if destination == BROADCAST_ADDRESS:
+            targets = list(self.devices.values())
+        elif destination in self.devices:
+            targets = [self.devices[destination]]
+        else:
+            return
+        delay, self._downlink_free_at = self._frame_time(
+            self._downlink_free_at
+        )
+
+        def deliver():
+            for device in targets:
+                if not self._lost():
+                    device.receive(data)
+
+        self.schedule(delay, deliver)
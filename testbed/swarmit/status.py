@@ -0,0 +1,232 @@
+"""Status of the devices, indexed for large swarms.
+
+The status of each device is replaced by a new NodeStatus when a
+notification is received, they are never modified in place. The store keeps
+the addresses of the devices in each state up to date, so the devices in a
+state are selected without scanning the whole swarm, and the status view only
+formats the rows of the devices whose status was replaced.
+"""
+
+import dataclasses
+import time
+from collections.abc import Iterable, MutableMapping
+from dataclasses import dataclass
+
+from rich import get_console
+from rich.console import Group
+from rich.table import Table
+from rich.text import Text
+
+from testbed.swarmit.protocol import (
+    DeviceType,
+    PayloadLinkStatsNotification,
+    StatusType,
+)
+
+# Lines of the status view around the device rows: header, borders and footer
+STATUS_VIEW_MARGIN = 9
+
+
+@dataclass
+class NodeStatus:
+    """Class that holds node status."""
+
+    device: DeviceType = DeviceType.Unknown
+    status: StatusType = StatusType.Bootloader
+    battery: int = 0
+    pos_x: int = 0
+    pos_y: int = 0
+    duty_cycle: int = 0  # Active time of the application core in 1/100 %
+    boot_time: int = 0  # Time from reset to the start of the user image in us
+    last_seen: float = 0.0  # Status notifications can be sparse
+    link: PayloadLinkStatsNotification | None = None
+
+
+class StatusStore(MutableMapping):
+    """Class that holds the status of the devices, by address."""
+
+    def __init__(self, nodes: dict[str, NodeStatus] | None = None):
+        self._nodes: dict[str, NodeStatus] = {}
+        self._by_status: dict[StatusType, set[str]] = {
+            status: set() for status in StatusType
+        }
+        for addr, node in (nodes or {}).items():
+            self[addr] = node
+
+    def __getitem__(self, addr: str) -> NodeStatus:
+        return self._nodes[addr]
+
+    def __setitem__(self, addr: str, node: NodeStatus):
+        previous = self._nodes.get(addr)
+        if previous is not None and previous.status != node.status:
+            self._by_status[previous.status].discard(addr)
+        self._by_status[node.status].add(addr)
+        self._nodes[addr] = node
+
+    def __delitem__(self, addr: str):
+        node = self._nodes.pop(addr)
+        self._by_status[node.status].discard(addr)
+
+    def __iter__(self):
+        return iter(self._nodes)
+
+    def __len__(self) -> int:
+        return len(self._nodes)
+
+    def __contains__(self, addr) -> bool:
+        return addr in self._nodes
+
+    def set_link(self, addr: str, link: PayloadLinkStatsNotification):
+        """Attach the link statistics to the status of a device."""
+        self._nodes[addr] = dataclasses.replace(self._nodes[addr], link=link)
+
+    def devices(self, *statuses: StatusType) -> set[str]:
+        """Return the addresses of the devices in one of the states."""
+        if len(statuses) == 1:
+            return set(self._by_status[statuses[0]])
+        return set().union(*(self._by_status[status] for status in statuses))
+
+    def all_in(self, devices: set[str], *statuses: StatusType) -> bool:
+        """Return whether all the given devices are in one of the states."""
+        remaining = set(devices)
+        for status in statuses:
+            remaining.difference_update(self._by_status[status])
+        return not remaining
+
+    def count(self, status: StatusType, devices: set[str] | None = None):
+        """Return the number of devices in a state, among the given ones."""
+        if devices is None:
+            return len(self._by_status[status])
+        return len(self._by_status[status].intersection(devices))
+
+    def copy(self) -> "StatusStore":
+        """Return a copy sharing the immutable status of the devices."""
+        store = StatusStore()
+        store._nodes = dict(self._nodes)
+        store._by_status = {
+            status: set(addrs) for status, addrs in self._by_status.items()
+        }
+        return store
+
+    @classmethod
+    def merge(cls, stores: Iterable["StatusStore"]) -> "StatusStore":
+        """Return the status of the devices of several stores."""
+        merged = cls()
+        for store in stores:
+            merged._nodes.update(store._nodes)
+            for status, addrs in store._by_status.items():
+                merged._by_status[status] |= addrs
+        return merged
+
+
+def battery_level_color(level: int):
+    if level > 85:
+        return "green"
+    elif level > 65:
+        return "dark_orange"
+    else:
+        return "red"
+
+
+class StatusView:
+    """Class that renders the status table of a selection of devices.
+
+    The rows are formatted again only when the status of their device was
+    replaced or when their last seen time changed, the order of the rows is
+    kept while no device is added.
+    """
+
+    def __init__(self, devices=[], status_message="found"):
+        self.devices = set(devices or [])
+        self.status_message = status_message
+        self._rows: dict[str, tuple[NodeStatus, int, tuple]] = {}
+        self._order: list[str] = []
+
+    def _row(self, addr: str, node: NodeStatus, now: float) -> tuple:
+        age = int(now - node.last_seen + 0.5)
+        cached = self._rows.get(addr)
+        if cached is not None and cached[0] is node and cached[1] == age:
+            return cached[2]
+        link = node.link
+        row = (
+            f"{addr}",
+            f"{node.device.name}",
+            f"[{battery_level_color(node.battery)}]{node.battery:>3}%",
+            f"({(node.pos_x / 1e6):.2f}, {(node.pos_y / 1e6):.2f})",
+            f"{'[bold cyan]' if node.status == StatusType.Running else '[bold green]'}{node.status.name}",
+            f"{age}s ago",
+            f"{node.duty_cycle / 100:.2f}%",
+            (f"{node.boot_time / 1000:.1f}ms" if node.boot_time else "-"),
+            f"{link.rssi_avg}dBm" if link else "-",
+            (
+                f"{link.rx_packets}/{link.rx_dropped}/{link.tx_packets}"
+                if link
+                else "-"
+            ),
+            f"{link.disconnections}" if link else "-",
+        )
+        self._rows[addr] = (node, age, row)
+        return row
+
+    def _table(self) -> Table:
+        table = Table()
+        table.add_column("Device Addr", style="magenta", no_wrap=True)
+        table.add_column("Type", style="cyan", justify="center")
+        table.add_column("Battery", style="cyan", justify="right")
+        table.add_column("Position", style="cyan", justify="right")
+        table.add_column(
+            "Status",
+            style="green",
+            justify="center",
+            width=max([len(m) for m in StatusType.__members__]),
+        )
+        table.add_column("Last seen", style="cyan", justify="right")
+        table.add_column("Duty", style="cyan", justify="right")
+        table.add_column("Boot", style="cyan", justify="right")
+        table.add_column("RSSI", style="cyan", justify="right")
+        table.add_column("Rx/Drop/Tx", style="cyan", justify="right")
+        table.add_column("Disc.", style="cyan", justify="right")
+        return table
+
+    def render(self, status_data: StatusStore, max_rows: int | None = None):
+        """Return the status table, with at most max_rows devices."""
+        # Devices are never removed, the order changes when one is added
+        selection = (
+            [addr for addr in self.devices if addr in status_data]
+            if self.devices
+            else status_data.keys()
+        )
+        if len(self._order) != len(selection):
+            self._order = sorted(selection)
+        if not self._order:
+            return Group(Text(f"\nNo device {self.status_message}\n"))
+
+        total = len(self._order)
+        header = Text(
+            f"\n{total} device{'s' if total > 1 else ''} "
+            f"{self.status_message}\n"
+        )
+        table = self._table()
+        now = time.time()
+        shown = self._order if max_rows is None else self._order[:max_rows]
+        for addr in shown:
+            table.add_row(*self._row(addr, status_data[addr], now))
+        if len(shown) < total:
+            table.add_row(f"... {total - len(shown)} more")
+        devices = self.devices or None
+        counts = {
+            status: status_data.count(status, devices) for status in StatusType
+        }
+        footer = Text(
+            ", ".join(
+                f"{count} {status.name}"
+                for status, count in counts.items()
+                if count
+            )
+        )
+        return Group(header, table, footer)
+
+
+def status_rows() -> int:
+    """Return the number of device rows fitting in the terminal."""
+    return max(1, get_console().height - STATUS_VIEW_MARGIN)